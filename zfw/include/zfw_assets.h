@@ -13,34 +13,26 @@
     "layout (location = 0) in vec2 a_vert;\n" \
     "layout (location = 1) in vec2 a_pos;\n" \
     "layout (location = 2) in vec2 a_size;\n" \
-    "layout (location = 3) in float a_rot;\n" \
+    "layout (location = 3) in vec2 a_rot_cos_sin;\n" \
     "layout (location = 4) in float a_tex_index;\n" \
-    "layout (location = 5) in vec2 a_tex_coord;\n" \
+    "layout (location = 5) in vec4 a_tex_coords;\n" \
     "layout (location = 6) in vec4 a_blend;\n" \
     "\n" \
     "out flat int v_tex_index;\n" \
     "out vec2 v_tex_coord;\n" \
     "out vec4 v_blend;\n" \
     "\n" \
-    "uniform mat4 u_view;\n" \
-    "uniform mat4 u_proj;\n" \
+    "uniform mat4 u_view_proj;\n" \
     "\n" \
     "void main()\n" \
     "{\n" \
-    "    float rot_cos = cos(a_rot);\n" \
-    "    float rot_sin = -sin(a_rot);\n" \
-    "\n" \
-    "    mat4 model = mat4(\n" \
-    "        vec4(a_size.x * rot_cos, a_size.x * rot_sin, 0.0f, 0.0f),\n" \
-    "        vec4(a_size.y * -rot_sin, a_size.y * rot_cos, 0.0f, 0.0f),\n" \
-    "        vec4(0.0f, 0.0f, 1.0f, 0.0f),\n" \
-    "        vec4(a_pos.x, a_pos.y, 0.0f, 1.0f)\n" \
-    "    );\n" \
+    "    vec2 corner = a_vert * a_size;\n" \
+    "    vec2 pos = a_pos + vec2((corner.x * a_rot_cos_sin.x) + (corner.y * a_rot_cos_sin.y), (corner.y * a_rot_cos_sin.x) - (corner.x * a_rot_cos_sin.y));\n" \
     "\n" \
-    "    gl_Position = u_proj * u_view * model * vec4(a_vert, 0.0f, 1.0f);\n" \
+    "    gl_Position = u_view_proj * vec4(pos, 0.0f, 1.0f);\n" \
     "\n" \
     "    v_tex_index = int(a_tex_index);\n" \
-    "    v_tex_coord = a_tex_coord;\n" \
+    "    v_tex_coord = mix(a_tex_coords.xy, a_tex_coords.zw, a_vert);\n" \
     "    v_blend = a_blend;\n" \
     "}\n"
 
@@ -61,56 +53,97 @@
     "    o_frag_color = tex_color * v_blend;\n" \
     "}\n"
 
+// Used in place of the above when user textures are loaded into a single texture array, in which case the texture index
+// is the array layer.
+#define ZFW_BUILTIN_SPRITE_QUAD_TEX_ARRAY_FRAG_SHADER_SRC \
+    "#version 430 core\n" \
+    "\n" \
+    "in flat int v_tex_index;\n" \
+    "in vec2 v_tex_coord;\n" \
+    "in vec4 v_blend;\n" \
+    "\n" \
+    "out vec4 o_frag_color;\n" \
+    "\n" \
+    "uniform sampler2DArray u_tex_array;\n" \
+    "\n" \
+    "void main()\n" \
+    "{\n" \
+    "    vec4 tex_color = texture(u_tex_array, vec3(v_tex_coord, v_tex_index));\n" \
+    "    o_frag_color = tex_color * v_blend;\n" \
+    "}\n"
+
 #define ZFW_BUILTIN_CHAR_QUAD_VERT_SHADER_SRC \
     "#version 430 core\n" \
     "\n" \
     "layout (location = 0) in vec2 a_vert;\n" \
-    "layout (location = 1) in vec2 a_tex_coord;\n" \
+    "layout (location = 1) in vec2 a_pos;\n" \
+    "layout (location = 2) in vec2 a_size;\n" \
+    "layout (location = 3) in vec4 a_tex_coords;\n" \
+    "layout (location = 4) in vec4 a_blend;\n" \
     "\n" \
     "out vec2 v_tex_coord;\n" \
+    "out vec4 v_blend;\n" \
     "\n" \
-    "uniform vec2 u_pos;\n" \
-    "uniform vec2 u_scale;\n" \
     "uniform mat4 u_proj;\n" \
     "\n" \
     "void main()\n" \
     "{\n" \
-    "    mat4 model = mat4(\n" \
-    "        vec4(u_scale.x, 0.0f, 0.0f, 0.0f),\n" \
-    "        vec4(0.0f, u_scale.y, 0.0f, 0.0f),\n" \
-    "        vec4(0.0f, 0.0f, 1.0f, 0.0f),\n" \
-    "        vec4(u_pos.x, u_pos.y, 0.0f, 1.0f)\n" \
-    "    );\n" \
-    "    gl_Position = u_proj * model * vec4(a_vert, 0.0f, 1.0f);\n" \
-    "\n" \
-    "    v_tex_coord = a_tex_coord;\n" \
+    "    gl_Position = u_proj * vec4(a_pos + (a_vert * a_size), 0.0f, 1.0f);\n" \
+    "\n" \
+    "    v_tex_coord = mix(a_tex_coords.xy, a_tex_coords.zw, a_vert);\n" \
+    "    v_blend = a_blend;\n" \
     "}\n"
 
 #define ZFW_BUILTIN_CHAR_QUAD_FRAG_SHADER_SRC \
     "#version 430 core\n" \
     "\n" \
     "in vec2 v_tex_coord;\n" \
+    "in vec4 v_blend;\n" \
     "\n" \
     "out vec4 o_frag_color;\n" \
     "\n" \
-    "uniform vec4 u_blend;\n" \
     "uniform sampler2D u_tex;\n" \
     "\n" \
     "void main()\n" \
     "{\n" \
     "    vec4 tex_color = texture(u_tex, v_tex_coord);\n" \
-    "    o_frag_color = tex_color * u_blend;\n" \
+    "    o_frag_color = tex_color * v_blend;\n" \
     "}\n"
 
-#define ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT 14
-#define ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT 4
+// Used in place of the above for signed distance field fonts, whose texture alpha is the distance to the glyph edge
+// (with the edge at one half). The edge is smoothed over about a pixel on screen, so glyphs stay sharp at any scale.
+#define ZFW_BUILTIN_CHAR_QUAD_SDF_FRAG_SHADER_SRC \
+    "#version 430 core\n" \
+    "\n" \
+    "in vec2 v_tex_coord;\n" \
+    "in vec4 v_blend;\n" \
+    "\n" \
+    "out vec4 o_frag_color;\n" \
+    "\n" \
+    "uniform sampler2D u_tex;\n" \
+    "\n" \
+    "void main()\n" \
+    "{\n" \
+    "    vec4 tex_color = texture(u_tex, v_tex_coord);\n" \
+    "    float edge_w = fwidth(tex_color.a) * 0.5f;\n" \
+    "    float alpha = smoothstep(0.5f - edge_w, 0.5f + edge_w, tex_color.a);\n" \
+    "    o_frag_color = vec4(tex_color.rgb, alpha) * v_blend;\n" \
+    "}\n"
 
 typedef struct
 {
     int tex_count;
 
-    GLuint *gl_ids;
+    GLuint *gl_ids; // NULL if the textures were loaded into the texture array.
     zfw_vec_2d_i_t *sizes;
+
+    GLuint array_gl_id; // 0 unless the textures were loaded as layers of a single texture array.
+    zfw_vec_2d_i_t array_size; // The size of each layer of the texture array, that of the largest texture.
+
+    // Atlas textures are packed into atlas pages, which are loaded as ordinary textures following the standalone ones.
+    int atlas_tex_count;
+    int *atlas_tex_user_tex_indexes; // The texture index of the page containing each atlas texture.
+    zfw_rect_t *atlas_tex_src_rects; // The rectangle each atlas texture occupies within its page.
 } zfw_user_tex_data_t;
 
 typedef struct
@@ -119,12 +152,25 @@ typedef struct
     GLuint *gl_ids;
 } zfw_user_shader_prog_data_t;
 
+typedef struct
+{
+    int font_index;
+    unsigned int codepoint;
+    int char_index; // -1 if the entry is empty.
+} zfw_font_char_lookup_entry_t;
+
 typedef struct
 {
     int font_count;
 
     int *line_heights;
 
+    // The characters of all fonts, with those of each font together and sorted by codepoint.
+    int *chars_begin_indexes;
+    int *char_counts;
+
+    unsigned int *chars_codepoints;
+
     font_char_hor_offs_t *chars_hor_offsets;
     font_char_vert_offs_t *chars_vert_offsets;
 
@@ -132,19 +178,64 @@ typedef struct
 
     font_char_src_rect_t *chars_src_rects;
 
-    font_char_kerning_t *chars_kernings;
+    // The kerning pairs of all fonts, with those of each font together and sorted by key.
+    int *kerning_pairs_begin_indexes;
+    int *kerning_pair_counts;
+    font_char_kerning_pair_t *kerning_pairs;
+
+    zfw_font_char_lookup_entry_t *char_lookup_entries; // A hash table from font index and codepoint to character index.
+    int char_lookup_cap; // Always a power of two.
 
     zfw_vec_2d_i_t *tex_sizes;
+    zfw_bool_t *sdfs; // Whether each font texture holds signed distance fields rather than coverage.
     GLuint *tex_gl_ids;
 } zfw_user_font_data_t;
 
+// A read-only view of the assets file mapped into memory. User asset data points into it, so it must stay mapped for as
+// long as that data is in use.
+typedef struct
+{
+    const unsigned char *data;
+    long size;
+
+    // The table of contents of the file, which has been validated against the size of the file.
+    const zfw_assets_file_entry_t *entries;
+    int entry_count;
+
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+} zfw_assets_file_mapping_t;
+
 typedef struct
 {
     GLuint sprite_quad_prog_gl_id;
     GLuint char_quad_prog_gl_id;
+    GLuint char_quad_sdf_prog_gl_id;
 } zfw_builtin_shader_prog_data_t;
 
+inline int zfw_get_atlas_tex_user_tex_index(const int atlas_tex_index, const zfw_user_tex_data_t *const tex_data)
+{
+    return tex_data->atlas_tex_user_tex_indexes[atlas_tex_index];
+}
+
+// Returns the source rectangle within the atlas page corresponding to one within the atlas texture.
+inline zfw_rect_t zfw_get_atlas_tex_src_rect(const int atlas_tex_index, const zfw_rect_t *const src_rect, const zfw_user_tex_data_t *const tex_data)
+{
+    const zfw_rect_t *const atlas_tex_src_rect = &tex_data->atlas_tex_src_rects[atlas_tex_index];
+
+    zfw_rect_t page_src_rect;
+    zfw_init_rect(&page_src_rect, atlas_tex_src_rect->x + src_rect->x, atlas_tex_src_rect->y + src_rect->y, src_rect->width, src_rect->height);
+    return page_src_rect;
+}
+
 void zfw_gen_shader_prog(GLuint *const shader_prog_gl_id, const char *const vert_shader_src, const char *const frag_shader_src);
-zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *const tex_data, zfw_user_shader_prog_data_t *const shader_prog_data, zfw_user_font_data_t *const font_data, FILE *const assets_file_fs, zfw_mem_arena_t *const main_mem_arena);
+zfw_bool_t zfw_map_assets_file(zfw_assets_file_mapping_t *const mapping, const char *const file_path);
+void zfw_unmap_assets_file(zfw_assets_file_mapping_t *const mapping);
+const zfw_assets_file_entry_t *zfw_find_assets_file_entry(const zfw_assets_file_mapping_t *const mapping, const zfw_asset_type_t type, const unsigned int name_hash);
+zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *const tex_data, zfw_user_shader_prog_data_t *const shader_prog_data, zfw_user_font_data_t *const font_data, const zfw_assets_file_mapping_t *const assets_file_mapping, const zfw_bool_t tex_array, zfw_mem_arena_t *const main_mem_arena);
+int zfw_find_font_char_index(const zfw_user_font_data_t *const font_data, const int font_index, const unsigned int codepoint);
+int zfw_get_font_chars_kerning(const zfw_user_font_data_t *const font_data, const int font_index, const int left_char_index, const int right_char_index);
 
 #endif
@@ -7,8 +7,10 @@
 #include "zfw_input.h"
 #include "zfw_assets.h"
 #include "zfw_rendering.h"
+#include "zfw_profiling.h"
 
 #define ZFW_MAIN_MEM_ARENA_SIZE ((1 << 20) * 10)
+#define ZFW_DEFAULT_TICKS_PER_SEC 60
 
 // Core game data to be provided to the user in their defined functions.
 typedef struct
@@ -18,6 +20,8 @@ typedef struct
     zfw_vec_2d_i_t window_size;
     zfw_bool_t *window_fullscreen;
 
+    double tick_interval; // The fixed time in seconds that each tick represents.
+
     const zfw_input_state_t *input_state;
     const zfw_input_state_t *input_state_last;
 
@@ -25,14 +29,21 @@ typedef struct
     const zfw_user_shader_prog_data_t *user_shader_prog_data;
     const zfw_user_font_data_t *user_font_data;
 
+    const zfw_render_context_t *render_context;
+
     zfw_sprite_batch_group_t *sprite_batch_groups;
     zfw_char_batch_group_t *char_batch_group;
+    zfw_sprite_queue_t *sprite_queue; // Sprites submitted here are rendered until the queue is next reset, which is before each tick, or before each render if the user has defined a render function.
     zfw_view_state_t *view_state;
+
+    const zfw_profiler_t *profiler; // The results of the last complete frame are in its last frame member.
 } zfw_user_func_data_t;
 
 typedef void (*zfw_on_game_init_user_func_t)(void *const, zfw_user_func_data_t *const);
 typedef void (*zfw_on_game_tick_user_func_t)(void *const, zfw_user_func_data_t *const, const int, const double);
+typedef void (*zfw_on_game_render_user_func_t)(void *const, zfw_user_func_data_t *const, const float);
 typedef void (*zfw_on_window_resize_user_func_t)(void *const, zfw_user_func_data_t *const);
+typedef void (*zfw_on_headless_frame_user_func_t)(void *const, const unsigned char *const, const zfw_vec_2d_i_t);
 
 // Key game information to be defined by the user and used when the game runs.
 typedef struct
@@ -44,9 +55,28 @@ typedef struct
 
     zfw_bool_t hide_cursor;
 
+    int ticks_per_sec; // The fixed rate at which ticks are run, or 0 for ZFW_DEFAULT_TICKS_PER_SEC.
+    int frame_rate_cap; // The most frames to render per second, or 0 to render every time the main loop comes around (as limited by vsync, if on).
+    zfw_bool_t disable_vsync;
+
+    zfw_bool_t tex_array; // Whether to load user textures as layers of a single texture array (padded to the size of the largest), so that any number of textures can be drawn in a single sprite batch. This falls back to separate textures if the device limits are exceeded or the padding would waste too much memory. In this mode, source rectangles must lie within their textures, as parts outside show the padding rather than wrapping.
+
+    zfw_bool_t profiling; // Whether to record CPU scope and GPU layer timings each frame. Render counters are recorded regardless.
+    zfw_bool_t profiler_overlay; // Whether to draw the profiler overlay. This only applies when profiling.
+    int profiler_overlay_user_font_index; // The user font to draw the profiler overlay in.
+
+    zfw_bool_t headless; // Whether to run without ever showing the window, rendering to an offscreen target of the initial window size instead. Where GLFW supports it, no display is needed at all.
+    zfw_bool_t headless_unthrottled; // Whether headless ticks should run back-to-back as fast as possible rather than in real time. Each tick still represents a fixed interval.
+    int headless_tick_limit; // The number of ticks to run before exiting when headless, or 0 for no limit.
+
+    const char *render_capture_file_name; // If not NULL, the calls feeding the renderer are recorded to this file for the first render_capture_frame_count frames, to be replayed by zfw_render_bench.
+    int render_capture_frame_count;
+
     zfw_on_game_init_user_func_t on_init_func;
     zfw_on_game_tick_user_func_t on_tick_func;
+    zfw_on_game_render_user_func_t on_render_func; // Optional. This is run before each rendered frame and given how far (from 0 to 1) the game is between the last tick and the next, for interpolating what's drawn.
     zfw_on_window_resize_user_func_t on_window_resize_func;
+    zfw_on_headless_frame_user_func_t on_headless_frame_func; // If set when headless, this is given the RGBA pixels (rows bottom to top) and size of each rendered frame. Reading frames back stalls on the GPU, so leave it unset unless frames are needed.
 
     void *user_ptr; // The user can have this point to whatever they want (e.g. a struct containing persistent game state data).
 } zfw_user_game_run_info_t;
@@ -0,0 +1,70 @@
+#ifndef __ZFW_PROFILING_H__
+#define __ZFW_PROFILING_H__
+
+#include <glad/glad.h>
+#include <zfw_common_misc.h>
+#include <zfw_common_mem.h>
+
+typedef unsigned long long zfw_profiler_gpu_timer_bits_t;
+
+#define ZFW_PROFILER_GPU_TIMER_LIMIT ZFW_SIZE_IN_BITS(zfw_profiler_gpu_timer_bits_t)
+#define ZFW_PROFILER_GPU_QUERY_FRAME_COUNT 4 // The number of frames of GPU timer queries kept in flight, so that results can be read back without waiting on the GPU.
+
+typedef enum
+{
+    ZFW_PROFILER_CPU_SCOPE_ID__EVENTS, // Polling events and updating input.
+    ZFW_PROFILER_CPU_SCOPE_ID__TICKS, // Running the user tick function.
+    ZFW_PROFILER_CPU_SCOPE_ID__SPRITE_QUEUE_PREP, // Sorting and uploading queued sprites, and packing and uploading character batch glyphs.
+    ZFW_PROFILER_CPU_SCOPE_ID__RENDER, // Issuing batch uploads and draws.
+    ZFW_PROFILER_CPU_SCOPE_ID__SWAP_BUFFERS,
+
+    ZFW_PROFILER_CPU_SCOPE_COUNT
+} zfw_profiler_cpu_scope_id_t;
+
+// Counts of the render work done in a frame.
+typedef struct
+{
+    int draw_call_count;
+    int buf_upload_count;
+    int buf_upload_size; // In bytes.
+    int active_sprite_batch_count;
+    int active_char_batch_count;
+    int live_sprite_batch_slot_count;
+    int sprite_queue_cmd_count;
+} zfw_profiler_counters_t;
+
+typedef struct
+{
+    double time; // The total time of the frame in seconds, including time spent outside of any scope.
+    double cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_COUNT]; // In seconds.
+    double gpu_timer_times[ZFW_PROFILER_GPU_TIMER_LIMIT]; // In seconds. These lag a few frames behind the rest, since the results are only read back once the GPU is done with them.
+    zfw_profiler_counters_t counters;
+} zfw_profiler_frame_t;
+
+// Records CPU scope times, GPU timer query times and render counters for each frame. Counters are always kept, but
+// timings are only recorded if the profiler is enabled.
+typedef struct
+{
+    zfw_bool_t enabled;
+
+    zfw_profiler_frame_t frame; // The frame being recorded.
+    zfw_profiler_frame_t last_frame; // The most recently completed frame, which is what should be read from.
+
+    double frame_begin_time;
+    double cpu_scope_begin_times[ZFW_PROFILER_CPU_SCOPE_COUNT];
+
+    GLuint gpu_query_gl_ids[ZFW_PROFILER_GPU_QUERY_FRAME_COUNT][ZFW_PROFILER_GPU_TIMER_LIMIT];
+    zfw_profiler_gpu_timer_bits_t gpu_query_issued_bits[ZFW_PROFILER_GPU_QUERY_FRAME_COUNT]; // Each bit represents whether the corresponding query was issued in that frame.
+    int gpu_query_frame_index;
+    double gpu_timer_times[ZFW_PROFILER_GPU_TIMER_LIMIT]; // The most recent results read back, carried into each completed frame.
+} zfw_profiler_t;
+
+void zfw_init_profiler(zfw_profiler_t *const profiler, const zfw_bool_t enabled);
+void zfw_clean_profiler(zfw_profiler_t *const profiler);
+void zfw_end_profiler_frame(zfw_profiler_t *const profiler);
+void zfw_begin_profiler_cpu_scope(zfw_profiler_t *const profiler, const zfw_profiler_cpu_scope_id_t scope_id);
+void zfw_end_profiler_cpu_scope(zfw_profiler_t *const profiler, const zfw_profiler_cpu_scope_id_t scope_id);
+void zfw_begin_profiler_gpu_timer(zfw_profiler_t *const profiler, const int timer_index);
+void zfw_end_profiler_gpu_timer(zfw_profiler_t *const profiler);
+
+#endif
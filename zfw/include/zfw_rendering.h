@@ -1,13 +1,18 @@
 #ifndef __ZFW_RENDERING_H__
 #define __ZFW_RENDERING_H__
 
+#include <stdio.h>
 #include <glad/glad.h>
 #include <zfw_common_math.h>
 #include <zfw_common_bits.h>
 #include "zfw_assets.h"
+#include "zfw_profiling.h"
 
 typedef unsigned char zfw_render_layer_sprite_batch_activity_bits_t;
 typedef unsigned long long zfw_render_layer_char_batch_bits_t;
+typedef unsigned long long zfw_sprite_batch_staging_dirty_bits_t;
+typedef unsigned long long zfw_sprite_batch_slot_activity_word_t;
+typedef unsigned long long zfw_sprite_queue_key_t;
 
 #define ZFW_RENDER_LAYER_LIMIT 32
 #define ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT ZFW_SIZE_IN_BITS(zfw_render_layer_sprite_batch_activity_bits_t)
@@ -15,8 +20,47 @@ typedef unsigned long long zfw_render_layer_char_batch_bits_t;
 
 #define ZFW_SPRITE_BATCH_SLOT_LIMIT 8192
 #define ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT 32
+#define ZFW_SPRITE_BATCH_SLOT_ACTIVITY_WORD_COUNT (ZFW_SPRITE_BATCH_SLOT_LIMIT / ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t))
+#define ZFW_SPRITE_BATCH_SLOT_ACTIVITY_SUMMARY_WORD_COUNT (ZFW_SPRITE_BATCH_SLOT_ACTIVITY_WORD_COUNT / ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t))
+#define ZFW_SPRITE_BATCH_STAGING_CHUNK_SLOT_COUNT (ZFW_SPRITE_BATCH_SLOT_LIMIT / ZFW_SIZE_IN_BITS(zfw_sprite_batch_staging_dirty_bits_t))
 
-#define ZFW_CHAR_BATCH_SLOT_LIMIT 64
+#define ZFW_RENDER_CAPTURE_FILE_MAGIC 0x4357465A // "ZFWC" in little-endian byte order.
+#define ZFW_RENDER_CAPTURE_FILE_VERSION 1
+
+#define ZFW_RENDER_GPU_TIMER_COUNT (ZFW_SPRITE_BATCH_GROUP_COUNT * ZFW_RENDER_LAYER_LIMIT) // Each layer of each batch group is timed on the GPU separately when profiling.
+
+// The layout of sprite batch slot keys, from the least significant bits up, after the activity bit. Each field is as wide
+// as the base-2 logarithm of its limit, which is checked below.
+#define ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_BIT_COUNT 1
+#define ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_BIT_COUNT 5
+#define ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_BIT_COUNT 3
+#define ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_BIT_COUNT 13
+#define ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_BIT_COUNT 5
+
+#define ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_SHIFT 1
+#define ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_SHIFT (ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_SHIFT + ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_BIT_COUNT)
+#define ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_SHIFT (ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_SHIFT + ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_BIT_COUNT)
+#define ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_SHIFT (ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_SHIFT + ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_BIT_COUNT)
+#define ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_SHIFT (ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_SHIFT + ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_BIT_COUNT)
+#define ZFW_SPRITE_BATCH_SLOT_KEY_BIT_COUNT (ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_SHIFT + ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_BIT_COUNT)
+
+#define ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(KEY, ELEM) (((KEY) >> ZFW_SPRITE_BATCH_SLOT_KEY_##ELEM##_SHIFT) & ((1U << ZFW_SPRITE_BATCH_SLOT_KEY_##ELEM##_BIT_COUNT) - 1))
+
+// The layout of character batch keys, in the same form as sprite batch slot keys.
+#define ZFW_CHAR_BATCH_KEY_LAYER_INDEX_BIT_COUNT 5
+#define ZFW_CHAR_BATCH_KEY_BATCH_INDEX_BIT_COUNT 6
+
+#define ZFW_CHAR_BATCH_KEY_LAYER_INDEX_SHIFT 1
+#define ZFW_CHAR_BATCH_KEY_BATCH_INDEX_SHIFT (ZFW_CHAR_BATCH_KEY_LAYER_INDEX_SHIFT + ZFW_CHAR_BATCH_KEY_LAYER_INDEX_BIT_COUNT)
+#define ZFW_CHAR_BATCH_KEY_BIT_COUNT (ZFW_CHAR_BATCH_KEY_BATCH_INDEX_SHIFT + ZFW_CHAR_BATCH_KEY_BATCH_INDEX_BIT_COUNT)
+
+#define ZFW_SPRITE_QUEUE_CMD_LIMIT 32768
+#define ZFW_SPRITE_QUEUE_DEPTH_LIMIT 65536 // Submitted depths are clamped below this.
+#define ZFW_SPRITE_QUEUE_BUILTIN_SHADER_PROG_INDEX -1 // Submit with this in place of a user shader program index to use the built-in sprite shader program.
+
+#define ZFW_RENDER_BATCH_IDLE_FRAME_LIMIT 300 // The number of consecutive frames a batch can go unused before its OpenGL objects and memory are released.
+
+#define ZFW_SHADER_PROG_UNIFORM_NAME_LEN_LIMIT 64
 
 typedef enum
 {
@@ -51,46 +95,250 @@ typedef enum
     ZFW_FONT_VERT_ALIGN__BOTTOM
 } zfw_font_vert_align_t;
 
+typedef enum
+{
+    ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_SPRITE_BATCH_SLOT,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_MULTIPLE_SPRITE_BATCH_SLOTS,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOT,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOTS_BULK,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_SPRITE_BATCH_SLOT,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_SPRITE_BATCH_SLOT,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_CHAR_BATCH,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_CHAR_BATCH,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_CHAR_BATCH,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_CHAR_BATCH,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__RESET_SPRITE_QUEUE,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__SUBMIT_SPRITE,
+    ZFW_RENDER_CAPTURE_CMD_TYPE__RENDER
+} zfw_render_capture_cmd_type_t;
+
 typedef unsigned int zfw_sprite_batch_slot_key_t;
 typedef unsigned short zfw_char_batch_key_t;
+typedef unsigned long long zfw_char_batch_layout_hash_t;
+
+_Static_assert((1 << ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_BIT_COUNT) == ZFW_SPRITE_BATCH_GROUP_COUNT, "The sprite batch group count must match its slot key field width.");
+_Static_assert((1 << ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_BIT_COUNT) == ZFW_RENDER_LAYER_LIMIT, "The render layer limit must match its sprite batch slot key field width.");
+_Static_assert((1 << ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_BIT_COUNT) == ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT, "The render layer sprite batch limit must match its slot key field width.");
+_Static_assert((1 << ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_BIT_COUNT) == ZFW_SPRITE_BATCH_SLOT_LIMIT, "The sprite batch slot limit must match its slot key field width.");
+_Static_assert((1 << ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_BIT_COUNT) == ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT, "The sprite batch texture unit limit must match its slot key field width.");
+_Static_assert(ZFW_SPRITE_BATCH_SLOT_KEY_BIT_COUNT <= ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_key_t), "Sprite batch slot key fields must fit in the key type.");
+
+_Static_assert((1 << ZFW_CHAR_BATCH_KEY_LAYER_INDEX_BIT_COUNT) == ZFW_RENDER_LAYER_LIMIT, "The render layer limit must match its character batch key field width.");
+_Static_assert((1 << ZFW_CHAR_BATCH_KEY_BATCH_INDEX_BIT_COUNT) == ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT, "The render layer character batch limit must match its key field width.");
+_Static_assert(ZFW_CHAR_BATCH_KEY_BIT_COUNT <= ZFW_SIZE_IN_BITS(zfw_char_batch_key_t), "Character batch key fields must fit in the key type.");
+
+_Static_assert(ZFW_RENDER_GPU_TIMER_COUNT <= ZFW_PROFILER_GPU_TIMER_LIMIT, "Every render layer must have a profiler GPU timer.");
 
 typedef struct
 {
     float r, g, b, a;
 } zfw_color_t;
 
+// Records the calls that feed the renderer to a file, so that they can be replayed by zfw_render_bench without the game.
+// Slot and batch keys are recorded as they were returned, since replaying the same calls in order hands out the same
+// keys. Data is written in native byte order, so captures should be replayed on the platform they were made on.
+typedef struct
+{
+    FILE *fs; // NULL if the capture isn't active.
+    int frames_left;
+    int frame_count;
+} zfw_render_capture_t;
+
 typedef struct
 {
     int user_tex_index;
     int count; // Represents the number of batch slots that are mapped to this texture unit.
 } zfw_sprite_batch_tex_unit_t;
 
+// A two-level bitmap of which slots of a sprite batch are active, so that a free slot can be found (and the highest
+// active slot updated) with a couple of bit scans rather than a walk over every slot.
+typedef struct
+{
+    zfw_sprite_batch_slot_activity_word_t words[ZFW_SPRITE_BATCH_SLOT_ACTIVITY_WORD_COUNT]; // Each bit represents whether the corresponding slot is active.
+    zfw_sprite_batch_slot_activity_word_t full_words[ZFW_SPRITE_BATCH_SLOT_ACTIVITY_SUMMARY_WORD_COUNT]; // Each bit represents whether the corresponding word has all of its slots active.
+    zfw_sprite_batch_slot_activity_word_t used_words[ZFW_SPRITE_BATCH_SLOT_ACTIVITY_SUMMARY_WORD_COUNT]; // Each bit represents whether the corresponding word has any of its slots active.
+} zfw_sprite_batch_slot_activity_t;
+
+// The per-instance render data of a sprite batch slot, drawn as an instance of a shared unit quad.
+typedef struct
+{
+    zfw_vec_2d_t pos; // The position of the top-left corner of the quad after rotation, with the origin already applied.
+    zfw_vec_2d_t size; // The source rectangle size multiplied by the scale.
+    float rot_cos_sin[2]; // The cosine and sine of the rotation, computed once here rather than for every vertex.
+    float tex_index;
+    float tex_coords[4]; // Left, top, right, bottom.
+    unsigned char blend[4]; // RGBA.
+} zfw_sprite_inst_t;
+
+// A CPU-side copy of the instance data of a sprite batch. Slot writes only touch this, and the dirty chunks are uploaded
+// once per frame at render time.
+typedef struct
+{
+    zfw_sprite_inst_t *insts;
+    zfw_sprite_batch_staging_dirty_bits_t dirty_bits; // Each bit represents whether a chunk of ZFW_SPRITE_BATCH_STAGING_CHUNK_SLOT_COUNT slots has changed since the last upload.
+} zfw_sprite_batch_staging_t;
+
+// The render data of a glyph written to a character batch, relative to the batch position and before the batch scale is
+// applied, so that the properties of the batch can change without the glyphs being laid out again.
+typedef struct
+{
+    zfw_vec_2d_t pos;
+    zfw_vec_2d_t size;
+    float tex_coords[4]; // Left, top, right, bottom.
+} zfw_char_batch_glyph_t;
+
+// The per-instance render data of a glyph with the properties of its batch applied, drawn as an instance of a shared unit
+// quad.
+typedef struct
+{
+    zfw_vec_2d_t pos;
+    zfw_vec_2d_t size;
+    float tex_coords[4]; // Left, top, right, bottom.
+    unsigned char blend[4]; // RGBA.
+} zfw_char_inst_t;
+
+// A run of consecutive glyph instances of a single layer sharing a font, drawn with a single call.
+typedef struct
+{
+    int user_font_index;
+    int inst_begin_index;
+    int inst_count;
+} zfw_char_inst_run_t;
+
+typedef struct
+{
+    zfw_sprite_queue_key_t key;
+    zfw_sprite_inst_t inst;
+} zfw_sprite_queue_cmd_t;
+
+typedef struct
+{
+    zfw_sprite_queue_key_t key;
+    int cmd_index;
+} zfw_sprite_queue_sort_elem_t;
+
+// An immediate-mode alternative to sprite batch slots. Sprites are submitted every tick as commands, which are sorted
+// on a key of batch group, layer, shader program, texture and depth before rendering, so that each run of commands
+// sharing state is drawn with a single call.
+typedef struct
+{
+    zfw_mem_arena_t cmd_arena; // Commands are appended here contiguously, and the arena is reset whenever the queue is.
+    int cmd_count;
+
+    zfw_sprite_queue_sort_elem_t *sort_elems;
+    zfw_sprite_queue_sort_elem_t *sort_elems_scratch;
+    const zfw_sprite_queue_sort_elem_t *sorted_elems; // Points to whichever of the above holds the result of the last sort.
+
+    zfw_sprite_inst_t *sorted_insts; // The instances of the commands in sorted order, ready for upload.
+    zfw_bool_t prepared; // Whether the commands have been sorted and uploaded since they last changed, so that frames rendered between ticks can skip doing it again.
+
+    zfw_bool_t tex_array;
+    int user_shader_prog_count; // Submitted user shader program indexes are checked against this.
+
+    GLuint vert_array_gl_id;
+    GLuint inst_buf_gl_id;
+    GLuint quad_vert_buf_gl_id;
+
+    zfw_render_capture_t *capture; // NULL unless the render stream is being captured.
+} zfw_sprite_queue_t;
+
+typedef struct
+{
+    char name[ZFW_SHADER_PROG_UNIFORM_NAME_LEN_LIMIT]; // Array uniforms have their "[0]" suffix removed.
+    GLint loc;
+} zfw_shader_prog_uniform_t;
+
+typedef struct
+{
+    GLint sprite_quad_view_proj;
+    GLint sprite_quad_textures;
+
+    GLint char_quad_proj;
+    GLint char_quad_sdf_proj;
+} zfw_builtin_shader_prog_uniform_locs_t;
+
+// The locations of the uniforms that sprite drawing sets on a user shader program, or -1 for those it doesn't have.
+typedef struct
+{
+    GLint view_proj;
+    GLint textures;
+} zfw_user_shader_prog_sprite_uniform_locs_t;
+
+// Device limits and shader program uniform locations, queried once at startup so that they don't have to be queried
+// from OpenGL while taking slots or drawing.
+typedef struct
+{
+    int tex_unit_limit;
+    int tex_size_limit;
+
+    zfw_builtin_shader_prog_uniform_locs_t builtin_uniform_locs;
+
+    zfw_shader_prog_uniform_t *user_shader_prog_uniforms; // The active uniforms of all user shader programs, stored contiguously in program order.
+    int *user_shader_prog_uniform_begin_indexes;
+    int *user_shader_prog_uniform_counts;
+
+    zfw_user_shader_prog_sprite_uniform_locs_t *user_shader_prog_sprite_uniform_locs;
+} zfw_render_context_t;
+
 typedef struct
 {
     zfw_render_layer_sprite_batch_activity_bits_t batch_activity_bits[ZFW_RENDER_LAYER_LIMIT];
 
+    zfw_bool_t tex_array; // Whether user textures are layers of a single texture array, in which case any texture can be drawn in any batch and texture units are unused.
+    int tex_unit_limit; // The number of texture units usable per batch, as limited by both the device and the batch slot key.
+
+    // Batch OpenGL objects are only generated when a batch is first activated, so these are 0 for batches not in use.
     GLuint *vert_array_gl_ids;
-    GLuint *vert_buf_gl_ids;
-    GLuint *elem_buf_gl_ids;
+    GLuint *inst_buf_gl_ids;
+    GLuint quad_vert_buf_gl_id;
 
     zfw_sprite_batch_tex_unit_t *tex_units;
 
-    zfw_bitset_t slot_activity;
+    zfw_sprite_batch_slot_activity_t **batch_slot_activities; // Each element is allocated when the corresponding batch is first activated.
+
+    int *batch_idle_frame_counts; // The number of consecutive frames each active batch has had no active slots.
+
+    int *batch_live_slot_bounds; // Each element is one greater than the index of the highest active slot in the corresponding batch, so that only slots below it need to be drawn.
+
+    zfw_sprite_batch_staging_t *batch_stagings;
+
+    zfw_render_capture_t *capture; // NULL unless the render stream is being captured.
 } zfw_sprite_batch_group_t;
 
+// Character batches only hold their glyphs on the CPU. Before rendering, the glyphs of all active batches are combined
+// with the properties of their batches into a single instance buffer, grouped by layer then font, so that each layer draws
+// its text with one call per font.
 typedef struct
 {
-    zfw_render_layer_char_batch_bits_t batch_init_bits[ZFW_RENDER_LAYER_LIMIT]; // Each bit represents whether the corresponding batch has been initialised.
+    zfw_render_layer_char_batch_bits_t batch_init_bits[ZFW_RENDER_LAYER_LIMIT]; // Each bit represents whether the corresponding batch has been taken since it was last released, and so may have a glyph store.
     zfw_render_layer_char_batch_bits_t batch_activity_bits[ZFW_RENDER_LAYER_LIMIT];
 
-    GLuint *vert_array_gl_ids;
-    GLuint *vert_buf_gl_ids;
-    GLuint *elem_buf_gl_ids;
+    int *batch_idle_frame_counts; // The number of consecutive frames each initialised batch has been inactive.
+
+    zfw_char_batch_glyph_t **batch_glyphs; // Each element is allocated when the corresponding batch is first written to, and grows to fit longer text.
+    int *batch_glyph_counts;
+    int *batch_glyph_caps;
+    zfw_char_batch_layout_hash_t *batch_layout_hashes; // Each element is a hash of the text, font and alignment last written to the corresponding batch, so that unchanged writes can be skipped.
 
     int *user_font_indexes;
     zfw_vec_2d_t *positions;
     zfw_vec_2d_t *scales;
     zfw_color_t *blends;
+
+    zfw_char_inst_t *insts; // The instances of all active batches, as last prepared for upload.
+    int inst_cap; // The number of instances that the store and buffer can hold, which grows as needed.
+
+    zfw_char_inst_run_t *inst_runs;
+    int layer_inst_run_begin_indexes[ZFW_RENDER_LAYER_LIMIT];
+    int layer_inst_run_counts[ZFW_RENDER_LAYER_LIMIT];
+
+    zfw_bool_t prepared; // Whether the instances have been prepared and uploaded since any batch last changed.
+
+    GLuint vert_array_gl_id;
+    GLuint inst_buf_gl_id;
+    GLuint quad_vert_buf_gl_id;
+
+    zfw_render_capture_t *capture; // NULL unless the render stream is being captured.
 } zfw_char_batch_group_t;
 
 typedef struct
@@ -99,35 +347,164 @@ typedef struct
     float scale;
 } zfw_view_state_t;
 
+typedef struct
+{
+    int magic;
+    int version;
+    zfw_bool_t tex_array;
+    int frame_count;
+} zfw_render_capture_file_header_t;
+
+// Every command starts with this, followed by its payload.
+typedef struct
+{
+    int type;
+    int size; // The size of the payload in bytes.
+} zfw_render_capture_cmd_header_t;
+
+typedef struct
+{
+    int batch_group_id;
+    int layer_index;
+    int user_tex_index;
+    int slot_key_count; // Only used for multiple slot takes.
+} zfw_render_capture_take_sprite_batch_slot_cmd_t;
+
+typedef struct
+{
+    zfw_sprite_batch_slot_key_t slot_key;
+    zfw_vec_2d_t pos;
+    float rot;
+    zfw_vec_2d_t scale;
+    zfw_vec_2d_t origin;
+    zfw_rect_t src_rect;
+    zfw_color_t blend;
+} zfw_render_capture_write_sprite_batch_slot_cmd_t;
+
+// This is followed by arrays of the slot keys, positions, rotations (if rotated), scales, source rectangles and blends.
+typedef struct
+{
+    int slot_key_count;
+    zfw_vec_2d_t origin;
+    zfw_bool_t rotated;
+} zfw_render_capture_write_sprite_batch_slots_bulk_cmd_t;
+
+// Used for clearing and freeing slots.
+typedef struct
+{
+    zfw_sprite_batch_slot_key_t slot_key;
+} zfw_render_capture_sprite_batch_slot_cmd_t;
+
+typedef struct
+{
+    int layer_index;
+} zfw_render_capture_take_char_batch_cmd_t;
+
+// This is followed by the text, including its terminating null character.
+typedef struct
+{
+    zfw_char_batch_key_t key;
+    int hor_align;
+    int vert_align;
+} zfw_render_capture_write_char_batch_cmd_t;
+
+// Used for clearing and freeing character batches.
+typedef struct
+{
+    zfw_char_batch_key_t key;
+} zfw_render_capture_char_batch_cmd_t;
+
+typedef struct
+{
+    int batch_group_id;
+    int layer_index;
+    int depth;
+    int user_tex_index;
+    int user_shader_prog_index;
+    zfw_vec_2d_t pos;
+    float rot;
+    zfw_vec_2d_t scale;
+    zfw_vec_2d_t origin;
+    zfw_rect_t src_rect;
+    zfw_color_t blend;
+} zfw_render_capture_submit_sprite_cmd_t;
+
+// The properties of an active character batch at render time. These are set directly on the batch group rather than
+// through calls, so they're recorded with each render instead.
+typedef struct
+{
+    zfw_char_batch_key_t key;
+    int user_font_index;
+    zfw_vec_2d_t pos;
+    zfw_vec_2d_t scale;
+    zfw_color_t blend;
+} zfw_render_capture_char_batch_props_t;
+
+// This is followed by the properties of each active character batch.
+typedef struct
+{
+    zfw_vec_2d_i_t window_size;
+    zfw_view_state_t view_state;
+    int char_batch_count;
+} zfw_render_capture_render_cmd_t;
+
+// A framebuffer with a single colour renderbuffer, for rendering without a visible window.
+typedef struct
+{
+    GLuint fb_gl_id;
+    GLuint color_rb_gl_id;
+    zfw_vec_2d_i_t size;
+} zfw_offscreen_target_t;
+
 extern const zfw_color_t zfw_k_color_white;
 extern const zfw_color_t zfw_k_color_black;
 extern const zfw_color_t zfw_k_color_red;
 extern const zfw_color_t zfw_k_color_green;
 extern const zfw_color_t zfw_k_color_blue;
 
-zfw_bool_t zfw_init_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena);
+zfw_bool_t zfw_init_render_context(zfw_render_context_t *const render_context, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data, zfw_mem_arena_t *const main_mem_arena);
+GLint zfw_get_user_shader_prog_uniform_loc(const int user_shader_prog_index, const char *const uniform_name, const zfw_render_context_t *const render_context);
+
+zfw_bool_t zfw_init_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group, const zfw_render_context_t *const render_context, const zfw_user_tex_data_t *const user_tex_data, zfw_mem_arena_t *const main_mem_arena);
 void zfw_clean_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group);
 void zfw_set_sprite_batch_group_defaults(zfw_sprite_batch_group_t *const batch_group);
+void zfw_release_idle_sprite_batches(zfw_sprite_batch_group_t *const batch_group);
 
-zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], zfw_mem_arena_t *const main_mem_arena);
-void zfw_take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], zfw_mem_arena_t *const main_mem_arena);
+zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT]);
+void zfw_take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT]);
 zfw_bool_t zfw_write_to_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_user_tex_data_t *const user_tex_data);
+// Writes to many sprite batch slots at once, taking one element of each array per slot key and sharing the origin. The
+// rotations can be NULL if none of the sprites are rotated.
+zfw_bool_t zfw_write_sprite_batch_slots_bulk(const zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_vec_2d_t *const positions, const float *const rots, const zfw_vec_2d_t *const scales, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rects, const zfw_color_t *const blends, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_user_tex_data_t *const user_tex_data);
 zfw_bool_t zfw_clear_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT]);
 zfw_bool_t zfw_free_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT]);
-zfw_sprite_batch_slot_key_t zfw_create_sprite_batch_slot_key(const int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT]);
-int zfw_get_sprite_batch_slot_key_elem(const zfw_sprite_batch_slot_key_t slot_key, const zfw_sprite_batch_slot_key_elem_id_t elem_id);
-void zfw_init_sprite_batch_slot_key_elems(const zfw_sprite_batch_slot_key_t slot_key, int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT]);
+
+zfw_bool_t zfw_init_sprite_queue(zfw_sprite_queue_t *const queue, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data);
+void zfw_clean_sprite_queue(zfw_sprite_queue_t *const queue);
+void zfw_reset_sprite_queue(zfw_sprite_queue_t *const queue);
+zfw_bool_t zfw_submit_sprite(zfw_sprite_queue_t *const queue, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int depth, const int user_tex_index, const int user_shader_prog_index, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_user_tex_data_t *const user_tex_data);
+void zfw_prepare_sprite_queue(zfw_sprite_queue_t *const queue, zfw_profiler_counters_t *const profiler_counters);
 
 zfw_bool_t zfw_init_char_batch_group(zfw_char_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena);
 void zfw_clean_char_batch_group(zfw_char_batch_group_t *const batch_group);
 void zfw_set_char_batch_group_defaults(zfw_char_batch_group_t *const batch_group);
-zfw_char_batch_key_t zfw_take_render_layer_char_batch(const int layer_index, zfw_char_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena);
+void zfw_release_idle_char_batches(zfw_char_batch_group_t *const batch_group);
+void zfw_prepare_char_batch_group(zfw_char_batch_group_t *const batch_group, zfw_profiler_counters_t *const profiler_counters);
+zfw_char_batch_key_t zfw_take_render_layer_char_batch(const int layer_index, zfw_char_batch_group_t *const batch_group);
 zfw_bool_t zfw_write_to_render_layer_char_batch(const zfw_char_batch_key_t key, const char *const text, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align, zfw_char_batch_group_t *const batch_group, const zfw_user_font_data_t *const user_font_data);
 zfw_bool_t zfw_clear_render_layer_char_batch(const zfw_char_batch_key_t key, zfw_char_batch_group_t *const batch_group);
 zfw_bool_t zfw_free_render_layer_char_batch(const zfw_char_batch_key_t key, zfw_char_batch_group_t *const batch_group);
-zfw_char_batch_key_t zfw_create_char_batch_key(const int layer_index, const int batch_index);
+zfw_rect_f_t zfw_measure_text(const char *const text, const int user_font_index, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align, const zfw_user_font_data_t *const user_font_data);
+
+void zfw_render_sprite_and_character_batches(const zfw_sprite_batch_group_t sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_char_batch_group_t *const char_batch_group, const zfw_sprite_queue_t *const sprite_queue, const zfw_view_state_t *const view_state, const zfw_vec_2d_i_t window_size, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_render_context_t *const render_context, zfw_profiler_t *const profiler);
 
-void zfw_render_sprite_and_character_batches(const zfw_sprite_batch_group_t sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_char_batch_group_t *const char_batch_group, const zfw_view_state_t *const view_state, const zfw_vec_2d_i_t window_size, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data);
+zfw_bool_t zfw_begin_render_capture(zfw_render_capture_t *const capture, const char *const file_name, const int frame_count, const zfw_bool_t tex_array);
+void zfw_end_render_capture(zfw_render_capture_t *const capture);
+
+zfw_bool_t zfw_init_offscreen_target(zfw_offscreen_target_t *const target, const zfw_vec_2d_i_t size);
+void zfw_clean_offscreen_target(zfw_offscreen_target_t *const target);
+void zfw_bind_offscreen_target(const zfw_offscreen_target_t *const target);
+void zfw_read_offscreen_target_pixels(const zfw_offscreen_target_t *const target, unsigned char *const pixels);
 
 void zfw_set_view_state_defaults(zfw_view_state_t *const view_state);
 
@@ -136,11 +513,6 @@ inline int zfw_get_sprite_batch_group_batch_index(const int layer_index, const i
     return (layer_index * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT) + batch_index;
 }
 
-inline int zfw_get_sprite_batch_group_slot_index(const int layer_index, const int batch_index, const int slot_index)
-{
-    return (layer_index * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_SPRITE_BATCH_SLOT_LIMIT) + (batch_index * ZFW_SPRITE_BATCH_SLOT_LIMIT) + slot_index;
-}
-
 inline int zfw_get_sprite_batch_group_tex_unit_index(const int layer_index, const int batch_index, const int tex_unit_index)
 {
     return (layer_index * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT) + (batch_index * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT) + tex_unit_index;
@@ -151,6 +523,46 @@ inline zfw_bool_t zfw_is_sprite_batch_slot_key_active(const zfw_sprite_batch_slo
     return slot_key & 1;
 }
 
+inline zfw_sprite_batch_slot_key_t zfw_create_sprite_batch_slot_key(const int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT])
+{
+    return 1 // Mark the key as active.
+        | ((zfw_sprite_batch_slot_key_t)key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX] << ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_GROUP_INDEX_SHIFT)
+        | ((zfw_sprite_batch_slot_key_t)key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX] << ZFW_SPRITE_BATCH_SLOT_KEY_LAYER_INDEX_SHIFT)
+        | ((zfw_sprite_batch_slot_key_t)key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX] << ZFW_SPRITE_BATCH_SLOT_KEY_BATCH_INDEX_SHIFT)
+        | ((zfw_sprite_batch_slot_key_t)key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] << ZFW_SPRITE_BATCH_SLOT_KEY_SLOT_INDEX_SHIFT)
+        | ((zfw_sprite_batch_slot_key_t)key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX] << ZFW_SPRITE_BATCH_SLOT_KEY_TEX_UNIT_INDEX_SHIFT);
+}
+
+inline int zfw_get_sprite_batch_slot_key_elem(const zfw_sprite_batch_slot_key_t slot_key, const zfw_sprite_batch_slot_key_elem_id_t elem_id)
+{
+    switch (elem_id)
+    {
+        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX: return ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, BATCH_GROUP_INDEX);
+        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX: return ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, LAYER_INDEX);
+        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX: return ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, BATCH_INDEX);
+        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX: return ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, SLOT_INDEX);
+        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX: return ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, TEX_UNIT_INDEX);
+    }
+
+    return -1;
+}
+
+inline void zfw_init_sprite_batch_slot_key_elems(const zfw_sprite_batch_slot_key_t slot_key, int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT])
+{
+    key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX] = ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, BATCH_GROUP_INDEX);
+    key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX] = ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, LAYER_INDEX);
+    key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX] = ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, BATCH_INDEX);
+    key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] = ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, SLOT_INDEX);
+    key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX] = ZFW_SPRITE_BATCH_SLOT_KEY_ELEM(slot_key, TEX_UNIT_INDEX);
+}
+
+// Returns the index of the profiler GPU timer used for a layer of a batch group. The screen batch group timers include
+// character batches.
+inline int zfw_get_render_layer_gpu_timer_index(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index)
+{
+    return (batch_group_id * ZFW_RENDER_LAYER_LIMIT) + layer_index;
+}
+
 inline int zfw_get_char_batch_group_batch_index(const int layer_index, const int batch_index)
 {
     return (layer_index * ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT) + batch_index;
@@ -161,34 +573,50 @@ inline zfw_bool_t zfw_is_char_batch_slot_key_active(const zfw_char_batch_key_t k
     return key & 1;
 }
 
-inline zfw_bool_t zfw_get_char_batch_slot_key_layer_index(const zfw_char_batch_key_t key)
+inline int zfw_get_char_batch_slot_key_layer_index(const zfw_char_batch_key_t key)
 {
-    return (key >> 1) & (ZFW_RENDER_LAYER_LIMIT - 1);
+    return (key >> ZFW_CHAR_BATCH_KEY_LAYER_INDEX_SHIFT) & ((1 << ZFW_CHAR_BATCH_KEY_LAYER_INDEX_BIT_COUNT) - 1);
 }
 
-inline zfw_bool_t zfw_get_char_batch_slot_key_batch_index(const zfw_char_batch_key_t key)
+inline int zfw_get_char_batch_slot_key_batch_index(const zfw_char_batch_key_t key)
 {
-    return key >> (1 + (int)log2(ZFW_RENDER_LAYER_LIMIT));
+    return (key >> ZFW_CHAR_BATCH_KEY_BATCH_INDEX_SHIFT) & ((1 << ZFW_CHAR_BATCH_KEY_BATCH_INDEX_BIT_COUNT) - 1);
+}
+
+inline zfw_char_batch_key_t zfw_create_char_batch_key(const int layer_index, const int batch_index)
+{
+    return 1 // Mark the key as active.
+        | ((zfw_char_batch_key_t)layer_index << ZFW_CHAR_BATCH_KEY_LAYER_INDEX_SHIFT)
+        | ((zfw_char_batch_key_t)batch_index << ZFW_CHAR_BATCH_KEY_BATCH_INDEX_SHIFT);
 }
 
 inline void zfw_set_render_layer_char_batch_user_font_index(const zfw_char_batch_key_t key, const int user_font_index, zfw_char_batch_group_t *const batch_group)
 {
     batch_group->user_font_indexes[zfw_get_char_batch_group_batch_index(zfw_get_char_batch_slot_key_layer_index(key), zfw_get_char_batch_slot_key_batch_index(key))] = user_font_index;
+    batch_group->prepared = ZFW_FALSE;
 }
 
 inline void zfw_set_render_layer_char_batch_pos(const zfw_char_batch_key_t key, const zfw_vec_2d_t pos, zfw_char_batch_group_t *const batch_group)
 {
     batch_group->positions[zfw_get_char_batch_group_batch_index(zfw_get_char_batch_slot_key_layer_index(key), zfw_get_char_batch_slot_key_batch_index(key))] = pos;
+    batch_group->prepared = ZFW_FALSE;
 }
 
 inline void zfw_set_render_layer_char_batch_scale(const zfw_char_batch_key_t key, const zfw_vec_2d_t scale, zfw_char_batch_group_t *const batch_group)
 {
     batch_group->scales[zfw_get_char_batch_group_batch_index(zfw_get_char_batch_slot_key_layer_index(key), zfw_get_char_batch_slot_key_batch_index(key))] = scale;
+    batch_group->prepared = ZFW_FALSE;
 }
 
 inline void zfw_set_render_layer_char_batch_blend(const zfw_char_batch_key_t key, const zfw_color_t *const blend, zfw_char_batch_group_t *const batch_group)
 {
     batch_group->blends[zfw_get_char_batch_group_batch_index(zfw_get_char_batch_slot_key_layer_index(key), zfw_get_char_batch_slot_key_batch_index(key))] = *blend;
+    batch_group->prepared = ZFW_FALSE;
+}
+
+inline unsigned char zfw_get_color_elem_as_byte(const float elem)
+{
+    return (unsigned char)((ZFW_CLAMP(elem, 0.0f, 1.0f) * 255.0f) + 0.5f);
 }
 
 inline zfw_vec_2d_t zfw_get_view_size(const zfw_view_state_t *const view_state, const zfw_vec_2d_i_t window_size)
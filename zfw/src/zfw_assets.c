@@ -1,7 +1,29 @@
 #include <zfw_assets.h>
 
+#include <stdint.h>
+#include <string.h>
 #include <zfw_common_debug.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FONT_CHAR_LOOKUP_CAP_MIN 16 // Must be a power of two.
+#define TEX_ARRAY_SIZE_LIMIT (256 << 20) // The most bytes that the padded layers of the texture array may take up.
+#define TEX_ARRAY_PADDING_RATIO_LIMIT 4 // The most that padding may multiply the size of the texture data by in the texture array.
+
+typedef struct
+{
+    const unsigned char *data;
+    long size;
+    long offs;
+} assets_file_reader_t;
+
 void zfw_gen_shader_prog(GLuint *const shader_prog_gl_id, const char *const vert_shader_src, const char *const frag_shader_src)
 {
     // Create the vertex shader.
@@ -29,25 +51,431 @@ void zfw_gen_shader_prog(GLuint *const shader_prog_gl_id, const char *const vert
     glDeleteShader(vert_shader_gl_id);
 }
 
-zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *const tex_data, zfw_user_shader_prog_data_t *const shader_prog_data, zfw_user_font_data_t *const font_data, FILE *const assets_file_fs, zfw_mem_arena_t *const main_mem_arena)
+static zfw_bool_t is_compressed_tex_format_supported(const GLint format, zfw_mem_arena_t *const main_mem_arena)
 {
-    //
-    // Texture Data
-    //
-    fread(&tex_data->tex_count, sizeof(tex_data->tex_count), 1, assets_file_fs);
+    GLint format_count;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &format_count);
 
-    if (tex_data->tex_count)
+    if (format_count <= 0)
+    {
+        return ZFW_FALSE;
+    }
+
+    GLint *const formats = zfw_mem_arena_alloc(main_mem_arena, sizeof(*formats) * format_count);
+
+    if (!formats)
+    {
+        return ZFW_FALSE;
+    }
+
+    glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats);
+
+    zfw_bool_t supported = ZFW_FALSE;
+
+    for (int i = 0; i < format_count; i++)
+    {
+        if (formats[i] == format)
+        {
+            supported = ZFW_TRUE;
+            break;
+        }
+    }
+
+    zfw_rewind_mem_arena(main_mem_arena);
+
+    return supported;
+}
+
+static zfw_bool_t can_textures_fit_in_array(const zfw_user_tex_data_t *const tex_data)
+{
+    int layer_limit;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layer_limit);
+
+    int size_limit;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size_limit);
+
+    return tex_data->tex_count <= layer_limit && tex_data->array_size.x <= size_limit && tex_data->array_size.y <= size_limit;
+}
+
+// Every layer of the texture array is the size of the largest texture, so textures of very different sizes can waste most
+// of the memory that the array takes up. This checks that the padded layers stay within budget.
+static zfw_bool_t is_tex_array_padding_acceptable(const zfw_user_tex_data_t *const tex_data)
+{
+    const long long array_size = (long long)tex_data->array_size.x * tex_data->array_size.y * ZFW_TEX_CHANNEL_COUNT * tex_data->tex_count;
+
+    long long texs_size = 0;
+
+    for (int i = 0; i < tex_data->tex_count; i++)
+    {
+        texs_size += (long long)tex_data->sizes[i].x * tex_data->sizes[i].y * ZFW_TEX_CHANNEL_COUNT;
+    }
+
+    if (array_size > TEX_ARRAY_SIZE_LIMIT)
+    {
+        zfw_log_warning("The padded user texture array would take up %lld bytes, which exceeds the limit of %d, so user textures will be loaded as separate textures.", array_size, TEX_ARRAY_SIZE_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    if (array_size > texs_size * TEX_ARRAY_PADDING_RATIO_LIMIT)
+    {
+        zfw_log_warning("Padding would take up most of the user texture array (%lld of %lld bytes), so user textures will be loaded as separate textures.", array_size - texs_size, array_size);
+        return ZFW_FALSE;
+    }
+
+    return ZFW_TRUE;
+}
+
+// Checks the header and table of contents of a newly mapped assets file, so that stale or truncated files are rejected
+// before anything is loaded from them.
+static zfw_bool_t validate_assets_file(zfw_assets_file_mapping_t *const mapping)
+{
+    zfw_assets_file_header_t header;
+
+    if (mapping->size < (long)sizeof(header))
+    {
+        zfw_log_error("The assets file is too small to contain a header!");
+        return ZFW_FALSE;
+    }
+
+    memcpy(&header, mapping->data, sizeof(header));
+
+    if (header.magic != ZFW_ASSETS_FILE_MAGIC)
     {
-        tex_data->gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*tex_data->gl_ids) * tex_data->tex_count);
+        zfw_log_error("The assets file is not a valid assets file!");
+        return ZFW_FALSE;
+    }
 
-        if (!tex_data->gl_ids)
+    if (header.version != ZFW_ASSETS_FILE_VERSION)
+    {
+        zfw_log_error("The assets file has version %u, but version %d is required! The assets need to be repacked.", header.version, ZFW_ASSETS_FILE_VERSION);
+        return ZFW_FALSE;
+    }
+
+    if (header.entry_count < 0 || header.toc_offs < (int)sizeof(header) || header.toc_offs % ZFW_ASSETS_FILE_ENTRY_ALIGNMENT != 0 || header.toc_offs + ((long)sizeof(*mapping->entries) * header.entry_count) > mapping->size)
+    {
+        zfw_log_error("The table of contents of the assets file is out of bounds!");
+        return ZFW_FALSE;
+    }
+
+    // The table of contents is aligned, so it can be used in place.
+    mapping->entries = (const zfw_assets_file_entry_t *)(mapping->data + header.toc_offs);
+    mapping->entry_count = header.entry_count;
+
+    for (int i = 0; i < mapping->entry_count; i++)
+    {
+        const zfw_assets_file_entry_t *const entry = &mapping->entries[i];
+
+        if (entry->type < 0 || entry->type >= ZFW_ASSET_TYPE_COUNT || entry->offs < 0 || entry->size < 0 || (long)entry->offs + entry->size > mapping->size)
         {
-            zfw_log_error("Failed to allocate %d bytes for texture OpenGL IDs!", sizeof(*tex_data->gl_ids) * tex_data->tex_count);
+            zfw_log_error("Entry %d of the assets file table of contents is invalid!", i);
             return ZFW_FALSE;
         }
 
-        glGenTextures(tex_data->tex_count, tex_data->gl_ids);
+#ifndef NDEBUG
+        // Checksums are only verified in debug builds, as they require touching every byte of the file.
+        if (zfw_update_fnv_1a_hash(ZFW_FNV_1A_HASH_INIT, mapping->data + entry->offs, entry->size) != entry->checksum)
+        {
+            zfw_log_error("Entry %d of the assets file failed its checksum!", i);
+            return ZFW_FALSE;
+        }
+#endif
+    }
+
+    return ZFW_TRUE;
+}
+
+zfw_bool_t zfw_map_assets_file(zfw_assets_file_mapping_t *const mapping, const char *const file_path)
+{
+    memset(mapping, 0, sizeof(*mapping));
+
+#ifdef _WIN32
+    mapping->file_handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (mapping->file_handle == INVALID_HANDLE_VALUE)
+    {
+        mapping->file_handle = NULL;
+        return ZFW_FALSE;
+    }
+
+    LARGE_INTEGER file_size;
+
+    if (!GetFileSizeEx(mapping->file_handle, &file_size) || !file_size.QuadPart)
+    {
+        zfw_unmap_assets_file(mapping);
+        return ZFW_FALSE;
+    }
+
+    mapping->size = (long)file_size.QuadPart;
+
+    // Map the file copy-on-write, so that the data can be handed out through non-const pointers without ever being
+    // written back.
+    mapping->mapping_handle = CreateFileMappingA(mapping->file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+    if (!mapping->mapping_handle)
+    {
+        zfw_unmap_assets_file(mapping);
+        return ZFW_FALSE;
+    }
+
+    mapping->data = MapViewOfFile(mapping->mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+
+    if (!mapping->data)
+    {
+        zfw_unmap_assets_file(mapping);
+        return ZFW_FALSE;
+    }
+#else
+    const int fd = open(file_path, O_RDONLY);
+
+    if (fd == -1)
+    {
+        return ZFW_FALSE;
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) == -1 || !file_stat.st_size)
+    {
+        close(fd);
+        return ZFW_FALSE;
+    }
+
+    mapping->size = file_stat.st_size;
+
+    // Map the file copy-on-write, so that the data can be handed out through non-const pointers without ever being
+    // written back.
+    void *const data = mmap(NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the file descriptor is closed.
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        mapping->size = 0;
+        return ZFW_FALSE;
+    }
+
+    mapping->data = data;
+#endif
+
+    if (!validate_assets_file(mapping))
+    {
+        zfw_unmap_assets_file(mapping);
+        return ZFW_FALSE;
+    }
+
+    return ZFW_TRUE;
+}
+
+void zfw_unmap_assets_file(zfw_assets_file_mapping_t *const mapping)
+{
+#ifdef _WIN32
+    if (mapping->data)
+    {
+        UnmapViewOfFile(mapping->data);
+    }
+
+    if (mapping->mapping_handle)
+    {
+        CloseHandle(mapping->mapping_handle);
+    }
+
+    if (mapping->file_handle)
+    {
+        CloseHandle(mapping->file_handle);
+    }
+#else
+    if (mapping->data)
+    {
+        munmap((void *)mapping->data, mapping->size);
+    }
+#endif
+
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+// Entry types are range-checked when the assets file is mapped, so here and below they can be compared as asset types.
+const zfw_assets_file_entry_t *zfw_find_assets_file_entry(const zfw_assets_file_mapping_t *const mapping, const zfw_asset_type_t type, const unsigned int name_hash)
+{
+    for (int i = 0; i < mapping->entry_count; i++)
+    {
+        if ((zfw_asset_type_t)mapping->entries[i].type == type && mapping->entries[i].name_hash == name_hash)
+        {
+            return &mapping->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int get_assets_file_entry_count(const zfw_assets_file_mapping_t *const mapping, const zfw_asset_type_t type)
+{
+    int count = 0;
+
+    for (int i = 0; i < mapping->entry_count; i++)
+    {
+        if ((zfw_asset_type_t)mapping->entries[i].type == type)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Returns the next entry of the given type at or after the index, then moves the index past it. This allows the entries of
+// a type to be iterated in the order they were packed, which determines asset indexes.
+static const zfw_assets_file_entry_t *get_next_assets_file_entry(const zfw_assets_file_mapping_t *const mapping, const zfw_asset_type_t type, int *const index)
+{
+    for (; *index < mapping->entry_count; (*index)++)
+    {
+        if ((zfw_asset_type_t)mapping->entries[*index].type == type)
+        {
+            return &mapping->entries[(*index)++];
+        }
+    }
+
+    return NULL;
+}
+
+// Returns a reader over the data of a single table of contents entry.
+static assets_file_reader_t get_assets_file_entry_reader(const zfw_assets_file_mapping_t *const mapping, const zfw_assets_file_entry_t *const entry)
+{
+    const assets_file_reader_t reader = {mapping->data + entry->offs, entry->size, 0};
+    return reader;
+}
+
+// Returns a pointer to the next bytes of the assets file and advances past them, or NULL if the file is too short.
+static const unsigned char *read_assets_file_bytes(assets_file_reader_t *const reader, const long size)
+{
+    if (size < 0 || reader->offs + size > reader->size)
+    {
+        zfw_log_error("An assets file entry is shorter than expected!");
+        return NULL;
+    }
+
+    const unsigned char *const bytes = reader->data + reader->offs;
+    reader->offs += size;
+    return bytes;
+}
+
+// Copies out a single value, as it may not be suitably aligned in the file.
+static zfw_bool_t read_assets_file_val(assets_file_reader_t *const reader, void *const val, const int size)
+{
+    const unsigned char *const bytes = read_assets_file_bytes(reader, size);
+
+    if (!bytes)
+    {
+        return ZFW_FALSE;
+    }
+
+    memcpy(val, bytes, size);
+
+    return ZFW_TRUE;
+}
+
+// Returns a pointer to an array in the mapped file, or to a copy of it in the arena if it isn't aligned suitably for its
+// element type.
+static void *read_assets_file_array(assets_file_reader_t *const reader, const int elem_size, const int elem_alignment, const int elem_count, zfw_mem_arena_t *const main_mem_arena)
+{
+    const int size = elem_size * elem_count;
+    const unsigned char *const bytes = read_assets_file_bytes(reader, size);
+
+    if (!bytes)
+    {
+        return NULL;
+    }
+
+    if ((uintptr_t)bytes % elem_alignment == 0)
+    {
+        return (void *)bytes;
+    }
 
+    void *const bytes_copy = zfw_mem_arena_alloc(main_mem_arena, size);
+
+    if (!bytes_copy)
+    {
+        zfw_log_error("Failed to allocate %d bytes for a misaligned assets file array!", size);
+        return NULL;
+    }
+
+    memcpy(bytes_copy, bytes, size);
+
+    return bytes_copy;
+}
+
+static unsigned int get_font_char_lookup_hash(const int font_index, const unsigned int codepoint)
+{
+    return (codepoint * 2654435761u) ^ ((unsigned int)font_index * 2246822519u);
+}
+
+// Builds a hash table from font index and codepoint to character index, so that characters can be found in constant time
+// however many a font has.
+static zfw_bool_t build_font_char_lookup(zfw_user_font_data_t *const font_data, const int char_count, zfw_mem_arena_t *const main_mem_arena)
+{
+    // Keep the table at most half full so that probe sequences stay short.
+    font_data->char_lookup_cap = FONT_CHAR_LOOKUP_CAP_MIN;
+
+    while (font_data->char_lookup_cap < char_count * 2)
+    {
+        font_data->char_lookup_cap *= 2;
+    }
+
+    font_data->char_lookup_entries = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->char_lookup_entries) * font_data->char_lookup_cap);
+
+    if (!font_data->char_lookup_entries)
+    {
+        zfw_log_error("Failed to allocate %d bytes for the font character lookup!", sizeof(*font_data->char_lookup_entries) * font_data->char_lookup_cap);
+        return ZFW_FALSE;
+    }
+
+    for (int i = 0; i < font_data->char_lookup_cap; i++)
+    {
+        font_data->char_lookup_entries[i].char_index = -1;
+    }
+
+    for (int i = 0; i < font_data->font_count; i++)
+    {
+        for (int j = 0; j < font_data->char_counts[i]; j++)
+        {
+            const int char_index = font_data->chars_begin_indexes[i] + j;
+            const unsigned int codepoint = font_data->chars_codepoints[char_index];
+
+            int entry_index = get_font_char_lookup_hash(i, codepoint) & (font_data->char_lookup_cap - 1);
+
+            while (font_data->char_lookup_entries[entry_index].char_index != -1)
+            {
+                entry_index = (entry_index + 1) & (font_data->char_lookup_cap - 1);
+            }
+
+            zfw_font_char_lookup_entry_t *const entry = &font_data->char_lookup_entries[entry_index];
+            entry->font_index = i;
+            entry->codepoint = codepoint;
+            entry->char_index = char_index;
+        }
+    }
+
+    return ZFW_TRUE;
+}
+
+zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *const tex_data, zfw_user_shader_prog_data_t *const shader_prog_data, zfw_user_font_data_t *const font_data, const zfw_assets_file_mapping_t *const assets_file_mapping, const zfw_bool_t tex_array, zfw_mem_arena_t *const main_mem_arena)
+{
+    // Entries are found through the table of contents, and their data is used in place in the mapping wherever possible
+    // rather than being copied out.
+
+    //
+    // Texture Data
+    //
+    tex_data->gl_ids = NULL;
+    tex_data->array_gl_id = 0;
+    tex_data->array_size = zfw_create_vec_2d_i(0, 0);
+    tex_data->atlas_tex_user_tex_indexes = NULL;
+    tex_data->atlas_tex_src_rects = NULL;
+
+    tex_data->tex_count = get_assets_file_entry_count(assets_file_mapping, ZFW_ASSET_TYPE__TEX);
+
+    if (tex_data->tex_count)
+    {
         tex_data->sizes = zfw_mem_arena_alloc(main_mem_arena, sizeof(*tex_data->sizes) * tex_data->tex_count);
 
         if (!tex_data->sizes)
@@ -56,36 +484,170 @@ zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *co
             return ZFW_FALSE;
         }
 
+        // Read all texture sizes up front, skipping over pixel data, so that the size of the texture array is known before
+        // anything is uploaded.
+        int entry_index = 0;
+
         for (int i = 0; i < tex_data->tex_count; i++)
         {
-            fread(&tex_data->sizes[i], sizeof(tex_data->sizes[i]), 1, assets_file_fs);
+            assets_file_reader_t reader = get_assets_file_entry_reader(assets_file_mapping, get_next_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__TEX, &entry_index));
 
-            const int px_data_size = tex_data->sizes[i].x * tex_data->sizes[i].y * ZFW_TEX_CHANNEL_COUNT;
-            unsigned char *const px_data = zfw_mem_arena_alloc(main_mem_arena, px_data_size);
+            int tex_format;
 
-            if (!px_data)
+            if (!read_assets_file_val(&reader, &tex_data->sizes[i], sizeof(tex_data->sizes[i])) || !read_assets_file_val(&reader, &tex_format, sizeof(tex_format)) || !read_assets_file_bytes(&reader, zfw_get_tex_data_size(tex_data->sizes[i], tex_format)))
             {
-                zfw_log_error("Failed to allocate %d bytes for pixel data of user texture with index %d.", px_data_size, i);
                 return ZFW_FALSE;
             }
 
-            fread(px_data, sizeof(*px_data), px_data_size / sizeof(*px_data), assets_file_fs);
+            tex_data->array_size.x = ZFW_MAX(tex_data->sizes[i].x, tex_data->array_size.x);
+            tex_data->array_size.y = ZFW_MAX(tex_data->sizes[i].y, tex_data->array_size.y);
+        }
+
+        zfw_bool_t use_tex_array = tex_array && can_textures_fit_in_array(tex_data);
+
+        if (tex_array && !use_tex_array)
+        {
+            zfw_log_warning("User textures exceed the texture array limits of this device, so they will be loaded as separate textures.");
+        }
+
+        if (use_tex_array)
+        {
+            use_tex_array = is_tex_array_padding_acceptable(tex_data);
+        }
+
+        if (use_tex_array)
+        {
+            // Generate a single texture array with a layer for each texture, with smaller textures padded out to the size
+            // of the largest. Texture coordinates are relative to the layer, so source rectangles reaching outside of their
+            // texture show the padding rather than wrapping around the texture.
+            glGenTextures(1, &tex_data->array_gl_id);
+
+            glBindTexture(GL_TEXTURE_2D_ARRAY, tex_data->array_gl_id);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tex_data->array_size.x, tex_data->array_size.y, tex_data->tex_count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        else
+        {
+            tex_data->array_size = zfw_create_vec_2d_i(0, 0);
+
+            tex_data->gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*tex_data->gl_ids) * tex_data->tex_count);
+
+            if (!tex_data->gl_ids)
+            {
+                zfw_log_error("Failed to allocate %d bytes for texture OpenGL IDs!", sizeof(*tex_data->gl_ids) * tex_data->tex_count);
+                return ZFW_FALSE;
+            }
+
+            glGenTextures(tex_data->tex_count, tex_data->gl_ids);
+        }
+
+        const zfw_bool_t bc7_supported = is_compressed_tex_format_supported(GL_COMPRESSED_RGBA_BPTC_UNORM, main_mem_arena);
+
+        // Texture data is byte-sized, so it never needs copying out of the mapping for alignment.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        entry_index = 0;
+
+        for (int i = 0; i < tex_data->tex_count; i++)
+        {
+            assets_file_reader_t reader = get_assets_file_entry_reader(assets_file_mapping, get_next_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__TEX, &entry_index));
+
+            // Skip over the size, which has already been read.
+            reader.offs += sizeof(tex_data->sizes[i]);
+
+            int tex_format;
+            read_assets_file_val(&reader, &tex_format, sizeof(tex_format));
+
+            const int tex_data_size = zfw_get_tex_data_size(tex_data->sizes[i], tex_format);
+            const unsigned char *const file_tex_data = read_assets_file_bytes(&reader, tex_data_size);
+
+            // Compressed textures are decoded to RGBA if the device can't sample them directly, or if they're going into
+            // the texture array, which is always uncompressed. This is the only case where texture data is copied.
+            const zfw_bool_t decode = tex_format == ZFW_TEX_FORMAT__BC7 && (!bc7_supported || tex_data->array_gl_id);
+
+            const unsigned char *px_data = file_tex_data;
+
+            if (decode)
+            {
+                const int px_data_size = zfw_get_tex_data_size(tex_data->sizes[i], ZFW_TEX_FORMAT__RGBA8);
+                unsigned char *const decoded_px_data = zfw_mem_arena_alloc(main_mem_arena, px_data_size);
+
+                if (!decoded_px_data)
+                {
+                    zfw_log_error("Failed to allocate %d bytes for decoded pixel data of user texture with index %d.", px_data_size, i);
+                    return ZFW_FALSE;
+                }
+
+                zfw_decode_bc7(decoded_px_data, file_tex_data, tex_data->sizes[i]);
+                px_data = decoded_px_data;
+            }
+
+            if (tex_data->array_gl_id)
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, tex_data->sizes[i].x, tex_data->sizes[i].y, 1, GL_RGBA, GL_UNSIGNED_BYTE, px_data);
+            }
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, tex_data->gl_ids[i]);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+                if (tex_format == ZFW_TEX_FORMAT__BC7 && !decode)
+                {
+                    glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_BPTC_UNORM, tex_data->sizes[i].x, tex_data->sizes[i].y, 0, tex_data_size, px_data);
+                }
+                else
+                {
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex_data->sizes[i].x, tex_data->sizes[i].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, px_data);
+                }
+            }
 
-            glBindTexture(GL_TEXTURE_2D, tex_data->gl_ids[i]);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex_data->sizes[i].x, tex_data->sizes[i].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, px_data);
+            if (decode)
+            {
+                // The decoded pixel data is no longer needed in the arena, so rewind and allow it to be overwritten.
+                zfw_rewind_mem_arena(main_mem_arena);
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    //
+    // Atlas Texture Data
+    //
+    tex_data->atlas_tex_count = 0;
+
+    const zfw_assets_file_entry_t *const atlas_tex_lookup_entry = zfw_find_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__ATLAS_TEX_LOOKUP, zfw_get_asset_name_hash("atlas_tex_lookup"));
 
-            // The pixel data for this texture is no longer needed in the arena, so rewind and allow it to be
-            // overwritten.
-            zfw_rewind_mem_arena(main_mem_arena);
+    if (atlas_tex_lookup_entry)
+    {
+        assets_file_reader_t reader = get_assets_file_entry_reader(assets_file_mapping, atlas_tex_lookup_entry);
+
+        if (!read_assets_file_val(&reader, &tex_data->atlas_tex_count, sizeof(tex_data->atlas_tex_count)))
+        {
+            return ZFW_FALSE;
+        }
+
+        tex_data->atlas_tex_user_tex_indexes = read_assets_file_array(&reader, sizeof(*tex_data->atlas_tex_user_tex_indexes), _Alignof(int), tex_data->atlas_tex_count, main_mem_arena);
+
+        if (!tex_data->atlas_tex_user_tex_indexes)
+        {
+            return ZFW_FALSE;
+        }
+
+        tex_data->atlas_tex_src_rects = read_assets_file_array(&reader, sizeof(*tex_data->atlas_tex_src_rects), _Alignof(zfw_rect_t), tex_data->atlas_tex_count, main_mem_arena);
+
+        if (!tex_data->atlas_tex_src_rects)
+        {
+            return ZFW_FALSE;
         }
     }
 
     //
     // Shader Program Data
     //
-    fread(&shader_prog_data->prog_count, sizeof(shader_prog_data->prog_count), 1, assets_file_fs);
+    shader_prog_data->prog_count = get_assets_file_entry_count(assets_file_mapping, ZFW_ASSET_TYPE__SHADER_PROG);
 
     if (shader_prog_data->prog_count)
     {
@@ -97,121 +659,150 @@ zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *co
             return ZFW_FALSE;
         }
 
+        int entry_index = 0;
+
         for (int i = 0; i < shader_prog_data->prog_count; i++)
         {
-            char vert_shader_src_buf[ZFW_SHADER_SRC_BUF_SIZE];
-            fread(vert_shader_src_buf, sizeof(*vert_shader_src_buf), sizeof(vert_shader_src_buf) / sizeof(*vert_shader_src_buf), assets_file_fs);
+            assets_file_reader_t reader = get_assets_file_entry_reader(assets_file_mapping, get_next_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__SHADER_PROG, &entry_index));
 
-            char frag_shader_src_buf[ZFW_SHADER_SRC_BUF_SIZE];
-            fread(frag_shader_src_buf, sizeof(*frag_shader_src_buf), sizeof(frag_shader_src_buf) / sizeof(*frag_shader_src_buf), assets_file_fs);
+            // The source buffers are zero-padded by the packer, so they can be compiled straight from the mapping.
+            const char *const vert_shader_src = (const char *)read_assets_file_bytes(&reader, ZFW_SHADER_SRC_BUF_SIZE);
+            const char *const frag_shader_src = (const char *)read_assets_file_bytes(&reader, ZFW_SHADER_SRC_BUF_SIZE);
 
-            zfw_gen_shader_prog(&shader_prog_data->gl_ids[i], vert_shader_src_buf, frag_shader_src_buf);
+            if (!vert_shader_src || !frag_shader_src)
+            {
+                return ZFW_FALSE;
+            }
+
+            zfw_gen_shader_prog(&shader_prog_data->gl_ids[i], vert_shader_src, frag_shader_src);
         }
     }
 
     //
     // Font Data
     //
-    fread(&font_data->font_count, sizeof(font_data->font_count), 1, assets_file_fs);
+    font_data->font_count = 0;
+
+    const zfw_assets_file_entry_t *const font_metrics_entry = zfw_find_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__FONT_METRICS, zfw_get_asset_name_hash("font_metrics"));
 
-    if (font_data->font_count)
+    if (font_metrics_entry)
     {
-        // Allocate memory for and retrieve font line heights.
+        assets_file_reader_t reader = get_assets_file_entry_reader(assets_file_mapping, font_metrics_entry);
+
+        if (!read_assets_file_val(&reader, &font_data->font_count, sizeof(font_data->font_count)))
         {
-            const int line_height_count = font_data->font_count;
-            font_data->line_heights = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->line_heights) * line_height_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->line_heights)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font line heights!", sizeof(*font_data->line_heights) * line_height_count);
-                return ZFW_FALSE;
-            }
+        if (get_assets_file_entry_count(assets_file_mapping, ZFW_ASSET_TYPE__FONT_TEX) != font_data->font_count)
+        {
+            zfw_log_error("The number of font textures in the assets file doesn't match the number of fonts!");
+            return ZFW_FALSE;
+        }
 
-            fread(font_data->line_heights, sizeof(*font_data->line_heights), line_height_count, assets_file_fs);
+        int char_count;
+        int kerning_pair_count;
+
+        if (!read_assets_file_val(&reader, &char_count, sizeof(char_count)) || !read_assets_file_val(&reader, &kerning_pair_count, sizeof(kerning_pair_count)))
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font character horizontal offsets.
+        // Point font metrics into the mapping.
+        font_data->line_heights = read_assets_file_array(&reader, sizeof(*font_data->line_heights), _Alignof(int), font_data->font_count, main_mem_arena);
+
+        if (!font_data->line_heights)
         {
-            const int hor_offs_count = ZFW_FONT_CHAR_RANGE_SIZE * font_data->font_count;
-            font_data->chars_hor_offsets = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->chars_hor_offsets) * hor_offs_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->chars_hor_offsets)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font character horizontal offsets!", sizeof(*font_data->chars_hor_offsets) * hor_offs_count);
-                return ZFW_FALSE;
-            }
+        font_data->chars_begin_indexes = read_assets_file_array(&reader, sizeof(*font_data->chars_begin_indexes), _Alignof(int), font_data->font_count, main_mem_arena);
 
-            fread(font_data->chars_hor_offsets, sizeof(*font_data->chars_hor_offsets), hor_offs_count, assets_file_fs);
+        if (!font_data->chars_begin_indexes)
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font character vertical offsets.
+        font_data->char_counts = read_assets_file_array(&reader, sizeof(*font_data->char_counts), _Alignof(int), font_data->font_count, main_mem_arena);
+
+        if (!font_data->char_counts)
         {
-            const int vert_offs_count = ZFW_FONT_CHAR_RANGE_SIZE * font_data->font_count;
-            font_data->chars_vert_offsets = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->chars_vert_offsets) * vert_offs_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->chars_vert_offsets)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font character vertical offsets!", sizeof(*font_data->chars_vert_offsets) * vert_offs_count);
-                return ZFW_FALSE;
-            }
+        font_data->chars_codepoints = read_assets_file_array(&reader, sizeof(*font_data->chars_codepoints), _Alignof(unsigned int), char_count, main_mem_arena);
 
-            fread(font_data->chars_vert_offsets, sizeof(*font_data->chars_vert_offsets), vert_offs_count, assets_file_fs);
+        if (!font_data->chars_codepoints)
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font character horizontal advances.
+        font_data->chars_hor_offsets = read_assets_file_array(&reader, sizeof(*font_data->chars_hor_offsets), _Alignof(font_char_hor_offs_t), char_count, main_mem_arena);
+
+        if (!font_data->chars_hor_offsets)
         {
-            const int hor_advance_count = ZFW_FONT_CHAR_RANGE_SIZE * font_data->font_count;
-            font_data->chars_hor_advances = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->chars_hor_advances) * hor_advance_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->chars_hor_advances)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font character horizontal advances!", sizeof(*font_data->chars_hor_advances) * hor_advance_count);
-                return ZFW_FALSE;
-            }
+        font_data->chars_vert_offsets = read_assets_file_array(&reader, sizeof(*font_data->chars_vert_offsets), _Alignof(font_char_vert_offs_t), char_count, main_mem_arena);
 
-            fread(font_data->chars_hor_advances, sizeof(*font_data->chars_hor_advances), hor_advance_count, assets_file_fs);
+        if (!font_data->chars_vert_offsets)
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font character source rectangles.
+        font_data->chars_hor_advances = read_assets_file_array(&reader, sizeof(*font_data->chars_hor_advances), _Alignof(font_char_hor_advance_t), char_count, main_mem_arena);
+
+        if (!font_data->chars_hor_advances)
         {
-            const int src_rect_count = ZFW_FONT_CHAR_RANGE_SIZE * font_data->font_count;
-            font_data->chars_src_rects = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->chars_src_rects) * src_rect_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->chars_src_rects)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font character source rectangles!", sizeof(*font_data->chars_src_rects) * src_rect_count);
-                return ZFW_FALSE;
-            }
+        font_data->chars_src_rects = read_assets_file_array(&reader, sizeof(*font_data->chars_src_rects), _Alignof(font_char_src_rect_t), char_count, main_mem_arena);
 
-            fread(font_data->chars_src_rects, sizeof(*font_data->chars_src_rects), src_rect_count, assets_file_fs);
+        if (!font_data->chars_src_rects)
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font character kernings.
+        font_data->kerning_pairs_begin_indexes = read_assets_file_array(&reader, sizeof(*font_data->kerning_pairs_begin_indexes), _Alignof(int), font_data->font_count, main_mem_arena);
+
+        if (!font_data->kerning_pairs_begin_indexes)
         {
-            const int kerning_count = ZFW_FONT_CHAR_RANGE_SIZE * ZFW_FONT_CHAR_RANGE_SIZE * font_data->font_count;
-            font_data->chars_kernings = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->chars_kernings) * kerning_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->chars_kernings)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font character kernings!", sizeof(*font_data->chars_kernings) * kerning_count);
-                return ZFW_FALSE;
-            }
+        font_data->kerning_pair_counts = read_assets_file_array(&reader, sizeof(*font_data->kerning_pair_counts), _Alignof(int), font_data->font_count, main_mem_arena);
 
-            fread(font_data->chars_kernings, sizeof(*font_data->chars_kernings), kerning_count, assets_file_fs);
+        if (!font_data->kerning_pair_counts)
+        {
+            return ZFW_FALSE;
         }
 
-        // Allocate memory for and retrieve font texture sizes.
+        font_data->kerning_pairs = read_assets_file_array(&reader, sizeof(*font_data->kerning_pairs), _Alignof(font_char_kerning_pair_t), kerning_pair_count, main_mem_arena);
+
+        if (!font_data->kerning_pairs)
         {
-            const int tex_size_count = font_data->font_count;
-            font_data->tex_sizes = zfw_mem_arena_alloc(main_mem_arena, sizeof(*font_data->tex_sizes) * tex_size_count);
+            return ZFW_FALSE;
+        }
 
-            if (!font_data->tex_sizes)
-            {
-                zfw_log_error("Failed to allocate %d bytes for font texture sizes!", sizeof(*font_data->tex_sizes) * tex_size_count);
-                return ZFW_FALSE;
-            }
+        if (!build_font_char_lookup(font_data, char_count, main_mem_arena))
+        {
+            return ZFW_FALSE;
+        }
+
+        font_data->tex_sizes = read_assets_file_array(&reader, sizeof(*font_data->tex_sizes), _Alignof(zfw_vec_2d_i_t), font_data->font_count, main_mem_arena);
 
-            fread(font_data->tex_sizes, sizeof(*font_data->tex_sizes), tex_size_count, assets_file_fs);
+        if (!font_data->tex_sizes)
+        {
+            return ZFW_FALSE;
+        }
+
+        font_data->sdfs = read_assets_file_array(&reader, sizeof(*font_data->sdfs), _Alignof(zfw_bool_t), font_data->font_count, main_mem_arena);
+
+        if (!font_data->sdfs)
+        {
+            return ZFW_FALSE;
         }
 
         // Allocate memory for OpenGL texture IDs and generate the textures.
@@ -225,29 +816,92 @@ zfw_bool_t zfw_retrieve_user_asset_data_from_assets_file(zfw_user_tex_data_t *co
 
         glGenTextures(font_data->font_count, font_data->tex_gl_ids);
 
-        // Finish generating the font textures using pixel data in the file.
+        // Finish generating the font textures using pixel data straight from the mapping.
+        int tex_size_limit;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &tex_size_limit);
+
+        int entry_index = 0;
+
         for (int i = 0; i < font_data->font_count; i++)
         {
+            if (font_data->tex_sizes[i].x > tex_size_limit || font_data->tex_sizes[i].y > tex_size_limit)
+            {
+                zfw_log_error("A font texture of size %dx%d exceeds the device texture size limit of %d!", font_data->tex_sizes[i].x, font_data->tex_sizes[i].y, tex_size_limit);
+                return ZFW_FALSE;
+            }
+
+            assets_file_reader_t tex_reader = get_assets_file_entry_reader(assets_file_mapping, get_next_assets_file_entry(assets_file_mapping, ZFW_ASSET_TYPE__FONT_TEX, &entry_index));
+
             const int px_data_size = font_data->tex_sizes[i].x * font_data->tex_sizes[i].y * ZFW_FONT_TEX_CHANNEL_COUNT;
-            unsigned char *const px_data = zfw_mem_arena_alloc(main_mem_arena, px_data_size);
+            const unsigned char *const px_data = read_assets_file_bytes(&tex_reader, px_data_size);
 
             if (!px_data)
             {
-                zfw_log_error("Failed to allocate %d bytes for font texture pixel data of font with index %d.", px_data_size, i);
                 return ZFW_FALSE;
             }
 
-            fread(px_data, sizeof(*px_data), px_data_size / sizeof(*px_data), assets_file_fs);
+            // Signed distance fields are interpolated between texels, which is what lets them scale without blurring.
+            const GLint filter = font_data->sdfs[i] ? GL_LINEAR : GL_NEAREST;
 
             glBindTexture(GL_TEXTURE_2D, font_data->tex_gl_ids[i]);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, font_data->tex_sizes[i].x, font_data->tex_sizes[i].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, px_data);
-
-            // The pixel data for this font texture is no longer needed in the arena, so rewind and allow it to be overwritten.
-            zfw_rewind_mem_arena(main_mem_arena);
         }
     }
 
     return ZFW_TRUE;
 }
+
+// Returns the index of the character of a font with the given codepoint, or -1 if the font doesn't have it.
+int zfw_find_font_char_index(const zfw_user_font_data_t *const font_data, const int font_index, const unsigned int codepoint)
+{
+    int entry_index = get_font_char_lookup_hash(font_index, codepoint) & (font_data->char_lookup_cap - 1);
+
+    while (font_data->char_lookup_entries[entry_index].char_index != -1)
+    {
+        const zfw_font_char_lookup_entry_t *const entry = &font_data->char_lookup_entries[entry_index];
+
+        if (entry->font_index == font_index && entry->codepoint == codepoint)
+        {
+            return entry->char_index;
+        }
+
+        entry_index = (entry_index + 1) & (font_data->char_lookup_cap - 1);
+    }
+
+    return -1;
+}
+
+// Returns the kerning to apply between two characters of a font, given by their indexes.
+int zfw_get_font_chars_kerning(const zfw_user_font_data_t *const font_data, const int font_index, const int left_char_index, const int right_char_index)
+{
+    const int chars_begin_index = font_data->chars_begin_indexes[font_index];
+    const unsigned int key = ((unsigned int)(left_char_index - chars_begin_index) << 16) | (right_char_index - chars_begin_index);
+
+    // Binary search the pairs of the font, which are sorted by key.
+    const font_char_kerning_pair_t *const pairs = font_data->kerning_pairs + font_data->kerning_pairs_begin_indexes[font_index];
+
+    int low = 0;
+    int high = font_data->kerning_pair_counts[font_index] - 1;
+
+    while (low <= high)
+    {
+        const int mid = low + ((high - low) / 2);
+
+        if (pairs[mid].char_indexes_key < key)
+        {
+            low = mid + 1;
+        }
+        else if (pairs[mid].char_indexes_key > key)
+        {
+            high = mid - 1;
+        }
+        else
+        {
+            return pairs[mid].kerning;
+        }
+    }
+
+    return 0;
+}
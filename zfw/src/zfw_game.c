@@ -1,11 +1,14 @@
 #include <zfw_game.h>
 
+#include <stdio.h>
 #include <time.h>
 #include <GLFW/glfw3.h>
 #include <zfw_common_debug.h>
 
-#define TARG_TICKS_PER_SEC 60
-#define TARG_TICK_INTERVAL (1.0 / TARG_TICKS_PER_SEC)
+#define PROFILER_OVERLAY_TEXT_SIZE 512
+#define PROFILER_OVERLAY_UPDATE_INTERVAL 30 // The number of frames between updates of the overlay text, so that it stays readable.
+#define PROFILER_OVERLAY_MARGIN 8.0f
+#define PROFILER_OVERLAY_RENDER_LAYER_INDEX (ZFW_RENDER_LAYER_LIMIT - 1)
 
 typedef struct
 {
@@ -13,6 +16,7 @@ typedef struct
 
     GLFWwindow *glfw_window;
 
+    zfw_assets_file_mapping_t *assets_file_mapping;
     zfw_user_tex_data_t *user_tex_data;
     zfw_user_shader_prog_data_t *user_shader_prog_data;
     zfw_user_font_data_t *user_font_data;
@@ -22,6 +26,15 @@ typedef struct
     int sprite_batch_groups_cleanup_count;
 
     zfw_char_batch_group_t *char_batch_group;
+
+    zfw_sprite_queue_t *sprite_queue;
+
+    zfw_profiler_t *profiler;
+
+    zfw_render_capture_t *render_capture;
+
+    zfw_offscreen_target_t *offscreen_target;
+    unsigned char *headless_frame_pixels;
 } game_cleanup_data_t;
 
 typedef struct
@@ -31,6 +44,12 @@ typedef struct
     zfw_bool_t fullscreen;
 } window_state_t;
 
+typedef struct
+{
+    zfw_char_batch_key_t char_batch_key;
+    int frames_until_update;
+} profiler_overlay_t;
+
 typedef struct
 {
     window_state_t *const window_state;
@@ -43,7 +62,32 @@ static void clean_game(game_cleanup_data_t *const cleanup_data)
 {
     zfw_log("Cleaning up...");
 
-    // Clean sprite and character batch groups.
+    // Clean headless data.
+    free(cleanup_data->headless_frame_pixels);
+
+    if (cleanup_data->offscreen_target)
+    {
+        zfw_clean_offscreen_target(cleanup_data->offscreen_target);
+    }
+
+    // End the render capture early if it's still going.
+    if (cleanup_data->render_capture)
+    {
+        zfw_end_render_capture(cleanup_data->render_capture);
+    }
+
+    // Clean the profiler.
+    if (cleanup_data->profiler)
+    {
+        zfw_clean_profiler(cleanup_data->profiler);
+    }
+
+    // Clean the sprite queue and sprite and character batch groups.
+    if (cleanup_data->sprite_queue)
+    {
+        zfw_clean_sprite_queue(cleanup_data->sprite_queue);
+    }
+
     if (cleanup_data->char_batch_group)
     {
         zfw_clean_char_batch_group(cleanup_data->char_batch_group);
@@ -57,6 +101,7 @@ static void clean_game(game_cleanup_data_t *const cleanup_data)
     // Clean built-in shader program data.
     if (cleanup_data->builtin_shader_prog_data)
     {
+        glDeleteProgram(cleanup_data->builtin_shader_prog_data->char_quad_sdf_prog_gl_id);
         glDeleteProgram(cleanup_data->builtin_shader_prog_data->char_quad_prog_gl_id);
         glDeleteProgram(cleanup_data->builtin_shader_prog_data->sprite_quad_prog_gl_id);
     }
@@ -80,6 +125,16 @@ static void clean_game(game_cleanup_data_t *const cleanup_data)
         glDeleteTextures(cleanup_data->user_tex_data->tex_count, cleanup_data->user_tex_data->gl_ids);
     }
 
+    if (cleanup_data->user_tex_data && cleanup_data->user_tex_data->array_gl_id)
+    {
+        glDeleteTextures(1, &cleanup_data->user_tex_data->array_gl_id);
+    }
+
+    if (cleanup_data->assets_file_mapping)
+    {
+        zfw_unmap_assets_file(cleanup_data->assets_file_mapping);
+    }
+
     // Uninitialise GLFW.
     if (cleanup_data->glfw_window)
     {
@@ -95,14 +150,80 @@ static void clean_game(game_cleanup_data_t *const cleanup_data)
     }
 }
 
-static double calc_frame_time_change(const double frame_time, const double frame_time_last)
+static zfw_bool_t init_profiler_overlay(profiler_overlay_t *const overlay, const int user_font_index, zfw_char_batch_group_t *const char_batch_group, const zfw_user_font_data_t *const user_font_data)
+{
+    if (user_font_index < 0 || user_font_index >= user_font_data->font_count)
+    {
+        zfw_log_error("The profiler overlay user font index of %d is invalid!", user_font_index);
+        return ZFW_FALSE;
+    }
+
+    overlay->char_batch_key = zfw_take_render_layer_char_batch(PROFILER_OVERLAY_RENDER_LAYER_INDEX, char_batch_group);
+
+    if (!zfw_is_char_batch_slot_key_active(overlay->char_batch_key))
+    {
+        zfw_log_error("Failed to take a character batch for the profiler overlay!");
+        return ZFW_FALSE;
+    }
+
+    zfw_set_render_layer_char_batch_user_font_index(overlay->char_batch_key, user_font_index, char_batch_group);
+    zfw_set_render_layer_char_batch_pos(overlay->char_batch_key, zfw_create_vec_2d(PROFILER_OVERLAY_MARGIN, PROFILER_OVERLAY_MARGIN), char_batch_group);
+
+    overlay->frames_until_update = 0;
+
+    return ZFW_TRUE;
+}
+
+static void update_profiler_overlay(profiler_overlay_t *const overlay, const zfw_profiler_t *const profiler, zfw_char_batch_group_t *const char_batch_group, const zfw_user_font_data_t *const user_font_data)
+{
+    if (overlay->frames_until_update > 0)
+    {
+        overlay->frames_until_update--;
+        return;
+    }
+
+    overlay->frames_until_update = PROFILER_OVERLAY_UPDATE_INTERVAL;
+
+    const zfw_profiler_frame_t *const frame = &profiler->last_frame;
+
+    // Sum the GPU layer times of each batch group.
+    double gpu_group_times[ZFW_SPRITE_BATCH_GROUP_COUNT] = {0};
+
+    for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
+    {
+        for (int j = 0; j < ZFW_RENDER_LAYER_LIMIT; j++)
+        {
+            gpu_group_times[i] += frame->gpu_timer_times[zfw_get_render_layer_gpu_timer_index(i, j)];
+        }
+    }
+
+    char text[PROFILER_OVERLAY_TEXT_SIZE];
+
+    snprintf(text, sizeof(text),
+        "Frame %.2f ms\n"
+        "CPU events %.2f ticks %.2f queue %.2f ms\n"
+        "CPU render %.2f swap %.2f ms\n"
+        "GPU view %.2f screen %.2f ms\n"
+        "Draws %d uploads %d (%d KB)\n"
+        "Batches %d/%d slots %d queued %d",
+        frame->time * 1000.0,
+        frame->cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_ID__EVENTS] * 1000.0, frame->cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_ID__TICKS] * 1000.0, frame->cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_ID__SPRITE_QUEUE_PREP] * 1000.0,
+        frame->cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_ID__RENDER] * 1000.0, frame->cpu_scope_times[ZFW_PROFILER_CPU_SCOPE_ID__SWAP_BUFFERS] * 1000.0,
+        gpu_group_times[ZFW_SPRITE_BATCH_GROUP_ID__VIEW] * 1000.0, gpu_group_times[ZFW_SPRITE_BATCH_GROUP_ID__SCREEN] * 1000.0,
+        frame->counters.draw_call_count, frame->counters.buf_upload_count, frame->counters.buf_upload_size / 1024,
+        frame->counters.active_sprite_batch_count, frame->counters.active_char_batch_count, frame->counters.live_sprite_batch_slot_count, frame->counters.sprite_queue_cmd_count);
+
+    zfw_write_to_render_layer_char_batch(overlay->char_batch_key, text, ZFW_FONT_HOR_ALIGN__LEFT, ZFW_FONT_VERT_ALIGN__TOP, char_batch_group, user_font_data);
+}
+
+static double calc_frame_time_change(const double frame_time, const double frame_time_last, const double tick_interval)
 {
     double change = frame_time - frame_time_last;
 
     // Handle frame time anomalies.
-    if (change > TARG_TICK_INTERVAL * 8)
+    if (change > tick_interval * 8)
     {
-        change = TARG_TICK_INTERVAL;
+        change = tick_interval;
     }
 
     if (change < 0.0)
@@ -230,6 +351,14 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
 
     cleanup_data.main_mem_arena = &main_mem_arena;
 
+#ifdef GLFW_PLATFORM_NULL
+    // When headless, use the GLFW null platform so that no display is needed.
+    if (user_run_info->headless)
+    {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
+
     // Initialise GLFW.
     if (!glfwInit())
     {
@@ -246,7 +375,25 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-    GLFWwindow *const glfw_window = glfwCreateWindow(user_run_info->init_window_size.x, user_run_info->init_window_size.y, user_run_info->init_window_title, NULL, NULL);
+#ifdef GLFW_PLATFORM_NULL
+    if (user_run_info->headless)
+    {
+        // The null platform needs a context API that works without a display. A surfaceless EGL context is tried first
+        // as it can still be hardware-accelerated, with OSMesa as the software fallback.
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
+#endif
+
+    GLFWwindow *glfw_window = glfwCreateWindow(user_run_info->init_window_size.x, user_run_info->init_window_size.y, user_run_info->init_window_title, NULL, NULL);
+
+#ifdef GLFW_PLATFORM_NULL
+    if (!glfw_window && user_run_info->headless)
+    {
+        zfw_log("Failed to create an EGL context, trying OSMesa...");
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        glfw_window = glfwCreateWindow(user_run_info->init_window_size.x, user_run_info->init_window_size.y, user_run_info->init_window_title, NULL, NULL);
+    }
+#endif
 
     if (!glfw_window)
     {
@@ -261,6 +408,8 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
 
     glfwMakeContextCurrent(glfw_window);
 
+    glfwSwapInterval(user_run_info->disable_vsync ? 0 : 1);
+
     // Initialise the window state.
     window_state_t window_state = {0};
     glfwGetWindowSize(glfw_window, &window_state.size.x, &window_state.size.y);
@@ -311,25 +460,24 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
     zfw_user_tex_data_t user_tex_data;
     zfw_user_shader_prog_data_t user_shader_prog_data;
     zfw_user_font_data_t user_font_data;
+    zfw_assets_file_mapping_t assets_file_mapping;
 
     {
-        FILE *const assets_file_fs = fopen(ZFW_ASSETS_FILE_NAME, "rb");
-
-        if (!assets_file_fs)
+        // The asset data points into the mapped file, so it stays mapped until the game is cleaned up.
+        if (!zfw_map_assets_file(&assets_file_mapping, ZFW_ASSETS_FILE_NAME))
         {
-            zfw_log_error("Failed to open assets file \"%s\"!", ZFW_ASSETS_FILE_NAME);
+            zfw_log_error("Failed to map assets file \"%s\"!", ZFW_ASSETS_FILE_NAME);
             clean_game(&cleanup_data);
             return ZFW_FALSE;
         }
 
+        cleanup_data.assets_file_mapping = &assets_file_mapping;
         cleanup_data.user_tex_data = &user_tex_data;
         cleanup_data.user_shader_prog_data = &user_shader_prog_data;
         cleanup_data.user_font_data = &user_font_data;
 
         zfw_log("Retrieving user asset data from \"%s\"...", ZFW_ASSETS_FILE_NAME);
-        const zfw_bool_t asset_data_read_successful = zfw_retrieve_user_asset_data_from_assets_file(&user_tex_data, &user_shader_prog_data, &user_font_data, assets_file_fs, &main_mem_arena);
-
-        fclose(assets_file_fs);
+        const zfw_bool_t asset_data_read_successful = zfw_retrieve_user_asset_data_from_assets_file(&user_tex_data, &user_shader_prog_data, &user_font_data, &assets_file_mapping, user_run_info->tex_array, &main_mem_arena);
 
         if (!asset_data_read_successful)
         {
@@ -341,13 +489,26 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
     // Initialise built-in shader programs.
     zfw_builtin_shader_prog_data_t builtin_shader_prog_data = {0};
 
-    zfw_gen_shader_prog(&builtin_shader_prog_data.sprite_quad_prog_gl_id, ZFW_BUILTIN_SPRITE_QUAD_VERT_SHADER_SRC, ZFW_BUILTIN_SPRITE_QUAD_FRAG_SHADER_SRC);
+    zfw_gen_shader_prog(&builtin_shader_prog_data.sprite_quad_prog_gl_id, ZFW_BUILTIN_SPRITE_QUAD_VERT_SHADER_SRC, user_tex_data.array_gl_id ? ZFW_BUILTIN_SPRITE_QUAD_TEX_ARRAY_FRAG_SHADER_SRC : ZFW_BUILTIN_SPRITE_QUAD_FRAG_SHADER_SRC);
     zfw_gen_shader_prog(&builtin_shader_prog_data.char_quad_prog_gl_id, ZFW_BUILTIN_CHAR_QUAD_VERT_SHADER_SRC, ZFW_BUILTIN_CHAR_QUAD_FRAG_SHADER_SRC);
+    zfw_gen_shader_prog(&builtin_shader_prog_data.char_quad_sdf_prog_gl_id, ZFW_BUILTIN_CHAR_QUAD_VERT_SHADER_SRC, ZFW_BUILTIN_CHAR_QUAD_SDF_FRAG_SHADER_SRC);
 
     zfw_log("Initialized built-in shader programs!");
 
     cleanup_data.builtin_shader_prog_data = &builtin_shader_prog_data;
 
+    // Set up the render context.
+    zfw_render_context_t render_context;
+
+    if (!zfw_init_render_context(&render_context, &builtin_shader_prog_data, &user_shader_prog_data, &main_mem_arena))
+    {
+        zfw_log("Failed to initialize the render context!");
+        clean_game(&cleanup_data);
+        return ZFW_FALSE;
+    }
+
+    zfw_log("Successfully set up the render context!");
+
     // Set up blending.
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -358,7 +519,7 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
 
     for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
     {
-        if (!zfw_init_sprite_batch_group(&sprite_batch_groups[i], &main_mem_arena))
+        if (!zfw_init_sprite_batch_group(&sprite_batch_groups[i], &render_context, &user_tex_data, &main_mem_arena))
         {
             zfw_log("Failed to initialize a sprite batch group!");
             clean_game(&cleanup_data);
@@ -388,10 +549,98 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
 
     zfw_log("Successfully set up the character batch group!");
 
+    // Set up the sprite queue.
+    zfw_sprite_queue_t sprite_queue;
+
+    cleanup_data.sprite_queue = &sprite_queue;
+
+    if (!zfw_init_sprite_queue(&sprite_queue, &user_tex_data, &user_shader_prog_data))
+    {
+        zfw_log("Failed to initialize the sprite queue!");
+        clean_game(&cleanup_data);
+        return ZFW_FALSE;
+    }
+
+    zfw_log("Successfully set up the sprite queue!");
+
+    // Set up the offscreen target if headless, which stays bound for the rest of the game since nothing else binds a framebuffer.
+    zfw_offscreen_target_t offscreen_target;
+
+    if (user_run_info->headless)
+    {
+        cleanup_data.offscreen_target = &offscreen_target;
+
+        if (!zfw_init_offscreen_target(&offscreen_target, window_state.size))
+        {
+            clean_game(&cleanup_data);
+            return ZFW_FALSE;
+        }
+
+        zfw_bind_offscreen_target(&offscreen_target);
+
+        if (user_run_info->on_headless_frame_func)
+        {
+            const int pixels_size = window_state.size.x * window_state.size.y * 4;
+            cleanup_data.headless_frame_pixels = malloc(pixels_size);
+
+            if (!cleanup_data.headless_frame_pixels)
+            {
+                zfw_log_error("Failed to allocate %d bytes for headless frame pixels!", pixels_size);
+                clean_game(&cleanup_data);
+                return ZFW_FALSE;
+            }
+        }
+
+        zfw_log("Successfully set up a %dx%d offscreen target for running headless!", window_state.size.x, window_state.size.y);
+    }
+
+    // Begin the render capture if requested, before anything is done through the renderer.
+    zfw_render_capture_t render_capture;
+
+    if (user_run_info->render_capture_file_name)
+    {
+        if (!zfw_begin_render_capture(&render_capture, user_run_info->render_capture_file_name, user_run_info->render_capture_frame_count, user_tex_data.array_gl_id != 0))
+        {
+            clean_game(&cleanup_data);
+            return ZFW_FALSE;
+        }
+
+        cleanup_data.render_capture = &render_capture;
+
+        for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
+        {
+            sprite_batch_groups[i].capture = &render_capture;
+        }
+
+        char_batch_group.capture = &render_capture;
+        sprite_queue.capture = &render_capture;
+
+        zfw_log("Capturing %d frames of the render stream to \"%s\"...", user_run_info->render_capture_frame_count, user_run_info->render_capture_file_name);
+    }
+
+    // Set up the profiler.
+    zfw_profiler_t profiler;
+    zfw_init_profiler(&profiler, user_run_info->profiling);
+
+    cleanup_data.profiler = &profiler;
+
+    profiler_overlay_t profiler_overlay;
+    zfw_bool_t profiler_overlay_active = ZFW_FALSE;
+
+    if (user_run_info->profiling && user_run_info->profiler_overlay)
+    {
+        profiler_overlay_active = init_profiler_overlay(&profiler_overlay, user_run_info->profiler_overlay_user_font_index, &char_batch_group, &user_font_data);
+    }
+
     // Set up the view state.
     zfw_view_state_t view_state;
     zfw_set_view_state_defaults(&view_state);
 
+    // Work out the tick and frame intervals. Running headless and unthrottled ignores any frame rate cap.
+    const double tick_interval = 1.0 / (user_run_info->ticks_per_sec > 0 ? user_run_info->ticks_per_sec : ZFW_DEFAULT_TICKS_PER_SEC);
+    const zfw_bool_t unthrottled = user_run_info->headless && user_run_info->headless_unthrottled;
+    const double frame_interval = user_run_info->frame_rate_cap > 0 && !unthrottled ? 1.0 / user_run_info->frame_rate_cap : 0.0; // 0 if there's no cap.
+
     // This represents whether or not the user wants the window to be in fullscreen, assignable by them through pointers passed into their game functions. The actual state will not be updated until a specific point in the main loop.
     zfw_bool_t user_window_fullscreen = user_run_info->init_window_fullscreen;
 
@@ -403,36 +652,60 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
     user_func_data.main_mem_arena = &main_mem_arena;
     user_func_data.window_size = window_state.size;
     user_func_data.window_fullscreen = &user_window_fullscreen;
+    user_func_data.tick_interval = tick_interval;
     user_func_data.input_state = &input_state;
     user_func_data.input_state_last = &last_tick_input_state;
     user_func_data.user_tex_data = &user_tex_data;
     user_func_data.user_shader_prog_data = &user_shader_prog_data;
     user_func_data.user_font_data = &user_font_data;
+    user_func_data.render_context = &render_context;
     user_func_data.sprite_batch_groups = sprite_batch_groups;
     user_func_data.char_batch_group = &char_batch_group;
+    user_func_data.sprite_queue = &sprite_queue;
     user_func_data.view_state = &view_state;
+    user_func_data.profiler = &profiler;
 
     // Run the user-defined game initialisation function.
     user_run_info->on_init_func(user_run_info->user_ptr, &user_func_data);
 
     // Show the window now that initialisation is complete.
-    zfw_log("Showing the GLFW window...");
-    glfwShowWindow(glfw_window);
+    if (!user_run_info->headless)
+    {
+        zfw_log("Showing the GLFW window...");
+        glfwShowWindow(glfw_window);
+    }
 
     //
     // Main Loop
     //
     double frame_time = glfwGetTime();
-    double frame_time_change_accum = TARG_TICK_INTERVAL; // The assignment here ensures that a tick is always run on the first frame.
+    double frame_time_change_accum = tick_interval; // The assignment here ensures that a tick is always run on the first frame.
+    double frame_render_time_next = frame_time; // When the next frame is due, if there's a frame rate cap.
 
     window_state_t window_prefullscreen_state; // To be a copy of the window state prior to switching from windowed mode to fullscreen, so that this state can be returned to when switching back.
 
+    // The remaining number of ticks to run if headless with a tick limit, or -1 if there's no limit.
+    int headless_ticks_left = user_run_info->headless && user_run_info->headless_tick_limit > 0 ? user_run_info->headless_tick_limit : -1;
+
     zfw_log("Entering the main loop...");
 
-    while (!glfwWindowShouldClose(glfw_window))
+    while (!glfwWindowShouldClose(glfw_window) && headless_ticks_left != 0)
     {
         const zfw_vec_2d_i_t window_size_last = window_state.size;
 
+        // With a frame rate cap, wait until the next frame is due rather than spinning, but still wake for events.
+        if (frame_interval > 0.0)
+        {
+            const double frame_wait_time = frame_render_time_next - glfwGetTime();
+
+            if (frame_wait_time > 0.0)
+            {
+                glfwWaitEventsTimeout(frame_wait_time);
+            }
+        }
+
+        zfw_begin_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__EVENTS);
+
         glfwPollEvents();
 
         if (user_run_info->on_window_resize_func && (window_state.size.x != window_size_last.x || window_state.size.y != window_size_last.y))
@@ -444,22 +717,47 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
 
         zfw_update_gamepad_state(&input_state);
 
+        zfw_end_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__EVENTS);
+
         // Update frame time data.
         const double frame_time_last = frame_time;
         frame_time = glfwGetTime();
-        const double frame_time_change = calc_frame_time_change(frame_time, frame_time_last);
-        frame_time_change_accum += frame_time_change;
+        const double frame_time_change = calc_frame_time_change(frame_time, frame_time_last, tick_interval);
+
+        // When running unthrottled, exactly one tick is run per frame regardless of how much real time has passed.
+        frame_time_change_accum += unthrottled ? tick_interval : frame_time_change;
 
         // Calculate tick count and handle the case where at least one tick occurred.
-        const int tick_count = (int)(frame_time_change_accum / TARG_TICK_INTERVAL);
+        int tick_count = (int)(frame_time_change_accum / tick_interval);
+
+        if (headless_ticks_left != -1 && tick_count > headless_ticks_left)
+        {
+            tick_count = headless_ticks_left;
+        }
 
         if (tick_count > 0)
         {
             // Run the ticks.
+            zfw_begin_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__TICKS);
+
             for (int i = 0; i < tick_count; i++)
             {
+                // Sprites are submitted to the queue afresh each tick, so only those of the last tick are rendered. If the user
+                // has a render function, they submit sprites there instead.
+                if (!user_run_info->on_render_func)
+                {
+                    zfw_reset_sprite_queue(&sprite_queue);
+                }
+
                 user_run_info->on_tick_func(user_run_info->user_ptr, &user_func_data, tick_count, frame_time_change_accum);
-                frame_time_change_accum -= TARG_TICK_INTERVAL;
+                frame_time_change_accum -= tick_interval;
+            }
+
+            zfw_end_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__TICKS);
+
+            if (headless_ticks_left != -1)
+            {
+                headless_ticks_left -= tick_count;
             }
 
             // Reset the mouse scroll now that the ticks are complete.
@@ -468,8 +766,8 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
             // Update the tick input state for next time.
             last_tick_input_state = input_state;
 
-            // If the user has requested a change to the fullscreen state, update it.
-            if (window_state.fullscreen != user_window_fullscreen)
+            // If the user has requested a change to the fullscreen state, update it. This is ignored when headless.
+            if (!user_run_info->headless && window_state.fullscreen != user_window_fullscreen)
             {
                 zfw_bool_t call_user_window_resize_func = ZFW_TRUE;
 
@@ -503,14 +801,71 @@ zfw_bool_t zfw_run_game(const zfw_user_game_run_info_t *const user_run_info)
                     user_run_info->on_window_resize_func(user_run_info->user_ptr, &user_func_data);
                 }
             }
+        }
+
+        // Render, unless there's a frame rate cap and the next frame isn't due yet.
+        const double render_time = glfwGetTime();
+
+        if (frame_interval == 0.0 || render_time >= frame_render_time_next)
+        {
+            // Schedule the next frame, without trying to catch up if this one was late.
+            frame_render_time_next += frame_interval;
+
+            if (frame_render_time_next < render_time)
+            {
+                frame_render_time_next = render_time + frame_interval;
+            }
+
+            if (user_run_info->on_render_func)
+            {
+                zfw_reset_sprite_queue(&sprite_queue);
+
+                const float alpha = (float)ZFW_MIN(frame_time_change_accum / tick_interval, 1.0);
+                user_run_info->on_render_func(user_run_info->user_ptr, &user_func_data, alpha);
+            }
 
-            // Render.
             glClearColor(k_default_bg_color.r, k_default_bg_color.g, k_default_bg_color.b, k_default_bg_color.a);
             glClear(GL_COLOR_BUFFER_BIT);
 
-            zfw_render_sprite_and_character_batches(sprite_batch_groups, &char_batch_group, &view_state, window_state.size, &user_tex_data, &user_font_data, &builtin_shader_prog_data);
+            if (profiler_overlay_active)
+            {
+                update_profiler_overlay(&profiler_overlay, &profiler, &char_batch_group, &user_font_data);
+            }
+
+            zfw_begin_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__SPRITE_QUEUE_PREP);
+            zfw_prepare_sprite_queue(&sprite_queue, &profiler.frame.counters);
+            zfw_prepare_char_batch_group(&char_batch_group, &profiler.frame.counters);
+            zfw_end_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__SPRITE_QUEUE_PREP);
+
+            zfw_begin_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__RENDER);
+            zfw_render_sprite_and_character_batches(sprite_batch_groups, &char_batch_group, &sprite_queue, &view_state, window_state.size, &user_tex_data, &user_shader_prog_data, &user_font_data, &builtin_shader_prog_data, &render_context, &profiler);
+            zfw_end_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__RENDER);
+
+            if (user_run_info->headless)
+            {
+                // There's nothing to swap, so just hand the frame over to the user if they want it.
+                if (user_run_info->on_headless_frame_func)
+                {
+                    zfw_read_offscreen_target_pixels(&offscreen_target, cleanup_data.headless_frame_pixels);
+                    user_run_info->on_headless_frame_func(user_run_info->user_ptr, cleanup_data.headless_frame_pixels, offscreen_target.size);
+                }
+            }
+            else
+            {
+                zfw_begin_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__SWAP_BUFFERS);
+                glfwSwapBuffers(glfw_window);
+                zfw_end_profiler_cpu_scope(&profiler, ZFW_PROFILER_CPU_SCOPE_ID__SWAP_BUFFERS);
+            }
+
+            zfw_end_profiler_frame(&profiler);
+
+            // Release the OpenGL objects and memory of batches that have gone unused for a while.
+            for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
+            {
+                zfw_release_idle_sprite_batches(&sprite_batch_groups[i]);
+            }
 
-            glfwSwapBuffers(glfw_window);
+            zfw_release_idle_char_batches(&char_batch_group);
         }
     }
 
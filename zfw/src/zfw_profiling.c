@@ -0,0 +1,112 @@
+#include <zfw_profiling.h>
+
+#include <string.h>
+#include <GLFW/glfw3.h>
+#include <zfw_common_bits.h>
+
+// Reads back the results of the queries issued in a frame slot, so that the slot can be reused. Results that aren't yet
+// available are skipped rather than waited on, leaving the previous times in place.
+static void read_profiler_gpu_query_results(zfw_profiler_t *const profiler, const int frame_index)
+{
+    zfw_profiler_gpu_timer_bits_t issued_bits = profiler->gpu_query_issued_bits[frame_index];
+
+    while (issued_bits)
+    {
+        const int timer_index = zfw_get_index_of_lowest_active_bit_64(issued_bits);
+        issued_bits &= issued_bits - 1;
+
+        const GLuint query_gl_id = profiler->gpu_query_gl_ids[frame_index][timer_index];
+
+        GLint available;
+        glGetQueryObjectiv(query_gl_id, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available)
+        {
+            GLuint64 time_elapsed;
+            glGetQueryObjectui64v(query_gl_id, GL_QUERY_RESULT, &time_elapsed);
+            profiler->gpu_timer_times[timer_index] = time_elapsed / 1e9;
+        }
+    }
+
+    profiler->gpu_query_issued_bits[frame_index] = 0;
+}
+
+void zfw_init_profiler(zfw_profiler_t *const profiler, const zfw_bool_t enabled)
+{
+    memset(profiler, 0, sizeof(*profiler));
+
+    profiler->enabled = enabled;
+    profiler->frame_begin_time = glfwGetTime();
+
+    if (enabled)
+    {
+        glGenQueries(ZFW_PROFILER_GPU_QUERY_FRAME_COUNT * ZFW_PROFILER_GPU_TIMER_LIMIT, &profiler->gpu_query_gl_ids[0][0]);
+    }
+}
+
+void zfw_clean_profiler(zfw_profiler_t *const profiler)
+{
+    if (profiler->enabled)
+    {
+        glDeleteQueries(ZFW_PROFILER_GPU_QUERY_FRAME_COUNT * ZFW_PROFILER_GPU_TIMER_LIMIT, &profiler->gpu_query_gl_ids[0][0]);
+    }
+
+    memset(profiler, 0, sizeof(*profiler));
+}
+
+void zfw_end_profiler_frame(zfw_profiler_t *const profiler)
+{
+    if (profiler->enabled)
+    {
+        const double time = glfwGetTime();
+        profiler->frame.time = time - profiler->frame_begin_time;
+        profiler->frame_begin_time = time;
+
+        // Move on to the oldest frame slot of queries, whose results should be ready by now.
+        profiler->gpu_query_frame_index = (profiler->gpu_query_frame_index + 1) % ZFW_PROFILER_GPU_QUERY_FRAME_COUNT;
+        read_profiler_gpu_query_results(profiler, profiler->gpu_query_frame_index);
+
+        memcpy(profiler->frame.gpu_timer_times, profiler->gpu_timer_times, sizeof(profiler->gpu_timer_times));
+    }
+
+    profiler->last_frame = profiler->frame;
+    memset(&profiler->frame, 0, sizeof(profiler->frame));
+}
+
+void zfw_begin_profiler_cpu_scope(zfw_profiler_t *const profiler, const zfw_profiler_cpu_scope_id_t scope_id)
+{
+    if (profiler->enabled)
+    {
+        profiler->cpu_scope_begin_times[scope_id] = glfwGetTime();
+    }
+}
+
+void zfw_end_profiler_cpu_scope(zfw_profiler_t *const profiler, const zfw_profiler_cpu_scope_id_t scope_id)
+{
+    if (profiler->enabled)
+    {
+        // Scopes can be entered more than once in a frame (e.g. for multiple ticks), so their times accumulate.
+        profiler->frame.cpu_scope_times[scope_id] += glfwGetTime() - profiler->cpu_scope_begin_times[scope_id];
+    }
+}
+
+void zfw_begin_profiler_gpu_timer(zfw_profiler_t *const profiler, const int timer_index)
+{
+    if (!profiler->enabled)
+    {
+        return;
+    }
+
+    // Only one time elapsed query can be active at once, so timers can't be nested.
+    const int frame_index = profiler->gpu_query_frame_index;
+    glBeginQuery(GL_TIME_ELAPSED, profiler->gpu_query_gl_ids[frame_index][timer_index]);
+    profiler->gpu_query_issued_bits[frame_index] |= (zfw_profiler_gpu_timer_bits_t)1 << timer_index;
+}
+
+void zfw_end_profiler_gpu_timer(zfw_profiler_t *const profiler)
+{
+    if (profiler->enabled)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+}
@@ -1,192 +1,970 @@
 #include <zfw_rendering.h>
 
+#include <stddef.h>
 #include <string.h>
 #include <zfw_common_debug.h>
 
+// SSE2 and NEON are part of the baseline of x86-64 and AArch64 respectively, so neither needs extra compiler flags or
+// runtime detection.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// The layout of sprite queue keys, from the least significant bits up. Fields are ordered by significance, so that sorting
+// on the key groups commands first by batch group and layer for draw order, then by state to minimise changes.
+#define SPRITE_QUEUE_KEY_DEPTH_BIT_COUNT 16
+#define SPRITE_QUEUE_KEY_TEX_BIT_COUNT 16
+#define SPRITE_QUEUE_KEY_SHADER_PROG_BIT_COUNT 8
+
+#define SPRITE_QUEUE_KEY_DEPTH_SHIFT 0
+#define SPRITE_QUEUE_KEY_TEX_SHIFT (SPRITE_QUEUE_KEY_DEPTH_SHIFT + SPRITE_QUEUE_KEY_DEPTH_BIT_COUNT)
+#define SPRITE_QUEUE_KEY_SHADER_PROG_SHIFT (SPRITE_QUEUE_KEY_TEX_SHIFT + SPRITE_QUEUE_KEY_TEX_BIT_COUNT)
+#define SPRITE_QUEUE_KEY_LAYER_SHIFT (SPRITE_QUEUE_KEY_SHADER_PROG_SHIFT + SPRITE_QUEUE_KEY_SHADER_PROG_BIT_COUNT)
+#define SPRITE_QUEUE_KEY_BATCH_GROUP_SHIFT (SPRITE_QUEUE_KEY_LAYER_SHIFT + 5) // (Enough bits for ZFW_RENDER_LAYER_LIMIT.)
+#define SPRITE_QUEUE_KEY_BIT_COUNT (SPRITE_QUEUE_KEY_BATCH_GROUP_SHIFT + 1) // (Enough bits for ZFW_SPRITE_BATCH_GROUP_COUNT.)
+
+#define SPRITE_QUEUE_RADIX_BIT_COUNT 8
+#define SPRITE_QUEUE_RADIX_BUCKET_COUNT (1 << SPRITE_QUEUE_RADIX_BIT_COUNT)
+
+// The number of glyph instances that the character batch group instance store first holds, before growing as needed.
+#define CHAR_INST_CAP_MIN 1024
+
+// The number of glyphs that a character batch glyph store first holds, before growing as needed.
+#define CHAR_BATCH_GLYPH_CAP_MIN 64
+
+#define UTF_8_REPLACEMENT_CODEPOINT 0xFFFD
+
+// The number of sprites whose instance data is generated together by a bulk write, before being scattered to their slots.
+// This must be a multiple of 4 (the SIMD lane count).
+#define SPRITE_BULK_WRITE_BLOCK_SIZE 64
+
 const zfw_color_t zfw_k_color_white = {1.0f, 1.0f, 1.0f, 1.0f};
 const zfw_color_t zfw_k_color_black = {0.0f, 0.0f, 0.0f, 1.0f};
 const zfw_color_t zfw_k_color_red = {1.0f, 0.0f, 0.0f, 1.0f};
 const zfw_color_t zfw_k_color_green = {0.0f, 1.0f, 0.0f, 1.0f};
 const zfw_color_t zfw_k_color_blue = {0.0f, 0.0f, 1.0f, 1.0f};
 
-static int get_gl_tex_unit_limit()
+// Writes the header and payload of a render capture command if the capture is active, returning whether it was. The
+// trailing size is that of any further data to be written after the payload with write_render_capture_data().
+static zfw_bool_t begin_render_capture_cmd(zfw_render_capture_t *const capture, const zfw_render_capture_cmd_type_t type, const void *const payload, const int payload_size, const int trailing_size)
+{
+    if (!capture || !capture->fs)
+    {
+        return ZFW_FALSE;
+    }
+
+    const zfw_render_capture_cmd_header_t header = {type, payload_size + trailing_size};
+    fwrite(&header, sizeof(header), 1, capture->fs);
+    fwrite(payload, payload_size, 1, capture->fs);
+
+    return ZFW_TRUE;
+}
+
+static void write_render_capture_data(zfw_render_capture_t *const capture, const void *const data, const int size)
+{
+    fwrite(data, size, 1, capture->fs);
+}
+
+// Sets up the per-instance sprite attributes of the bound vertex array, sourced from the bound array buffer.
+static void set_up_sprite_inst_vert_attribs()
+{
+    const int inst_stride = sizeof(zfw_sprite_inst_t);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, size));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, rot_cos_sin));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, tex_index));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, tex_coords));
+    glEnableVertexAttribArray(5);
+    glVertexAttribDivisor(5, 1);
+
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, inst_stride, (void *)offsetof(zfw_sprite_inst_t, blend));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+}
+
+// Sets up the per-instance glyph attributes of the bound vertex array, sourced from the bound array buffer.
+static void set_up_char_inst_vert_attribs()
+{
+    const int inst_stride = sizeof(zfw_char_inst_t);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_char_inst_t, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_char_inst_t, size));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, inst_stride, (void *)offsetof(zfw_char_inst_t, tex_coords));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, inst_stride, (void *)offsetof(zfw_char_inst_t, blend));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+}
+
+// Generates a unit quad vertex buffer, with corners ordered for drawing as a triangle strip.
+static GLuint gen_sprite_quad_vert_buf()
+{
+    const float quad_verts[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f
+    };
+
+    GLuint quad_vert_buf_gl_id;
+    glGenBuffers(1, &quad_vert_buf_gl_id);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vert_buf_gl_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_verts), quad_verts, GL_STATIC_DRAW);
+
+    return quad_vert_buf_gl_id;
+}
+
+// Writes the render data of a sprite to an instance, other than its texture index. Texture coordinates are normalised
+// against the given size.
+static void write_sprite_inst(zfw_sprite_inst_t *const inst, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_vec_2d_i_t tex_coords_size)
+{
+    // Fold the origin into the position, so that the shader only needs to rotate and scale the unit quad about the top-left
+    // corner.
+    const zfw_vec_2d_t size = zfw_create_vec_2d(src_rect->width * scale.x, src_rect->height * scale.y);
+    const zfw_vec_2d_t origin_offs = zfw_create_vec_2d(size.x * origin.x, size.y * origin.y);
+
+    const float rot_cos = cosf(rot);
+    const float rot_sin = sinf(rot);
+
+    inst->pos.x = pos.x - ((origin_offs.x * rot_cos) + (origin_offs.y * rot_sin));
+    inst->pos.y = pos.y - ((origin_offs.y * rot_cos) - (origin_offs.x * rot_sin));
+    inst->size = size;
+    inst->rot_cos_sin[0] = rot_cos;
+    inst->rot_cos_sin[1] = rot_sin;
+    inst->tex_coords[0] = (float)src_rect->x / tex_coords_size.x;
+    inst->tex_coords[1] = (float)src_rect->y / tex_coords_size.y;
+    inst->tex_coords[2] = (float)(src_rect->x + src_rect->width) / tex_coords_size.x;
+    inst->tex_coords[3] = (float)(src_rect->y + src_rect->height) / tex_coords_size.y;
+    inst->blend[0] = zfw_get_color_elem_as_byte(blend->r);
+    inst->blend[1] = zfw_get_color_elem_as_byte(blend->g);
+    inst->blend[2] = zfw_get_color_elem_as_byte(blend->b);
+    inst->blend[3] = zfw_get_color_elem_as_byte(blend->a);
+}
+
+// Shifts the glyphs of a line of text horizontally according to the alignment and the width of the line, and tracks
+// the widest line so far.
+static void finish_text_line(zfw_char_batch_glyph_t *const glyphs, const int line_glyph_begin_index, const int line_glyph_end_index, const int line_w, const zfw_font_hor_align_t hor_align, int *const max_line_w)
+{
+    *max_line_w = ZFW_MAX(line_w, *max_line_w);
+
+    if (!glyphs)
+    {
+        return;
+    }
+
+    const float hor_offs = line_w * (hor_align / 2.0f);
+
+    for (int i = line_glyph_begin_index; i < line_glyph_end_index; i++)
+    {
+        glyphs[i].pos.x -= hor_offs;
+    }
+}
+
+// Decodes the UTF-8 sequence at a byte index of text and moves the index past it. Malformed sequences are decoded a byte
+// at a time as the replacement character.
+static unsigned int decode_utf_8_codepoint(const char *const text, const int text_len, int *const byte_index)
+{
+    static const unsigned int seq_codepoint_mins[] = {0, 0, 0x80, 0x800, 0x10000}; // Indexed by sequence length.
+
+    const unsigned char *const bytes = (const unsigned char *)text + *byte_index;
+
+    int seq_len;
+    unsigned int codepoint;
+
+    if (bytes[0] < 0x80)
+    {
+        (*byte_index)++;
+        return bytes[0];
+    }
+    else if ((bytes[0] & 0xE0) == 0xC0)
+    {
+        seq_len = 2;
+        codepoint = bytes[0] & 0x1F;
+    }
+    else if ((bytes[0] & 0xF0) == 0xE0)
+    {
+        seq_len = 3;
+        codepoint = bytes[0] & 0x0F;
+    }
+    else if ((bytes[0] & 0xF8) == 0xF0)
+    {
+        seq_len = 4;
+        codepoint = bytes[0] & 0x07;
+    }
+    else
+    {
+        (*byte_index)++;
+        return UTF_8_REPLACEMENT_CODEPOINT;
+    }
+
+    if (seq_len > text_len - *byte_index)
+    {
+        (*byte_index)++;
+        return UTF_8_REPLACEMENT_CODEPOINT;
+    }
+
+    for (int i = 1; i < seq_len; i++)
+    {
+        if ((bytes[i] & 0xC0) != 0x80)
+        {
+            (*byte_index)++;
+            return UTF_8_REPLACEMENT_CODEPOINT;
+        }
+
+        codepoint = (codepoint << 6) | (bytes[i] & 0x3F);
+    }
+
+    // Reject overlong encodings, surrogates, and codepoints past the end of Unicode.
+    if (codepoint < seq_codepoint_mins[seq_len] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > ZFW_FONT_CODEPOINT_MAX)
+    {
+        (*byte_index)++;
+        return UTF_8_REPLACEMENT_CODEPOINT;
+    }
+
+    *byte_index += seq_len;
+
+    return codepoint;
+}
+
+// Lays out UTF-8 text in a single pass, writing its glyphs into the given store (which must fit at least as many glyphs as
+// there are bytes) unless it is NULL. Horizontal alignment is applied to each line once its width is known, and
+// vertical alignment to all glyphs once the height of the text is known. Returns the bounds of the text relative to
+// the pen origin.
+static zfw_rect_f_t lay_out_text(const char *const text, const int text_len, const int user_font_index, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align, const zfw_user_font_data_t *const user_font_data, zfw_char_batch_glyph_t *const glyphs, int *const glyph_count_out)
+{
+    int glyph_count = 0;
+    int line_glyph_begin_index = 0;
+
+    zfw_vec_2d_t char_draw_pos_pen = {0};
+
+    // These stay at 0 if the text has no characters that the font can lay out, such as when it is empty.
+    int text_first_line_min_offs = 0;
+    int text_first_line_min_offs_updated = ZFW_FALSE;
+    int text_last_line_max_h = 0;
+    int text_last_line_max_h_updated = ZFW_FALSE;
+    int text_line_counter = 0;
+    int text_max_line_w = 0;
+
+    const zfw_vec_2d_i_t font_tex_size = user_font_data->tex_sizes[user_font_index];
+
+    // The metrics of a space are used for empty lines, though a font might not have one.
+    const int space_char_index = zfw_find_font_char_index(user_font_data, user_font_index, ' ');
+    const int space_vert_offs = space_char_index != -1 ? user_font_data->chars_vert_offsets[space_char_index] : 0;
+    const int space_max_h = space_char_index != -1 ? space_vert_offs + user_font_data->chars_src_rects[space_char_index].height : 0;
+
+    int char_index_last = -1; // The previous character on the line, for kerning.
+
+    int i = 0;
+
+    while (i < text_len)
+    {
+        const unsigned int codepoint = decode_utf_8_codepoint(text, text_len, &i);
+
+        if (codepoint == '\n')
+        {
+            finish_text_line(glyphs, line_glyph_begin_index, glyph_count, (int)char_draw_pos_pen.x, hor_align, &text_max_line_w);
+            line_glyph_begin_index = glyph_count;
+
+            if (!text_first_line_min_offs_updated)
+            {
+                // Set the first line minimum offset to the vertical offset of the space character.
+                text_first_line_min_offs = space_vert_offs;
+                text_first_line_min_offs_updated = ZFW_TRUE;
+            }
+
+            // Set the last line maximum h to the h of a space.
+            text_last_line_max_h = space_max_h;
+
+            text_last_line_max_h_updated = ZFW_FALSE;
+
+            text_line_counter++;
+
+            char_index_last = -1;
+
+            // Move the pen to a new line.
+            char_draw_pos_pen.x = 0.0f;
+            char_draw_pos_pen.y += user_font_data->line_heights[user_font_index];
+
+            continue;
+        }
+
+        const int user_font_chars_index = zfw_find_font_char_index(user_font_data, user_font_index, codepoint);
+
+        if (user_font_chars_index == -1)
+        {
+            // Characters that the font doesn't have take up no room.
+            char_index_last = -1;
+            continue;
+        }
+
+        // If we are on the first line, update the first line minimum offset.
+        if (text_line_counter == 0)
+        {
+            if (!text_first_line_min_offs_updated)
+            {
+                text_first_line_min_offs = user_font_data->chars_vert_offsets[user_font_chars_index];
+                text_first_line_min_offs_updated = ZFW_TRUE;
+            }
+            else
+            {
+                text_first_line_min_offs = ZFW_MIN(user_font_data->chars_vert_offsets[user_font_chars_index], text_first_line_min_offs);
+            }
+        }
+
+        if (!text_last_line_max_h_updated)
+        {
+            text_last_line_max_h = user_font_data->chars_vert_offsets[user_font_chars_index] + user_font_data->chars_src_rects[user_font_chars_index].height;
+            text_last_line_max_h_updated = ZFW_TRUE;
+        }
+        else
+        {
+            text_last_line_max_h = ZFW_MAX(user_font_data->chars_vert_offsets[user_font_chars_index] + user_font_data->chars_src_rects[user_font_chars_index].height, text_last_line_max_h);
+        }
+
+        if (char_index_last != -1)
+        {
+            // Apply kerning based on the previous character.
+            char_draw_pos_pen.x += zfw_get_font_chars_kerning(user_font_data, user_font_index, char_index_last, user_font_chars_index);
+        }
+
+        // Spaces have nothing to draw, so only take up room.
+        if (glyphs && codepoint != ' ')
+        {
+            const font_char_src_rect_t *const src_rect = &user_font_data->chars_src_rects[user_font_chars_index];
+
+            zfw_char_batch_glyph_t *const glyph = &glyphs[glyph_count];
+            glyph->pos.x = char_draw_pos_pen.x + user_font_data->chars_hor_offsets[user_font_chars_index];
+            glyph->pos.y = char_draw_pos_pen.y + user_font_data->chars_vert_offsets[user_font_chars_index];
+            glyph->size = zfw_create_vec_2d(src_rect->width, src_rect->height);
+            glyph->tex_coords[0] = (float)src_rect->x / font_tex_size.x;
+            glyph->tex_coords[1] = (float)src_rect->y / font_tex_size.y;
+            glyph->tex_coords[2] = (float)(src_rect->x + src_rect->width) / font_tex_size.x;
+            glyph->tex_coords[3] = (float)(src_rect->y + src_rect->height) / font_tex_size.y;
+
+            glyph_count++;
+        }
+
+        char_draw_pos_pen.x += user_font_data->chars_hor_advances[user_font_chars_index];
+
+        char_index_last = user_font_chars_index;
+    }
+
+    finish_text_line(glyphs, line_glyph_begin_index, glyph_count, (int)char_draw_pos_pen.x, hor_align, &text_max_line_w);
+
+    const int text_h = text_first_line_min_offs + char_draw_pos_pen.y + text_last_line_max_h;
+    const float text_vert_offs = text_h * (vert_align / 2.0f);
+
+    for (int i = 0; i < glyph_count; i++)
+    {
+        glyphs[i].pos.y -= text_vert_offs;
+    }
+
+    if (glyph_count_out)
+    {
+        *glyph_count_out = glyph_count;
+    }
+
+    // Lines are aligned individually, so the bounds span the widest of them.
+    zfw_rect_f_t bounds;
+    bounds.x = -text_max_line_w * (hor_align / 2.0f);
+    bounds.y = -text_vert_offs;
+    bounds.width = text_max_line_w;
+    bounds.height = text_h;
+
+    return bounds;
+}
+
+// Hashes the inputs of a text layout using FNV-1a, so that a batch can tell whether a write would change anything.
+static zfw_char_batch_layout_hash_t calc_char_batch_layout_hash(const char *const text, const int text_len, const int user_font_index, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align)
 {
-    int limit;
-    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &limit);
-    return limit;
+    zfw_char_batch_layout_hash_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < text_len; i++)
+    {
+        hash = (hash ^ (unsigned char)text[i]) * 1099511628211ULL;
+    }
+
+    const int params[] = {user_font_index, hor_align, vert_align};
+
+    for (int i = 0; i < ZFW_STATIC_ARRAY_LEN(params); i++)
+    {
+        hash = (hash ^ (unsigned int)params[i]) * 1099511628211ULL;
+    }
+
+    // A hash of 0 is reserved for batches without a layout.
+    return hash ? hash : 1;
 }
 
-static zfw_bool_t init_and_activate_render_layer_sprite_batch(const int layer_index, const int batch_index, zfw_sprite_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena)
-{
-    const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(layer_index, batch_index);
+static zfw_bool_t init_and_activate_render_layer_sprite_batch(const int layer_index, const int batch_index, zfw_sprite_batch_group_t *const batch_group)
+{
+    const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(layer_index, batch_index);
+
+    // Allocate the slot activity of the batch, or reset it if the batch was previously active.
+    {
+        zfw_sprite_batch_slot_activity_t **const slot_activity = &batch_group->batch_slot_activities[batch_group_batch_index];
+
+        if (!*slot_activity)
+        {
+            *slot_activity = calloc(1, sizeof(**slot_activity));
+
+            if (!*slot_activity)
+            {
+                zfw_log_error("Failed to allocate %d bytes for render layer sprite batch slot activity!", sizeof(**slot_activity));
+                return ZFW_FALSE;
+            }
+        }
+        else
+        {
+            memset(*slot_activity, 0, sizeof(**slot_activity));
+        }
+    }
+
+    // Generate the OpenGL objects of the batch if this is its first activation since it was last released.
+    if (!batch_group->vert_array_gl_ids[batch_group_batch_index])
+    {
+        glGenVertexArrays(1, &batch_group->vert_array_gl_ids[batch_group_batch_index]);
+        glGenBuffers(1, &batch_group->inst_buf_gl_ids[batch_group_batch_index]);
+    }
+
+    batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+
+    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
+
+    // Set up the per-vertex unit quad corner attribute, shared by all batches of the group.
+    glBindBuffer(GL_ARRAY_BUFFER, batch_group->quad_vert_buf_gl_id);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void *)0);
+    glEnableVertexAttribArray(0);
+
+    // Set up the per-instance attributes.
+    glBindBuffer(GL_ARRAY_BUFFER, batch_group->inst_buf_gl_ids[batch_group_batch_index]);
+
+    {
+        // Allocate the zeroed CPU-side instance staging store of the batch, which also serves as the initial buffer contents.
+        zfw_sprite_batch_staging_t *const staging = &batch_group->batch_stagings[batch_group_batch_index];
+
+        const int insts_size = sizeof(*staging->insts) * ZFW_SPRITE_BATCH_SLOT_LIMIT;
+
+        if (!staging->insts)
+        {
+            staging->insts = calloc(1, insts_size);
+
+            if (!staging->insts)
+            {
+                zfw_log_error("Failed to allocate %d bytes for render layer sprite batch instances!", insts_size);
+                return ZFW_FALSE;
+            }
+        }
+        else
+        {
+            memset(staging->insts, 0, insts_size);
+        }
+
+        staging->dirty_bits = 0;
+
+        glBufferData(GL_ARRAY_BUFFER, insts_size, staging->insts, GL_DYNAMIC_DRAW);
+    }
+
+    set_up_sprite_inst_vert_attribs();
+
+    glBindVertexArray(0);
+
+    batch_group->batch_activity_bits[layer_index] |= (zfw_render_layer_sprite_batch_activity_bits_t)1 << batch_index;
+
+    return ZFW_TRUE;
+}
+
+// Activates the lowest inactive slot and returns its index, or -1 if all slots are active.
+static int take_sprite_batch_slot(zfw_sprite_batch_slot_activity_t *const slot_activity)
+{
+    for (int i = 0; i < ZFW_SPRITE_BATCH_SLOT_ACTIVITY_SUMMARY_WORD_COUNT; i++)
+    {
+        if (!~slot_activity->full_words[i])
+        {
+            continue;
+        }
+
+        const int word_index = (i * ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t)) + zfw_get_index_of_lowest_active_bit_64(~slot_activity->full_words[i]);
+        const int word_bit_index = zfw_get_index_of_lowest_active_bit_64(~slot_activity->words[word_index]);
+
+        const zfw_sprite_batch_slot_activity_word_t summary_bitmask = (zfw_sprite_batch_slot_activity_word_t)1 << (word_index % ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t));
+
+        slot_activity->words[word_index] |= (zfw_sprite_batch_slot_activity_word_t)1 << word_bit_index;
+        slot_activity->used_words[i] |= summary_bitmask;
+
+        if (!~slot_activity->words[word_index])
+        {
+            slot_activity->full_words[i] |= summary_bitmask;
+        }
+
+        return (word_index * ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t)) + word_bit_index;
+    }
+
+    return -1;
+}
+
+static void free_sprite_batch_slot(zfw_sprite_batch_slot_activity_t *const slot_activity, const int slot_index)
+{
+    const int word_index = slot_index / ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t);
+    const int summary_word_index = word_index / ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t);
+    const zfw_sprite_batch_slot_activity_word_t summary_bitmask = (zfw_sprite_batch_slot_activity_word_t)1 << (word_index % ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t));
+
+    slot_activity->words[word_index] &= ~((zfw_sprite_batch_slot_activity_word_t)1 << (slot_index % ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t)));
+    slot_activity->full_words[summary_word_index] &= ~summary_bitmask;
+
+    if (!slot_activity->words[word_index])
+    {
+        slot_activity->used_words[summary_word_index] &= ~summary_bitmask;
+    }
+}
+
+// Returns one greater than the index of the highest active slot, or 0 if no slots are active.
+static int get_sprite_batch_live_slot_bound(const zfw_sprite_batch_slot_activity_t *const slot_activity)
+{
+    for (int i = ZFW_SPRITE_BATCH_SLOT_ACTIVITY_SUMMARY_WORD_COUNT - 1; i >= 0; i--)
+    {
+        if (!slot_activity->used_words[i])
+        {
+            continue;
+        }
+
+        const int word_index = (i * ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t)) + zfw_get_index_of_highest_active_bit_64(slot_activity->used_words[i]);
+        return (word_index * ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t)) + zfw_get_index_of_highest_active_bit_64(slot_activity->words[word_index]) + 1;
+    }
+
+    return 0;
+}
+
+static zfw_sprite_inst_t *get_sprite_batch_staging_slot_inst(const zfw_sprite_batch_group_t *const batch_group, const int batch_group_batch_index, const int slot_index)
+{
+    zfw_sprite_batch_staging_t *const staging = &batch_group->batch_stagings[batch_group_batch_index];
+    staging->dirty_bits |= (zfw_sprite_batch_staging_dirty_bits_t)1 << (slot_index / ZFW_SPRITE_BATCH_STAGING_CHUNK_SLOT_COUNT);
+    return &staging->insts[slot_index];
+}
+
+static void assign_sprite_batch_slot_user_tex(zfw_sprite_batch_group_t *const batch_group, const int batch_group_batch_index, const int batch_group_tex_unit_index, const int slot_index, const int user_tex_index)
+{
+    if (batch_group->tex_array)
+    {
+        // The texture index of the instance is its texture array layer, which is just the user texture index.
+        get_sprite_batch_staging_slot_inst(batch_group, batch_group_batch_index, slot_index)->tex_index = user_tex_index;
+    }
+    else
+    {
+        batch_group->tex_units[batch_group_tex_unit_index].user_tex_index = user_tex_index;
+        batch_group->tex_units[batch_group_tex_unit_index].count++;
+    }
+}
+
+// Returns the index of a texture unit of the batch that the user texture can be drawn with, or -1 if there is none.
+static int find_sprite_batch_tex_unit(const zfw_sprite_batch_group_t *const batch_group, const int layer_index, const int batch_index, const int user_tex_index)
+{
+    if (batch_group->tex_array)
+    {
+        // Every user texture is a layer of the one texture array, which is bound to the first unit.
+        return 0;
+    }
+
+    for (int i = 0; i < batch_group->tex_unit_limit; i++)
+    {
+        const zfw_sprite_batch_tex_unit_t tex_unit = batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(layer_index, batch_index, i)];
+
+        if (tex_unit.count == 0 || tex_unit.user_tex_index == user_tex_index)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void upload_sprite_batch_staging(const zfw_sprite_batch_group_t *const batch_group, const int batch_group_batch_index, zfw_profiler_counters_t *const profiler_counters)
+{
+    zfw_sprite_batch_staging_t *const staging = &batch_group->batch_stagings[batch_group_batch_index];
+
+    if (!staging->dirty_bits)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch_group->inst_buf_gl_ids[batch_group_batch_index]);
+
+    const int chunk_size = sizeof(*staging->insts) * ZFW_SPRITE_BATCH_STAGING_CHUNK_SLOT_COUNT;
+    const int chunk_count = ZFW_SIZE_IN_BITS(staging->dirty_bits);
+
+    // Upload each run of consecutive dirty chunks with a single call.
+    int i = 0;
+
+    while (i < chunk_count)
+    {
+        if (!(staging->dirty_bits & ((zfw_sprite_batch_staging_dirty_bits_t)1 << i)))
+        {
+            i++;
+            continue;
+        }
+
+        const int run_begin = i;
+
+        while (i < chunk_count && (staging->dirty_bits & ((zfw_sprite_batch_staging_dirty_bits_t)1 << i)))
+        {
+            i++;
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, chunk_size * run_begin, chunk_size * (i - run_begin), staging->insts + (ZFW_SPRITE_BATCH_STAGING_CHUNK_SLOT_COUNT * run_begin));
+
+        profiler_counters->buf_upload_count++;
+        profiler_counters->buf_upload_size += chunk_size * (i - run_begin);
+    }
+
+    staging->dirty_bits = 0;
+}
+
+static void draw_sprite_batches_of_layer(const zfw_sprite_batch_group_t *const batch_group, const int layer_index, const zfw_user_tex_data_t *const user_tex_data, const zfw_render_context_t *const render_context, zfw_profiler_counters_t *const profiler_counters)
+{
+    if (!batch_group->batch_activity_bits[layer_index])
+    {
+        // All the batches of this layer are inactive, so don't bother proceeding.
+        return;
+    }
+
+    profiler_counters->active_sprite_batch_count += zfw_get_active_bit_count_64(batch_group->batch_activity_bits[layer_index]);
+
+    for (int i = 0; i < ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT; i++)
+    {
+        if (!(batch_group->batch_activity_bits[layer_index] & ((zfw_render_layer_sprite_batch_activity_bits_t)1 << i)))
+        {
+            continue;
+        }
+
+        const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(layer_index, i);
+        const int live_slot_bound = batch_group->batch_live_slot_bounds[batch_group_batch_index];
+
+        if (!live_slot_bound)
+        {
+            // No slots of this batch are in use.
+            continue;
+        }
+
+        const zfw_sprite_batch_slot_activity_t *const slot_activity = batch_group->batch_slot_activities[batch_group_batch_index];
+
+        const int live_slot_word_count = (live_slot_bound + ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t) - 1) / ZFW_SIZE_IN_BITS(zfw_sprite_batch_slot_activity_word_t);
+
+        for (int j = 0; j < live_slot_word_count; j++)
+        {
+            profiler_counters->live_sprite_batch_slot_count += zfw_get_active_bit_count_64(slot_activity->words[j]);
+        }
+
+        upload_sprite_batch_staging(batch_group, batch_group_batch_index, profiler_counters);
+
+        if (batch_group->tex_array)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, user_tex_data->array_gl_id);
+        }
+        else
+        {
+            int tex_units[ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT] = {0};
+
+            for (int j = 0; j < ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT; j++)
+            {
+                const int batch_group_tex_unit_index = zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, j);
+
+                if (batch_group->tex_units[batch_group_tex_unit_index].count)
+                {
+                    tex_units[j] = j;
+
+                    glActiveTexture(GL_TEXTURE0 + j);
+                    glBindTexture(GL_TEXTURE_2D, user_tex_data->gl_ids[batch_group->tex_units[batch_group_tex_unit_index].user_tex_index]);
+                }
+            }
+
+            glUniform1iv(render_context->builtin_uniform_locs.sprite_quad_textures, ZFW_STATIC_ARRAY_LEN(tex_units), tex_units);
+        }
+
+        // Draw an instance of the unit quad for each slot up to the highest active one, rather than across the whole batch.
+        glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, live_slot_bound);
+
+        profiler_counters->draw_call_count++;
+    }
+}
+
+// Draws the queued sprites of a single batch group layer, starting at the command index and advancing it past them. The
+// built-in sprite shader program is expected to be in use, and is left in use.
+static void draw_sprite_queue_cmds_of_layer(const zfw_sprite_queue_t *const queue, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, int *const cmd_index, const zfw_matrix_4x4_t *const view_proj, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_render_context_t *const render_context, zfw_profiler_counters_t *const profiler_counters)
+{
+    const zfw_sprite_queue_key_t layer_key = ((zfw_sprite_queue_key_t)batch_group_id << SPRITE_QUEUE_KEY_BATCH_GROUP_SHIFT) | ((zfw_sprite_queue_key_t)layer_index << SPRITE_QUEUE_KEY_LAYER_SHIFT);
+    const zfw_sprite_queue_key_t layer_key_mask = ~(((zfw_sprite_queue_key_t)1 << SPRITE_QUEUE_KEY_LAYER_SHIFT) - 1);
+
+    if (*cmd_index >= queue->cmd_count || (queue->sorted_elems[*cmd_index].key & layer_key_mask) != layer_key)
+    {
+        return;
+    }
+
+    // A run of commands can be drawn together if they share a shader program and, unless all user textures are in the one
+    // texture array, a texture. Depth only orders commands within a run.
+    const zfw_sprite_queue_key_t run_key_mask = ~(((zfw_sprite_queue_key_t)1 << (queue->tex_array ? SPRITE_QUEUE_KEY_SHADER_PROG_SHIFT : SPRITE_QUEUE_KEY_TEX_SHIFT)) - 1);
+
+    // Every texture is drawn from the first unit, so point all sampler array elements at it.
+    const int tex_units[ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT] = {0};
+    glUniform1iv(render_context->builtin_uniform_locs.sprite_quad_textures, ZFW_STATIC_ARRAY_LEN(tex_units), tex_units);
+
+    glActiveTexture(GL_TEXTURE0);
+
+    if (queue->tex_array)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, user_tex_data->array_gl_id);
+    }
+
+    glBindVertexArray(queue->vert_array_gl_id);
+
+    int user_shader_prog_index_last = ZFW_SPRITE_QUEUE_BUILTIN_SHADER_PROG_INDEX;
+
+    while (*cmd_index < queue->cmd_count && (queue->sorted_elems[*cmd_index].key & layer_key_mask) == layer_key)
+    {
+        const zfw_sprite_queue_key_t run_key = queue->sorted_elems[*cmd_index].key;
+
+        int run_end = *cmd_index + 1;
+
+        while (run_end < queue->cmd_count && (queue->sorted_elems[run_end].key & run_key_mask) == (run_key & run_key_mask))
+        {
+            run_end++;
+        }
+
+        // Shader program indexes are stored offset by one, so that the built-in program is 0.
+        const int user_shader_prog_index = (int)((run_key >> SPRITE_QUEUE_KEY_SHADER_PROG_SHIFT) & ((1 << SPRITE_QUEUE_KEY_SHADER_PROG_BIT_COUNT) - 1)) - 1;
+
+        if (user_shader_prog_index != user_shader_prog_index_last)
+        {
+            if (user_shader_prog_index == ZFW_SPRITE_QUEUE_BUILTIN_SHADER_PROG_INDEX)
+            {
+                glUseProgram(builtin_shader_prog_data->sprite_quad_prog_gl_id);
+            }
+            else
+            {
+                const zfw_user_shader_prog_sprite_uniform_locs_t *const sprite_uniform_locs = &render_context->user_shader_prog_sprite_uniform_locs[user_shader_prog_index];
+
+                glUseProgram(user_shader_prog_data->gl_ids[user_shader_prog_index]);
+                glUniformMatrix4fv(sprite_uniform_locs->view_proj, 1, GL_FALSE, (const float *)view_proj->elems);
+                glUniform1iv(sprite_uniform_locs->textures, ZFW_STATIC_ARRAY_LEN(tex_units), tex_units);
+            }
+
+            user_shader_prog_index_last = user_shader_prog_index;
+        }
+
+        if (!queue->tex_array)
+        {
+            const int user_tex_index = (run_key >> SPRITE_QUEUE_KEY_TEX_SHIFT) & ((1 << SPRITE_QUEUE_KEY_TEX_BIT_COUNT) - 1);
+            glBindTexture(GL_TEXTURE_2D, user_tex_data->gl_ids[user_tex_index]);
+        }
+
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, run_end - *cmd_index, *cmd_index);
 
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
+        profiler_counters->draw_call_count++;
 
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
+        *cmd_index = run_end;
+    }
 
+    if (user_shader_prog_index_last != ZFW_SPRITE_QUEUE_BUILTIN_SHADER_PROG_INDEX)
     {
-        float *verts;
-        const int verts_size = sizeof(*verts) * ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT * 4 * ZFW_SPRITE_BATCH_SLOT_LIMIT;
-        verts = zfw_mem_arena_alloc(main_mem_arena, verts_size);
-
-        if (!verts)
-        {
-            zfw_log_error("Failed to allocate %d bytes for render layer sprite batch vertices!", verts_size);
-            return ZFW_FALSE;
-        }
+        glUseProgram(builtin_shader_prog_data->sprite_quad_prog_gl_id);
+    }
+}
 
-        memset(verts, 0, verts_size);
+static void draw_char_batches_of_layer(const zfw_char_batch_group_t *const batch_group, const int layer_index, const zfw_matrix_4x4_t *const proj, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_render_context_t *const render_context, zfw_profiler_counters_t *const profiler_counters)
+{
+    profiler_counters->active_char_batch_count += zfw_get_active_bit_count_64(batch_group->batch_activity_bits[layer_index]);
 
-        glBufferData(GL_ARRAY_BUFFER, verts_size, verts, GL_DYNAMIC_DRAW);
+    const int run_count = batch_group->layer_inst_run_counts[layer_index];
 
-        zfw_rewind_mem_arena(main_mem_arena);
+    if (!run_count)
+    {
+        // No batches of this layer have any glyphs, so don't bother proceeding.
+        return;
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_group->elem_buf_gl_ids[batch_group_batch_index]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(batch_group->vert_array_gl_id);
+
+    GLuint prog_gl_id = 0;
 
+    for (int i = 0; i < run_count; i++)
     {
-        unsigned short *indices;
-        const int indices_size = sizeof(*indices) * 6 * ZFW_SPRITE_BATCH_SLOT_LIMIT;
-        indices = zfw_mem_arena_alloc(main_mem_arena, indices_size);
+        const zfw_char_inst_run_t *const run = &batch_group->inst_runs[batch_group->layer_inst_run_begin_indexes[layer_index] + i];
 
-        if (!indices)
-        {
-            zfw_log_error("Failed to allocate %d bytes for render layer sprite batch elements!", indices_size);
-            return ZFW_FALSE;
-        }
+        // Signed distance field fonts need their own program, so only switch between the two when the font kind changes.
+        const zfw_bool_t sdf = user_font_data->sdfs[run->user_font_index];
+        const GLuint run_prog_gl_id = sdf ? builtin_shader_prog_data->char_quad_sdf_prog_gl_id : builtin_shader_prog_data->char_quad_prog_gl_id;
 
-        for (int i = 0; i < ZFW_SPRITE_BATCH_SLOT_LIMIT; i++)
+        if (run_prog_gl_id != prog_gl_id)
         {
-            indices[(i * 6) + 0] = (i * 4) + 0;
-            indices[(i * 6) + 1] = (i * 4) + 1;
-            indices[(i * 6) + 2] = (i * 4) + 2;
-            indices[(i * 6) + 3] = (i * 4) + 2;
-            indices[(i * 6) + 4] = (i * 4) + 3;
-            indices[(i * 6) + 5] = (i * 4) + 0;
+            glUseProgram(run_prog_gl_id);
+            glUniformMatrix4fv(sdf ? render_context->builtin_uniform_locs.char_quad_sdf_proj : render_context->builtin_uniform_locs.char_quad_proj, 1, GL_FALSE, (float *)proj->elems);
+
+            prog_gl_id = run_prog_gl_id;
         }
 
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_size, indices, GL_STATIC_DRAW);
+        glBindTexture(GL_TEXTURE_2D, user_font_data->tex_gl_ids[run->user_font_index]);
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, run->inst_count, run->inst_begin_index);
 
-        zfw_rewind_mem_arena(main_mem_arena);
+        profiler_counters->draw_call_count++;
     }
+}
 
-    const int verts_stride = sizeof(float) * ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT;
+zfw_bool_t zfw_init_render_context(zfw_render_context_t *const render_context, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data, zfw_mem_arena_t *const main_mem_arena)
+{
+    memset(render_context, 0, sizeof(*render_context));
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 0));
-    glEnableVertexAttribArray(0);
+    // Query device limits.
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &render_context->tex_unit_limit);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &render_context->tex_size_limit);
 
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 2));
-    glEnableVertexAttribArray(1);
+    // Retrieve built-in shader program uniform locations.
+    zfw_builtin_shader_prog_uniform_locs_t *const builtin_uniform_locs = &render_context->builtin_uniform_locs;
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 4));
-    glEnableVertexAttribArray(2);
+    builtin_uniform_locs->sprite_quad_view_proj = glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_view_proj");
+    builtin_uniform_locs->sprite_quad_textures = glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_textures");
 
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 6));
-    glEnableVertexAttribArray(3);
+    builtin_uniform_locs->char_quad_proj = glGetUniformLocation(builtin_shader_prog_data->char_quad_prog_gl_id, "u_proj");
+    builtin_uniform_locs->char_quad_sdf_proj = glGetUniformLocation(builtin_shader_prog_data->char_quad_sdf_prog_gl_id, "u_proj");
 
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 7));
-    glEnableVertexAttribArray(4);
+    // Build the uniform tables of user shader programs.
+    if (!user_shader_prog_data->prog_count)
+    {
+        return ZFW_TRUE;
+    }
 
-    glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 8));
-    glEnableVertexAttribArray(5);
+    render_context->user_shader_prog_uniform_begin_indexes = zfw_mem_arena_alloc(main_mem_arena, sizeof(*render_context->user_shader_prog_uniform_begin_indexes) * user_shader_prog_data->prog_count);
 
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 10));
-    glEnableVertexAttribArray(6);
+    if (!render_context->user_shader_prog_uniform_begin_indexes)
+    {
+        zfw_log_error("Failed to allocate %d bytes for user shader program uniform begin indexes!", sizeof(*render_context->user_shader_prog_uniform_begin_indexes) * user_shader_prog_data->prog_count);
+        return ZFW_FALSE;
+    }
 
-    glBindVertexArray(0);
+    render_context->user_shader_prog_uniform_counts = zfw_mem_arena_alloc(main_mem_arena, sizeof(*render_context->user_shader_prog_uniform_counts) * user_shader_prog_data->prog_count);
 
-    batch_group->batch_activity_bits[layer_index] |= (zfw_render_layer_sprite_batch_activity_bits_t)1 << batch_index;
+    if (!render_context->user_shader_prog_uniform_counts)
+    {
+        zfw_log_error("Failed to allocate %d bytes for user shader program uniform counts!", sizeof(*render_context->user_shader_prog_uniform_counts) * user_shader_prog_data->prog_count);
+        return ZFW_FALSE;
+    }
 
-    return ZFW_TRUE;
-}
+    render_context->user_shader_prog_sprite_uniform_locs = zfw_mem_arena_alloc(main_mem_arena, sizeof(*render_context->user_shader_prog_sprite_uniform_locs) * user_shader_prog_data->prog_count);
 
-static int get_sprite_batch_slot_key_elem_bit_count(const zfw_sprite_batch_slot_key_elem_id_t key_elem_id)
-{
-    switch (key_elem_id)
+    if (!render_context->user_shader_prog_sprite_uniform_locs)
     {
-        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX: return log2(ZFW_SPRITE_BATCH_GROUP_COUNT);
-        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX: return log2(ZFW_RENDER_LAYER_LIMIT);
-        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX: return log2(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT);
-        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX: return log2(ZFW_SPRITE_BATCH_SLOT_LIMIT);
-        case ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX: return log2(ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT);
+        zfw_log_error("Failed to allocate %d bytes for user shader program sprite uniform locations!", sizeof(*render_context->user_shader_prog_sprite_uniform_locs) * user_shader_prog_data->prog_count);
+        return ZFW_FALSE;
     }
 
-    return -1;
-}
+    int uniform_total = 0;
 
-static void draw_sprite_batches_of_layer(const zfw_sprite_batch_group_t *const batch_group, const int layer_index, const zfw_user_tex_data_t *const user_tex_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data)
-{
-    if (!batch_group->batch_activity_bits[layer_index])
+    for (int i = 0; i < user_shader_prog_data->prog_count; i++)
     {
-        // All the batches of this layer are inactive, so don't bother proceeding.
-        return;
+        glGetProgramiv(user_shader_prog_data->gl_ids[i], GL_ACTIVE_UNIFORMS, &render_context->user_shader_prog_uniform_counts[i]);
+
+        render_context->user_shader_prog_uniform_begin_indexes[i] = uniform_total;
+        uniform_total += render_context->user_shader_prog_uniform_counts[i];
     }
 
-    for (int i = 0; i < ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT; i++)
+    if (uniform_total)
     {
-        if (!(batch_group->batch_activity_bits[layer_index] & ((zfw_render_layer_sprite_batch_activity_bits_t)1 << i)))
+        render_context->user_shader_prog_uniforms = zfw_mem_arena_alloc(main_mem_arena, sizeof(*render_context->user_shader_prog_uniforms) * uniform_total);
+
+        if (!render_context->user_shader_prog_uniforms)
         {
-            continue;
+            zfw_log_error("Failed to allocate %d bytes for user shader program uniforms!", sizeof(*render_context->user_shader_prog_uniforms) * uniform_total);
+            return ZFW_FALSE;
         }
+    }
 
-        int tex_units[ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT] = {0};
-
-        for (int j = 0; j < ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT; j++)
+    for (int i = 0; i < user_shader_prog_data->prog_count; i++)
+    {
+        for (int j = 0; j < render_context->user_shader_prog_uniform_counts[i]; j++)
         {
-            const int batch_group_tex_unit_index = zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, j);
+            zfw_shader_prog_uniform_t *const uniform = &render_context->user_shader_prog_uniforms[render_context->user_shader_prog_uniform_begin_indexes[i] + j];
 
-            if (batch_group->tex_units[batch_group_tex_unit_index].count)
-            {
-                tex_units[j] = j;
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(user_shader_prog_data->gl_ids[i], j, sizeof(uniform->name), NULL, &size, &type, uniform->name);
+
+            uniform->loc = glGetUniformLocation(user_shader_prog_data->gl_ids[i], uniform->name);
 
-                glActiveTexture(GL_TEXTURE0 + j);
-                glBindTexture(GL_TEXTURE_2D, user_tex_data->gl_ids[batch_group->tex_units[batch_group_tex_unit_index].user_tex_index]);
+            // Strip the array suffix so that arrays can be looked up by their plain name.
+            char *const array_suffix = strstr(uniform->name, "[0]");
+
+            if (array_suffix)
+            {
+                *array_suffix = '\0';
             }
         }
+    }
 
-        glUniform1iv(glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_textures"), ZFW_STATIC_ARRAY_LEN(tex_units), tex_units);
-
-        glBindVertexArray(batch_group->vert_array_gl_ids[zfw_get_sprite_batch_group_batch_index(layer_index, i)]);
-        glDrawElements(GL_TRIANGLES, 6 * ZFW_SPRITE_BATCH_SLOT_LIMIT, GL_UNSIGNED_SHORT, 0);
+    // Resolve the uniforms that sprite drawing sets, so that switching to a user program doesn't look them up by name.
+    for (int i = 0; i < user_shader_prog_data->prog_count; i++)
+    {
+        zfw_user_shader_prog_sprite_uniform_locs_t *const sprite_uniform_locs = &render_context->user_shader_prog_sprite_uniform_locs[i];
+        sprite_uniform_locs->view_proj = zfw_get_user_shader_prog_uniform_loc(i, "u_view_proj", render_context);
+        sprite_uniform_locs->textures = zfw_get_user_shader_prog_uniform_loc(i, "u_textures", render_context);
     }
+
+    return ZFW_TRUE;
 }
 
-static void draw_char_batches_of_layer(const zfw_char_batch_group_t *const batch_group, const int layer_index, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data)
+GLint zfw_get_user_shader_prog_uniform_loc(const int user_shader_prog_index, const char *const uniform_name, const zfw_render_context_t *const render_context)
 {
-    if (!batch_group->batch_activity_bits[layer_index])
-    {
-        // All the batches of this layer are inactive, so don't bother proceeding.
-        return;
-    }
+    const int begin_index = render_context->user_shader_prog_uniform_begin_indexes[user_shader_prog_index];
 
-    for (int i = 0; i < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; i++)
+    for (int i = 0; i < render_context->user_shader_prog_uniform_counts[user_shader_prog_index]; i++)
     {
-        if (!(batch_group->batch_activity_bits[layer_index] & ((zfw_render_layer_char_batch_bits_t)1 << i)))
+        const zfw_shader_prog_uniform_t *const uniform = &render_context->user_shader_prog_uniforms[begin_index + i];
+
+        if (strcmp(uniform->name, uniform_name) == 0)
         {
-            continue;
+            return uniform->loc;
         }
-
-        const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(layer_index, i);
-
-        glUniform2fv(glGetUniformLocation(builtin_shader_prog_data->char_quad_prog_gl_id, "u_pos"), 1, (float *)&batch_group->positions[batch_group_batch_index]);
-        glUniform2fv(glGetUniformLocation(builtin_shader_prog_data->char_quad_prog_gl_id, "u_scale"), 1, (float *)&batch_group->scales[batch_group_batch_index]);
-        glUniform4fv(glGetUniformLocation(builtin_shader_prog_data->char_quad_prog_gl_id, "u_blend"), 1, (float *)&batch_group->blends[batch_group_batch_index]);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, user_font_data->tex_gl_ids[batch_group->user_font_indexes[batch_group_batch_index]]);
-
-        glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-        glDrawElements(GL_TRIANGLES, 6 * ZFW_CHAR_BATCH_SLOT_LIMIT, GL_UNSIGNED_SHORT, 0);
     }
+
+    return -1;
 }
 
-zfw_bool_t zfw_init_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena)
+zfw_bool_t zfw_init_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group, const zfw_render_context_t *const render_context, const zfw_user_tex_data_t *const user_tex_data, zfw_mem_arena_t *const main_mem_arena)
 {
     memset(batch_group, 0, sizeof(*batch_group));
 
+    batch_group->tex_array = user_tex_data->array_gl_id != 0;
+
+    batch_group->tex_unit_limit = ZFW_MIN(render_context->tex_unit_limit, ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT);
+
     const int batch_group_batch_count = ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT;
 
-    // Generate vertex arrays after allocating memory for OpenGL IDs.
+    // Allocate memory for vertex array OpenGL IDs. The vertex arrays themselves are only generated once a batch is activated.
     batch_group->vert_array_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->vert_array_gl_ids) * batch_group_batch_count);
 
     if (!batch_group->vert_array_gl_ids)
@@ -194,52 +972,97 @@ zfw_bool_t zfw_init_sprite_batch_group(zfw_sprite_batch_group_t *const batch_gro
         return ZFW_FALSE;
     }
 
-    glGenVertexArrays(batch_group_batch_count, batch_group->vert_array_gl_ids);
+    memset(batch_group->vert_array_gl_ids, 0, sizeof(*batch_group->vert_array_gl_ids) * batch_group_batch_count);
 
-    // Generate vertex buffers after allocating memory for OpenGL IDs.
-    batch_group->vert_buf_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->vert_buf_gl_ids) * batch_group_batch_count);
+    // Allocate memory for instance buffer OpenGL IDs. The buffers themselves are only generated once a batch is activated.
+    batch_group->inst_buf_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->inst_buf_gl_ids) * batch_group_batch_count);
 
-    if (!batch_group->vert_buf_gl_ids)
+    if (!batch_group->inst_buf_gl_ids)
     {
         return ZFW_FALSE;
     }
 
-    glGenBuffers(batch_group_batch_count, batch_group->vert_buf_gl_ids);
+    memset(batch_group->inst_buf_gl_ids, 0, sizeof(*batch_group->inst_buf_gl_ids) * batch_group_batch_count);
+
+    // Generate the unit quad vertex buffer shared by all batches.
+    batch_group->quad_vert_buf_gl_id = gen_sprite_quad_vert_buf();
+
+    // Allocate memory for texture units.
+    batch_group->tex_units = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->tex_units) * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT * batch_group_batch_count);
+
+    if (!batch_group->tex_units)
+    {
+        return ZFW_FALSE;
+    }
 
-    // Generate element buffers after allocating memory for OpenGL IDs.
-    batch_group->elem_buf_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->elem_buf_gl_ids) * batch_group_batch_count);
+    // Allocate memory for batch slot activity pointers. The slot activities themselves are only allocated once a batch is activated.
+    batch_group->batch_slot_activities = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_slot_activities) * batch_group_batch_count);
 
-    if (!batch_group->elem_buf_gl_ids)
+    if (!batch_group->batch_slot_activities)
     {
         return ZFW_FALSE;
     }
 
-    glGenBuffers(batch_group_batch_count, batch_group->elem_buf_gl_ids);
+    memset(batch_group->batch_slot_activities, 0, sizeof(*batch_group->batch_slot_activities) * batch_group_batch_count);
 
-    // Allocate memory for texture units.
-    batch_group->tex_units = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->tex_units) * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT * batch_group_batch_count);
+    // Allocate memory for batch idle frame counts.
+    batch_group->batch_idle_frame_counts = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_idle_frame_counts) * batch_group_batch_count);
 
-    if (!batch_group->tex_units)
+    if (!batch_group->batch_idle_frame_counts)
     {
         return ZFW_FALSE;
     }
 
-    // Initialise the slot activity bitset.
-    zfw_init_bitset_in_mem_arena(&batch_group->slot_activity, ZFW_SPRITE_BATCH_SLOT_LIMIT * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, main_mem_arena);
+    memset(batch_group->batch_idle_frame_counts, 0, sizeof(*batch_group->batch_idle_frame_counts) * batch_group_batch_count);
+
+    // Allocate memory for batch live slot bounds.
+    batch_group->batch_live_slot_bounds = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_live_slot_bounds) * batch_group_batch_count);
+
+    if (!batch_group->batch_live_slot_bounds)
+    {
+        return ZFW_FALSE;
+    }
+
+    // Allocate memory for batch vertex stagings. The vertex stores themselves are only allocated once a batch is activated.
+    batch_group->batch_stagings = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_stagings) * batch_group_batch_count);
+
+    if (!batch_group->batch_stagings)
+    {
+        return ZFW_FALSE;
+    }
+
+    memset(batch_group->batch_stagings, 0, sizeof(*batch_group->batch_stagings) * batch_group_batch_count);
 
     return ZFW_TRUE;
 }
 
 void zfw_clean_sprite_batch_group(zfw_sprite_batch_group_t *const batch_group)
 {
-    if (batch_group->elem_buf_gl_ids)
+    if (batch_group->batch_stagings)
+    {
+        for (int i = 0; i < ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT; i++)
+        {
+            free(batch_group->batch_stagings[i].insts);
+        }
+    }
+
+    if (batch_group->batch_slot_activities)
     {
-        glDeleteBuffers(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->elem_buf_gl_ids);
+        for (int i = 0; i < ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT; i++)
+        {
+            free(batch_group->batch_slot_activities[i]);
+        }
+    }
+
+    if (batch_group->quad_vert_buf_gl_id)
+    {
+        glDeleteBuffers(1, &batch_group->quad_vert_buf_gl_id);
     }
 
-    if (batch_group->vert_buf_gl_ids)
+    // IDs of batches that were never activated are 0, which OpenGL silently ignores.
+    if (batch_group->inst_buf_gl_ids)
     {
-        glDeleteBuffers(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->vert_buf_gl_ids);
+        glDeleteBuffers(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->inst_buf_gl_ids);
     }
 
     if (batch_group->vert_array_gl_ids)
@@ -252,10 +1075,70 @@ void zfw_set_sprite_batch_group_defaults(zfw_sprite_batch_group_t *const batch_g
 {
     memset(batch_group->batch_activity_bits, 0, sizeof(batch_group->batch_activity_bits));
     memset(batch_group->tex_units, 0, sizeof(*batch_group->tex_units) * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT);
-    zfw_clear_bitset(&batch_group->slot_activity);
+    memset(batch_group->batch_live_slot_bounds, 0, sizeof(*batch_group->batch_live_slot_bounds) * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT);
+    memset(batch_group->batch_idle_frame_counts, 0, sizeof(*batch_group->batch_idle_frame_counts) * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT);
+
+    // Slot activities are reset when their batches are next activated.
+}
+
+void zfw_release_idle_sprite_batches(zfw_sprite_batch_group_t *const batch_group)
+{
+    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+    {
+        if (!batch_group->batch_activity_bits[i])
+        {
+            continue;
+        }
+
+        for (int j = 0; j < ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT; j++)
+        {
+            const zfw_render_layer_sprite_batch_activity_bits_t batch_bitmask = (zfw_render_layer_sprite_batch_activity_bits_t)1 << j;
+
+            if (!(batch_group->batch_activity_bits[i] & batch_bitmask))
+            {
+                continue;
+            }
+
+            const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(i, j);
+
+            // A batch with no active slots has no keys referring to it, so it can be released without affecting the user.
+            if (batch_group->batch_live_slot_bounds[batch_group_batch_index])
+            {
+                batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+                continue;
+            }
+
+            batch_group->batch_idle_frame_counts[batch_group_batch_index]++;
+
+            if (batch_group->batch_idle_frame_counts[batch_group_batch_index] < ZFW_RENDER_BATCH_IDLE_FRAME_LIMIT)
+            {
+                continue;
+            }
+
+            glDeleteBuffers(1, &batch_group->inst_buf_gl_ids[batch_group_batch_index]);
+            batch_group->inst_buf_gl_ids[batch_group_batch_index] = 0;
+
+            glDeleteVertexArrays(1, &batch_group->vert_array_gl_ids[batch_group_batch_index]);
+            batch_group->vert_array_gl_ids[batch_group_batch_index] = 0;
+
+            free(batch_group->batch_stagings[batch_group_batch_index].insts);
+            batch_group->batch_stagings[batch_group_batch_index].insts = NULL;
+            batch_group->batch_stagings[batch_group_batch_index].dirty_bits = 0;
+
+            free(batch_group->batch_slot_activities[batch_group_batch_index]);
+            batch_group->batch_slot_activities[batch_group_batch_index] = NULL;
+
+            memset(&batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(i, j, 0)], 0, sizeof(*batch_group->tex_units) * ZFW_SPRITE_BATCH_TEX_UNIT_LIMIT);
+
+            batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+            batch_group->batch_activity_bits[i] &= ~batch_bitmask;
+        }
+    }
 }
 
-zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], zfw_mem_arena_t *const main_mem_arena)
+// Takes a slot, activating a new batch and retrying if none have room. This is kept apart from the public function so
+// that the retry isn't captured as a second take.
+static zfw_sprite_batch_slot_key_t take_render_layer_sprite_batch_slot(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
 {
     int first_inactive_batch_index = -1;
 
@@ -273,42 +1156,29 @@ zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sp
         }
 
         // Find a texture unit to use.
-        int tex_unit_index = -1;
-
-        for (int j = 0; j < get_gl_tex_unit_limit(); j++)
-        {
-            const zfw_sprite_batch_tex_unit_t tex_unit = batch_groups[batch_group_id].tex_units[zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, j)];
-
-            if (tex_unit.count == 0 || tex_unit.user_tex_index == user_tex_index)
-            {
-                tex_unit_index = j;
-                break;
-            }
-        }
+        const int tex_unit_index = find_sprite_batch_tex_unit(&batch_groups[batch_group_id], layer_index, i, user_tex_index);
 
         if (tex_unit_index == -1)
         {
             continue;
         }
 
-        // Find an available batch slot by searching through the bitset.
-        const int slot_activity_bitset_begin_bit_index = (layer_index * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_SPRITE_BATCH_SLOT_LIMIT) + (i * ZFW_SPRITE_BATCH_SLOT_LIMIT);
-        const int slot_activity_bitset_first_inactive_bit_index = zfw_get_first_inactive_bitset_bit_index_in_range(&batch_groups[batch_group_id].slot_activity, slot_activity_bitset_begin_bit_index, slot_activity_bitset_begin_bit_index + ZFW_SPRITE_BATCH_SLOT_LIMIT);
+        // Take an available batch slot if there is one.
+        const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(layer_index, i);
+        const int slot_index = take_sprite_batch_slot(batch_groups[batch_group_id].batch_slot_activities[batch_group_batch_index]);
 
-        if (slot_activity_bitset_first_inactive_bit_index != -1)
+        if (slot_index != -1)
         {
-            // Take the slot and return a key.
-            zfw_activate_bitset_bit(&batch_groups[batch_group_id].slot_activity, slot_activity_bitset_first_inactive_bit_index);
+            assign_sprite_batch_slot_user_tex(&batch_groups[batch_group_id], batch_group_batch_index, zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, tex_unit_index), slot_index, user_tex_index);
 
-            const int batch_group_tex_unit_index = zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, tex_unit_index);
-            batch_groups[batch_group_id].tex_units[batch_group_tex_unit_index].user_tex_index = user_tex_index;
-            batch_groups[batch_group_id].tex_units[batch_group_tex_unit_index].count++;
+            int *const live_slot_bound = &batch_groups[batch_group_id].batch_live_slot_bounds[batch_group_batch_index];
+            *live_slot_bound = ZFW_MAX(slot_index + 1, *live_slot_bound);
 
             int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
             slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX] = batch_group_id;
             slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX] = layer_index;
             slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX] = i;
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] = slot_activity_bitset_first_inactive_bit_index - slot_activity_bitset_begin_bit_index;
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] = slot_index;
             slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX] = tex_unit_index;
 
             return zfw_create_sprite_batch_slot_key(slot_key_elems);
@@ -318,9 +1188,9 @@ zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sp
     if (first_inactive_batch_index != -1)
     {
         // Initialise and activate a new sprite batch. If successful, try this all again.
-        if (init_and_activate_render_layer_sprite_batch(layer_index, first_inactive_batch_index, &batch_groups[batch_group_id], main_mem_arena))
+        if (init_and_activate_render_layer_sprite_batch(layer_index, first_inactive_batch_index, &batch_groups[batch_group_id]))
         {
-            return zfw_take_render_layer_sprite_batch_slot(batch_group_id, layer_index, user_tex_index, batch_groups, main_mem_arena);
+            return take_render_layer_sprite_batch_slot(batch_group_id, layer_index, user_tex_index, batch_groups);
         }
     }
 
@@ -328,14 +1198,10 @@ zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sp
     return 0;
 }
 
-void zfw_take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], zfw_mem_arena_t *const main_mem_arena)
+// Takes multiple slots, activating new batches and retrying until enough have been found or no more batches can be
+// activated. Like the single slot version, retries are kept out of the capture.
+static void take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
 {
-    if (slot_key_count <= 0)
-    {
-        zfw_log_warning("Invalid \"slot_key_count\" parameter value (%d) for function \"zfw_take_multiple_slots_from_render_layer_sprite_batch\".", slot_key_count);
-        return;
-    }
-
     int slots_found_count = 0;
     int first_inactive_batch_index = -1;
 
@@ -353,157 +1219,392 @@ void zfw_take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key
         }
 
         // Find a texture unit to use.
-        int tex_unit_index = -1;
+        const int tex_unit_index = find_sprite_batch_tex_unit(&batch_groups[batch_group_id], layer_index, i, user_tex_index);
+
+        if (tex_unit_index == -1)
+        {
+            continue;
+        }
+
+        // Take available batch slots until either enough have been found or the batch is full.
+        const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(layer_index, i);
+        const int batch_group_tex_unit_index = zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, tex_unit_index);
+        zfw_sprite_batch_slot_activity_t *const slot_activity = batch_groups[batch_group_id].batch_slot_activities[batch_group_batch_index];
+        int *const live_slot_bound = &batch_groups[batch_group_id].batch_live_slot_bounds[batch_group_batch_index];
+
+        int j;
 
-        for (int j = 0; j < get_gl_tex_unit_limit(); j++)
+        while ((j = take_sprite_batch_slot(slot_activity)) != -1)
         {
-            const zfw_sprite_batch_tex_unit_t tex_unit = batch_groups[batch_group_id].tex_units[zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, j)];
+            assign_sprite_batch_slot_user_tex(&batch_groups[batch_group_id], batch_group_batch_index, batch_group_tex_unit_index, j, user_tex_index);
+
+            *live_slot_bound = ZFW_MAX(j + 1, *live_slot_bound);
+
+            int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX] = batch_group_id;
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX] = layer_index;
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX] = i;
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] = j;
+            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX] = tex_unit_index;
+
+            slot_keys[slots_found_count] = zfw_create_sprite_batch_slot_key(slot_key_elems);
 
-            if (tex_unit.count == 0 || tex_unit.user_tex_index == user_tex_index)
+            slots_found_count++;
+
+            if (slots_found_count == slot_key_count)
             {
-                tex_unit_index = j;
-                break;
+                return;
             }
         }
+    }
 
-        if (tex_unit_index == -1)
+    if (first_inactive_batch_index != -1)
+    {
+        // Initialise and activate a new sprite batch. If successful, try this all again.
+        if (init_and_activate_render_layer_sprite_batch(layer_index, first_inactive_batch_index, &batch_groups[batch_group_id]))
         {
-            continue;
+            take_multiple_render_layer_sprite_batch_slots(slot_keys + slots_found_count, slot_key_count - slots_found_count, batch_group_id, layer_index, user_tex_index, batch_groups);
+        }
+    }
+}
+
+zfw_sprite_batch_slot_key_t zfw_take_render_layer_sprite_batch_slot(const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
+{
+    const zfw_render_capture_take_sprite_batch_slot_cmd_t capture_cmd = {batch_group_id, layer_index, user_tex_index, 1};
+    begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_SPRITE_BATCH_SLOT, &capture_cmd, sizeof(capture_cmd), 0);
+
+    return take_render_layer_sprite_batch_slot(batch_group_id, layer_index, user_tex_index, batch_groups);
+}
+
+void zfw_take_multiple_render_layer_sprite_batch_slots(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int user_tex_index, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
+{
+    const zfw_render_capture_take_sprite_batch_slot_cmd_t capture_cmd = {batch_group_id, layer_index, user_tex_index, slot_key_count};
+    begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_MULTIPLE_SPRITE_BATCH_SLOTS, &capture_cmd, sizeof(capture_cmd), 0);
+
+    if (slot_key_count <= 0)
+    {
+        zfw_log_warning("Invalid \"slot_key_count\" parameter value (%d) for function \"zfw_take_multiple_slots_from_render_layer_sprite_batch\".", slot_key_count);
+        return;
+    }
+
+    take_multiple_render_layer_sprite_batch_slots(slot_keys, slot_key_count, batch_group_id, layer_index, user_tex_index, batch_groups);
+}
+
+zfw_bool_t zfw_write_to_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_user_tex_data_t *const user_tex_data)
+{
+    const zfw_render_capture_write_sprite_batch_slot_cmd_t capture_cmd = {slot_key, pos, rot, scale, origin, *src_rect, *blend};
+    begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOT, &capture_cmd, sizeof(capture_cmd), 0);
+
+    if (!zfw_is_sprite_batch_slot_key_active(slot_key))
+    {
+        zfw_log_warning("Attempting to write to a render layer sprite batch slot using an inactive key!");
+        return ZFW_FALSE;
+    }
+
+    int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
+    zfw_init_sprite_batch_slot_key_elems(slot_key, slot_key_elems);
+
+    const zfw_sprite_batch_group_t *const batch_group = &batch_groups[slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX]];
+
+    // Write to the staging store, to be uploaded when rendering.
+    const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX]);
+    zfw_sprite_inst_t *const inst = get_sprite_batch_staging_slot_inst(batch_group, batch_group_batch_index, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]);
+
+    // In texture array mode the texture index was set to the layer when the slot was taken, and texture coordinates are
+    // normalised against the layer size, since smaller textures only occupy the top-left of their layer.
+    zfw_vec_2d_i_t tex_coords_size = user_tex_data->array_size;
+
+    if (!batch_group->tex_array)
+    {
+        const int user_tex_index = batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX])].user_tex_index;
+        tex_coords_size = user_tex_data->sizes[user_tex_index];
+
+        inst->tex_index = slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX];
+    }
+
+    write_sprite_inst(inst, pos, rot, scale, origin, src_rect, blend, tex_coords_size);
+
+    return ZFW_TRUE;
+}
+
+// The instance data of a block of sprites in structure-of-arrays form, generated together ahead of being scattered to the
+// staging stores.
+typedef struct
+{
+    zfw_sprite_inst_t *insts[SPRITE_BULK_WRITE_BLOCK_SIZE]; // NULL where the slot key was inactive.
+
+    float rot_coses[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float rot_sins[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float tex_coords_size_recips_x[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float tex_coords_size_recips_y[SPRITE_BULK_WRITE_BLOCK_SIZE];
+
+    float pos_xs[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float pos_ys[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float size_xs[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float size_ys[SPRITE_BULK_WRITE_BLOCK_SIZE];
+    float tex_coords[4][SPRITE_BULK_WRITE_BLOCK_SIZE]; // Left, top, right, bottom.
+} sprite_bulk_write_block_t;
+
+// Generates the positions, sizes and texture coordinates of the first count sprites of a block. The rotations and texture
+// coordinate size reciprocals of the block must already be set.
+static void gen_sprite_bulk_write_block_verts(sprite_bulk_write_block_t *const block, const int count, const zfw_vec_2d_t *const positions, const zfw_vec_2d_t *const scales, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rects)
+{
+    int i = 0;
+
+#if defined(SIMD_SSE2)
+    const __m128 origin_x = _mm_set1_ps(origin.x);
+    const __m128 origin_y = _mm_set1_ps(origin.y);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        // Deinterleave the position and scale vectors into separate X and Y lanes.
+        const __m128 positions_lo = _mm_loadu_ps(&positions[i].x);
+        const __m128 positions_hi = _mm_loadu_ps(&positions[i + 2].x);
+        const __m128 pos_x = _mm_shuffle_ps(positions_lo, positions_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 pos_y = _mm_shuffle_ps(positions_lo, positions_hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+        const __m128 scales_lo = _mm_loadu_ps(&scales[i].x);
+        const __m128 scales_hi = _mm_loadu_ps(&scales[i + 2].x);
+        const __m128 scale_x = _mm_shuffle_ps(scales_lo, scales_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 scale_y = _mm_shuffle_ps(scales_lo, scales_hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+        // Transpose the source rectangles into X, Y, width and height lanes.
+        __m128 src_rect_x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src_rects[i]));
+        __m128 src_rect_y = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src_rects[i + 1]));
+        __m128 src_rect_width = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src_rects[i + 2]));
+        __m128 src_rect_height = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)&src_rects[i + 3]));
+        _MM_TRANSPOSE4_PS(src_rect_x, src_rect_y, src_rect_width, src_rect_height);
+
+        const __m128 rot_cos = _mm_loadu_ps(&block->rot_coses[i]);
+        const __m128 rot_sin = _mm_loadu_ps(&block->rot_sins[i]);
+
+        const __m128 size_x = _mm_mul_ps(src_rect_width, scale_x);
+        const __m128 size_y = _mm_mul_ps(src_rect_height, scale_y);
+        const __m128 origin_offs_x = _mm_mul_ps(size_x, origin_x);
+        const __m128 origin_offs_y = _mm_mul_ps(size_y, origin_y);
+
+        _mm_storeu_ps(&block->pos_xs[i], _mm_sub_ps(pos_x, _mm_add_ps(_mm_mul_ps(origin_offs_x, rot_cos), _mm_mul_ps(origin_offs_y, rot_sin))));
+        _mm_storeu_ps(&block->pos_ys[i], _mm_sub_ps(pos_y, _mm_sub_ps(_mm_mul_ps(origin_offs_y, rot_cos), _mm_mul_ps(origin_offs_x, rot_sin))));
+        _mm_storeu_ps(&block->size_xs[i], size_x);
+        _mm_storeu_ps(&block->size_ys[i], size_y);
+
+        const __m128 tex_coords_size_recip_x = _mm_loadu_ps(&block->tex_coords_size_recips_x[i]);
+        const __m128 tex_coords_size_recip_y = _mm_loadu_ps(&block->tex_coords_size_recips_y[i]);
+
+        _mm_storeu_ps(&block->tex_coords[0][i], _mm_mul_ps(src_rect_x, tex_coords_size_recip_x));
+        _mm_storeu_ps(&block->tex_coords[1][i], _mm_mul_ps(src_rect_y, tex_coords_size_recip_y));
+        _mm_storeu_ps(&block->tex_coords[2][i], _mm_mul_ps(_mm_add_ps(src_rect_x, src_rect_width), tex_coords_size_recip_x));
+        _mm_storeu_ps(&block->tex_coords[3][i], _mm_mul_ps(_mm_add_ps(src_rect_y, src_rect_height), tex_coords_size_recip_y));
+    }
+#elif defined(SIMD_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        // The structured loads deinterleave the vectors and rectangles into separate lanes for each component.
+        const float32x4x2_t pos = vld2q_f32(&positions[i].x);
+        const float32x4x2_t scale = vld2q_f32(&scales[i].x);
+        const int32x4x4_t src_rect = vld4q_s32(&src_rects[i].x);
+
+        const float32x4_t src_rect_x = vcvtq_f32_s32(src_rect.val[0]);
+        const float32x4_t src_rect_y = vcvtq_f32_s32(src_rect.val[1]);
+        const float32x4_t src_rect_width = vcvtq_f32_s32(src_rect.val[2]);
+        const float32x4_t src_rect_height = vcvtq_f32_s32(src_rect.val[3]);
+
+        const float32x4_t rot_cos = vld1q_f32(&block->rot_coses[i]);
+        const float32x4_t rot_sin = vld1q_f32(&block->rot_sins[i]);
+
+        const float32x4_t size_x = vmulq_f32(src_rect_width, scale.val[0]);
+        const float32x4_t size_y = vmulq_f32(src_rect_height, scale.val[1]);
+        const float32x4_t origin_offs_x = vmulq_n_f32(size_x, origin.x);
+        const float32x4_t origin_offs_y = vmulq_n_f32(size_y, origin.y);
+
+        vst1q_f32(&block->pos_xs[i], vsubq_f32(pos.val[0], vaddq_f32(vmulq_f32(origin_offs_x, rot_cos), vmulq_f32(origin_offs_y, rot_sin))));
+        vst1q_f32(&block->pos_ys[i], vsubq_f32(pos.val[1], vsubq_f32(vmulq_f32(origin_offs_y, rot_cos), vmulq_f32(origin_offs_x, rot_sin))));
+        vst1q_f32(&block->size_xs[i], size_x);
+        vst1q_f32(&block->size_ys[i], size_y);
+
+        const float32x4_t tex_coords_size_recip_x = vld1q_f32(&block->tex_coords_size_recips_x[i]);
+        const float32x4_t tex_coords_size_recip_y = vld1q_f32(&block->tex_coords_size_recips_y[i]);
+
+        vst1q_f32(&block->tex_coords[0][i], vmulq_f32(src_rect_x, tex_coords_size_recip_x));
+        vst1q_f32(&block->tex_coords[1][i], vmulq_f32(src_rect_y, tex_coords_size_recip_y));
+        vst1q_f32(&block->tex_coords[2][i], vmulq_f32(vaddq_f32(src_rect_x, src_rect_width), tex_coords_size_recip_x));
+        vst1q_f32(&block->tex_coords[3][i], vmulq_f32(vaddq_f32(src_rect_y, src_rect_height), tex_coords_size_recip_y));
+    }
+#endif
+
+    // Handle whatever is left over (or everything, if no SIMD instruction set is available).
+    for (; i < count; i++)
+    {
+        const float size_x = src_rects[i].width * scales[i].x;
+        const float size_y = src_rects[i].height * scales[i].y;
+        const float origin_offs_x = size_x * origin.x;
+        const float origin_offs_y = size_y * origin.y;
+
+        block->pos_xs[i] = positions[i].x - ((origin_offs_x * block->rot_coses[i]) + (origin_offs_y * block->rot_sins[i]));
+        block->pos_ys[i] = positions[i].y - ((origin_offs_y * block->rot_coses[i]) - (origin_offs_x * block->rot_sins[i]));
+        block->size_xs[i] = size_x;
+        block->size_ys[i] = size_y;
+
+        block->tex_coords[0][i] = src_rects[i].x * block->tex_coords_size_recips_x[i];
+        block->tex_coords[1][i] = src_rects[i].y * block->tex_coords_size_recips_y[i];
+        block->tex_coords[2][i] = (src_rects[i].x + src_rects[i].width) * block->tex_coords_size_recips_x[i];
+        block->tex_coords[3][i] = (src_rects[i].y + src_rects[i].height) * block->tex_coords_size_recips_y[i];
+    }
+}
+
+static void write_sprite_inst_blend(zfw_sprite_inst_t *const inst, const zfw_color_t *const blend)
+{
+#if defined(SIMD_SSE2)
+    // Clamp, scale and round all four elements at once, then narrow them down to bytes.
+    __m128 elems = _mm_loadu_ps(&blend->r);
+    elems = _mm_min_ps(_mm_max_ps(elems, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    elems = _mm_add_ps(_mm_mul_ps(elems, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+
+    __m128i bytes = _mm_cvttps_epi32(elems);
+    bytes = _mm_packs_epi32(bytes, bytes);
+    bytes = _mm_packus_epi16(bytes, bytes);
+
+    const int packed_bytes = _mm_cvtsi128_si32(bytes);
+    memcpy(inst->blend, &packed_bytes, sizeof(inst->blend));
+#elif defined(SIMD_NEON)
+    float32x4_t elems = vld1q_f32(&blend->r);
+    elems = vminq_f32(vmaxq_f32(elems, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    elems = vmlaq_n_f32(vdupq_n_f32(0.5f), elems, 255.0f);
+
+    const uint16x4_t shorts = vmovn_u32(vcvtq_u32_f32(elems));
+    const uint8x8_t bytes = vmovn_u16(vcombine_u16(shorts, shorts));
+
+    const uint32_t packed_bytes = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+    memcpy(inst->blend, &packed_bytes, sizeof(inst->blend));
+#else
+    inst->blend[0] = zfw_get_color_elem_as_byte(blend->r);
+    inst->blend[1] = zfw_get_color_elem_as_byte(blend->g);
+    inst->blend[2] = zfw_get_color_elem_as_byte(blend->b);
+    inst->blend[3] = zfw_get_color_elem_as_byte(blend->a);
+#endif
+}
+
+zfw_bool_t zfw_write_sprite_batch_slots_bulk(const zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const zfw_vec_2d_t *const positions, const float *const rots, const zfw_vec_2d_t *const scales, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rects, const zfw_color_t *const blends, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_user_tex_data_t *const user_tex_data)
+{
+    const zfw_render_capture_write_sprite_batch_slots_bulk_cmd_t capture_cmd = {slot_key_count, origin, rots != NULL};
+    const int capture_trailing_size = slot_key_count * (sizeof(*slot_keys) + sizeof(*positions) + (rots ? sizeof(*rots) : 0) + sizeof(*scales) + sizeof(*src_rects) + sizeof(*blends));
+
+    if (begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOTS_BULK, &capture_cmd, sizeof(capture_cmd), capture_trailing_size))
+    {
+        write_render_capture_data(batch_groups->capture, slot_keys, sizeof(*slot_keys) * slot_key_count);
+        write_render_capture_data(batch_groups->capture, positions, sizeof(*positions) * slot_key_count);
+
+        if (rots)
+        {
+            write_render_capture_data(batch_groups->capture, rots, sizeof(*rots) * slot_key_count);
         }
 
-        // Search for and take inactive batch slots.
-        const int slot_activity_bitset_begin_bit_index = (ZFW_SPRITE_BATCH_SLOT_LIMIT * ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * layer_index) + (i * ZFW_SPRITE_BATCH_SLOT_LIMIT);
-        const int batch_group_tex_unit_index = zfw_get_sprite_batch_group_tex_unit_index(layer_index, i, tex_unit_index);
+        write_render_capture_data(batch_groups->capture, scales, sizeof(*scales) * slot_key_count);
+        write_render_capture_data(batch_groups->capture, src_rects, sizeof(*src_rects) * slot_key_count);
+        write_render_capture_data(batch_groups->capture, blends, sizeof(*blends) * slot_key_count);
+    }
+
+    zfw_bool_t all_keys_active = ZFW_TRUE;
+
+    sprite_bulk_write_block_t block;
+
+    for (int block_begin = 0; block_begin < slot_key_count; block_begin += SPRITE_BULK_WRITE_BLOCK_SIZE)
+    {
+        const int block_count = ZFW_MIN(slot_key_count - block_begin, SPRITE_BULK_WRITE_BLOCK_SIZE);
 
-        for (int j = 0; j < ZFW_SPRITE_BATCH_SLOT_LIMIT; j++)
+        // Resolve the staging instance and texture of each slot, and work out the rotations.
+        for (int i = 0; i < block_count; i++)
         {
-            if (zfw_is_bitset_bit_active(&batch_groups[batch_group_id].slot_activity, slot_activity_bitset_begin_bit_index + j))
+            const zfw_sprite_batch_slot_key_t slot_key = slot_keys[block_begin + i];
+
+            if (!zfw_is_sprite_batch_slot_key_active(slot_key))
             {
+                all_keys_active = ZFW_FALSE;
+
+                block.insts[i] = NULL;
+                block.tex_coords_size_recips_x[i] = 0.0f;
+                block.tex_coords_size_recips_y[i] = 0.0f;
+                block.rot_coses[i] = 1.0f;
+                block.rot_sins[i] = 0.0f;
+
                 continue;
             }
 
-            // Take the slot and add a key.
-            zfw_activate_bitset_bit(&batch_groups[batch_group_id].slot_activity, slot_activity_bitset_begin_bit_index + j);
+            int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
+            zfw_init_sprite_batch_slot_key_elems(slot_key, slot_key_elems);
 
-            batch_groups[batch_group_id].tex_units[batch_group_tex_unit_index].user_tex_index = user_tex_index;
-            batch_groups[batch_group_id].tex_units[batch_group_tex_unit_index].count++;
+            const zfw_sprite_batch_group_t *const batch_group = &batch_groups[slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX]];
+            const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX]);
+            block.insts[i] = get_sprite_batch_staging_slot_inst(batch_group, batch_group_batch_index, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]);
 
-            int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX] = batch_group_id;
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX] = layer_index;
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX] = i;
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] = j;
-            slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX] = tex_unit_index;
+            // As with single slot writes, texture coordinates are normalised against the texture array layer size in
+            // texture array mode.
+            zfw_vec_2d_i_t tex_coords_size = user_tex_data->array_size;
 
-            slot_keys[slots_found_count] = zfw_create_sprite_batch_slot_key(slot_key_elems);
+            if (!batch_group->tex_array)
+            {
+                const int user_tex_index = batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX])].user_tex_index;
+                tex_coords_size = user_tex_data->sizes[user_tex_index];
 
-            slots_found_count++;
+                block.insts[i]->tex_index = slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX];
+            }
 
-            if (slots_found_count == slot_key_count)
+            block.tex_coords_size_recips_x[i] = 1.0f / tex_coords_size.x;
+            block.tex_coords_size_recips_y[i] = 1.0f / tex_coords_size.y;
+
+            if (rots)
             {
-                return;
+                block.rot_coses[i] = cosf(rots[block_begin + i]);
+                block.rot_sins[i] = sinf(rots[block_begin + i]);
+            }
+            else
+            {
+                block.rot_coses[i] = 1.0f;
+                block.rot_sins[i] = 0.0f;
             }
         }
-    }
 
-    if (first_inactive_batch_index != -1)
-    {
-        // Initialise and activate a new sprite batch. If successful, try this all again.
-        if (init_and_activate_render_layer_sprite_batch(layer_index, first_inactive_batch_index, &batch_groups[batch_group_id], main_mem_arena))
+        gen_sprite_bulk_write_block_verts(&block, block_count, &positions[block_begin], &scales[block_begin], origin, &src_rects[block_begin]);
+
+        // Scatter the generated data to the staging instances.
+        for (int i = 0; i < block_count; i++)
         {
-            zfw_take_multiple_render_layer_sprite_batch_slots(slot_keys + slots_found_count, slot_key_count - slots_found_count, batch_group_id, layer_index, user_tex_index, batch_groups, main_mem_arena);
+            zfw_sprite_inst_t *const inst = block.insts[i];
+
+            if (!inst)
+            {
+                continue;
+            }
+
+            inst->pos.x = block.pos_xs[i];
+            inst->pos.y = block.pos_ys[i];
+            inst->size.x = block.size_xs[i];
+            inst->size.y = block.size_ys[i];
+            inst->rot_cos_sin[0] = block.rot_coses[i];
+            inst->rot_cos_sin[1] = block.rot_sins[i];
+            inst->tex_coords[0] = block.tex_coords[0][i];
+            inst->tex_coords[1] = block.tex_coords[1][i];
+            inst->tex_coords[2] = block.tex_coords[2][i];
+            inst->tex_coords[3] = block.tex_coords[3][i];
+
+            write_sprite_inst_blend(inst, &blends[block_begin + i]);
         }
     }
-}
 
-zfw_bool_t zfw_write_to_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_user_tex_data_t *const user_tex_data)
-{
-    if (!zfw_is_sprite_batch_slot_key_active(slot_key))
+    if (!all_keys_active)
     {
-        zfw_log_warning("Attempting to write to a render layer sprite batch slot using an inactive key!");
+        zfw_log_warning("Attempting to bulk write to render layer sprite batch slots using one or more inactive keys! These were skipped.");
         return ZFW_FALSE;
     }
 
-    int slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT];
-    zfw_init_sprite_batch_slot_key_elems(slot_key, slot_key_elems);
-
-    const zfw_sprite_batch_group_t *const batch_group = &batch_groups[slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX]];
-
-    const int user_tex_index = batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX])].user_tex_index;
-    const zfw_vec_2d_i_t user_tex_size = user_tex_data->sizes[user_tex_index];
-
-    const float verts[ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT * 4] = {
-        (0.0f - origin.x) * scale.x,
-        (0.0f - origin.y) * scale.y,
-        pos.x,
-        pos.y,
-        src_rect->width,
-        src_rect->height,
-        rot,
-        slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX],
-        (float)src_rect->x / user_tex_size.x,
-        (float)src_rect->y / user_tex_size.y,
-        blend->r,
-        blend->g,
-        blend->b,
-        blend->a,
-
-        (1.0f - origin.x) * scale.x,
-        (0.0f - origin.y) * scale.y,
-        pos.x,
-        pos.y,
-        src_rect->width,
-        src_rect->height,
-        rot,
-        slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX],
-        (float)(src_rect->x + src_rect->width) / user_tex_size.x,
-        (float)src_rect->y / user_tex_size.y,
-        blend->r,
-        blend->g,
-        blend->b,
-        blend->a,
-
-        (1.0f - origin.x) * scale.x,
-        (1.0f - origin.y) * scale.y,
-        pos.x,
-        pos.y,
-        src_rect->width,
-        src_rect->height,
-        rot,
-        slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX],
-        (float)(src_rect->x + src_rect->width) / user_tex_size.x,
-        (float)(src_rect->y + src_rect->height) / user_tex_size.y,
-        blend->r,
-        blend->g,
-        blend->b,
-        blend->a,
-
-        (0.0f - origin.x) * scale.x,
-        (1.0f - origin.y) * scale.y,
-        pos.x,
-        pos.y,
-        src_rect->width,
-        src_rect->height,
-        rot,
-        slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX],
-        (float)src_rect->x / user_tex_size.x,
-        (float)(src_rect->y + src_rect->height) / user_tex_size.y,
-        blend->r,
-        blend->g,
-        blend->b,
-        blend->a
-    };
-
-    const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX]);
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
-    glBufferSubData(GL_ARRAY_BUFFER, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] * sizeof(verts), sizeof(verts), verts);
-
     return ZFW_TRUE;
 }
 
 zfw_bool_t zfw_clear_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, const zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
 {
+    const zfw_render_capture_sprite_batch_slot_cmd_t capture_cmd = {slot_key};
+    begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_SPRITE_BATCH_SLOT, &capture_cmd, sizeof(capture_cmd), 0);
+
     if (!zfw_is_sprite_batch_slot_key_active(slot_key))
     {
         zfw_log_warning("Attempting to clear a render layer sprite batch slot using an inactive key!");
@@ -516,17 +1617,22 @@ zfw_bool_t zfw_clear_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_
     const zfw_sprite_batch_group_t *const batch_group = &batch_groups[slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX]];
     const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX]);
 
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
+    // A zeroed instance has no size, so nothing is drawn for it. The texture index is kept, since in texture array mode it
+    // is the texture layer assigned when the slot was taken.
+    zfw_sprite_inst_t *const inst = get_sprite_batch_staging_slot_inst(batch_group, batch_group_batch_index, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]);
+    const float tex_index = inst->tex_index;
 
-    const float verts[ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT * 4] = {0};
-    glBufferSubData(GL_ARRAY_BUFFER, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] * sizeof(verts), sizeof(verts), verts);
+    memset(inst, 0, sizeof(*inst));
+    inst->tex_index = tex_index;
 
     return ZFW_TRUE;
 }
 
 zfw_bool_t zfw_free_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_key_t slot_key, zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
 {
+    const zfw_render_capture_sprite_batch_slot_cmd_t capture_cmd = {slot_key};
+    begin_render_capture_cmd(batch_groups->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_SPRITE_BATCH_SLOT, &capture_cmd, sizeof(capture_cmd), 0);
+
     if (!zfw_is_sprite_batch_slot_key_active(slot_key))
     {
         zfw_log_warning("Attempting to free a render layer sprite batch slot using an inactive key!");
@@ -539,53 +1645,240 @@ zfw_bool_t zfw_free_render_layer_sprite_batch_slot(const zfw_sprite_batch_slot_k
     zfw_sprite_batch_group_t *const batch_group = &batch_groups[slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_GROUP_INDEX]];
     const int batch_group_batch_index = zfw_get_sprite_batch_group_batch_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX]);
 
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
+    // A zeroed instance has no size, so nothing is drawn for it.
+    memset(get_sprite_batch_staging_slot_inst(batch_group, batch_group_batch_index, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]), 0, sizeof(zfw_sprite_inst_t));
+
+    zfw_sprite_batch_slot_activity_t *const slot_activity = batch_group->batch_slot_activities[batch_group_batch_index];
+    free_sprite_batch_slot(slot_activity, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]);
+    batch_group->batch_live_slot_bounds[batch_group_batch_index] = get_sprite_batch_live_slot_bound(slot_activity);
+
+    if (!batch_group->tex_array)
+    {
+        batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX])].count--;
+    }
+
+    return ZFW_TRUE;
+}
+
+zfw_bool_t zfw_init_sprite_queue(zfw_sprite_queue_t *const queue, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data)
+{
+    memset(queue, 0, sizeof(*queue));
+
+    queue->tex_array = user_tex_data->array_gl_id != 0;
+    queue->user_shader_prog_count = user_shader_prog_data->prog_count;
+
+    if (!zfw_init_mem_arena(&queue->cmd_arena, sizeof(zfw_sprite_queue_cmd_t) * ZFW_SPRITE_QUEUE_CMD_LIMIT))
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite queue commands!", sizeof(zfw_sprite_queue_cmd_t) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    queue->sort_elems = malloc(sizeof(*queue->sort_elems) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+
+    if (!queue->sort_elems)
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite queue sort elements!", sizeof(*queue->sort_elems) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    queue->sort_elems_scratch = malloc(sizeof(*queue->sort_elems_scratch) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+
+    if (!queue->sort_elems_scratch)
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite queue sort elements!", sizeof(*queue->sort_elems_scratch) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    queue->sorted_elems = queue->sort_elems;
+
+    queue->sorted_insts = malloc(sizeof(*queue->sorted_insts) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+
+    if (!queue->sorted_insts)
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite queue instances!", sizeof(*queue->sorted_insts) * ZFW_SPRITE_QUEUE_CMD_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    // Set up the vertex array, sharing the instance attribute layout of sprite batches.
+    glGenVertexArrays(1, &queue->vert_array_gl_id);
+    glBindVertexArray(queue->vert_array_gl_id);
 
-    const float verts[ZFW_BUILTIN_SPRITE_QUAD_SHADER_PROG_VERT_COUNT * 4] = {0};
-    glBufferSubData(GL_ARRAY_BUFFER, slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX] * sizeof(verts), sizeof(verts), verts);
+    queue->quad_vert_buf_gl_id = gen_sprite_quad_vert_buf();
 
-    zfw_deactivate_bitset_bit(&batch_group->slot_activity, zfw_get_sprite_batch_group_slot_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__SLOT_INDEX]));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void *)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &queue->inst_buf_gl_id);
+    glBindBuffer(GL_ARRAY_BUFFER, queue->inst_buf_gl_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(*queue->sorted_insts) * ZFW_SPRITE_QUEUE_CMD_LIMIT, NULL, GL_STREAM_DRAW);
 
-    batch_group->tex_units[zfw_get_sprite_batch_group_tex_unit_index(slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__LAYER_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__BATCH_INDEX], slot_key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_ID__TEX_UNIT_INDEX])].count--;
+    set_up_sprite_inst_vert_attribs();
+
+    glBindVertexArray(0);
 
     return ZFW_TRUE;
 }
 
-zfw_sprite_batch_slot_key_t zfw_create_sprite_batch_slot_key(const int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT])
+void zfw_clean_sprite_queue(zfw_sprite_queue_t *const queue)
 {
-    zfw_sprite_batch_slot_key_t slot_key = 1; // Initialise the key as active.
-    int bit_index = 1;
+    if (queue->inst_buf_gl_id)
+    {
+        glDeleteBuffers(1, &queue->inst_buf_gl_id);
+    }
+
+    if (queue->quad_vert_buf_gl_id)
+    {
+        glDeleteBuffers(1, &queue->quad_vert_buf_gl_id);
+    }
+
+    if (queue->vert_array_gl_id)
+    {
+        glDeleteVertexArrays(1, &queue->vert_array_gl_id);
+    }
 
-    for (int i = 0; i < ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT; i++)
+    free(queue->sorted_insts);
+    free(queue->sort_elems_scratch);
+    free(queue->sort_elems);
+
+    if (queue->cmd_arena.buf)
     {
-        slot_key |= key_elems[i] << bit_index;
-        bit_index += get_sprite_batch_slot_key_elem_bit_count(i);
+        zfw_clean_mem_arena(&queue->cmd_arena);
     }
+}
+
+void zfw_reset_sprite_queue(zfw_sprite_queue_t *const queue)
+{
+    begin_render_capture_cmd(queue->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__RESET_SPRITE_QUEUE, NULL, 0, 0);
 
-    return slot_key;
+    zfw_reset_mem_arena(&queue->cmd_arena);
+    queue->cmd_count = 0;
+    queue->prepared = ZFW_FALSE;
 }
 
-int zfw_get_sprite_batch_slot_key_elem(const zfw_sprite_batch_slot_key_t slot_key, const zfw_sprite_batch_slot_key_elem_id_t elem_id)
+zfw_bool_t zfw_submit_sprite(zfw_sprite_queue_t *const queue, const zfw_sprite_batch_group_id_t batch_group_id, const int layer_index, const int depth, const int user_tex_index, const int user_shader_prog_index, const zfw_vec_2d_t pos, const float rot, const zfw_vec_2d_t scale, const zfw_vec_2d_t origin, const zfw_rect_t *const src_rect, const zfw_color_t *const blend, const zfw_user_tex_data_t *const user_tex_data)
 {
-    int bit_index = 1; // (Skip the activity bit.)
+    const zfw_render_capture_submit_sprite_cmd_t capture_cmd = {batch_group_id, layer_index, depth, user_tex_index, user_shader_prog_index, pos, rot, scale, origin, *src_rect, *blend};
+    begin_render_capture_cmd(queue->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__SUBMIT_SPRITE, &capture_cmd, sizeof(capture_cmd), 0);
+
+    if (layer_index < 0 || layer_index >= ZFW_RENDER_LAYER_LIMIT)
+    {
+        zfw_log_warning("Attempting to submit a sprite to an invalid render layer (%d)!", layer_index);
+        return ZFW_FALSE;
+    }
+
+    if (user_tex_index < 0 || user_tex_index >= user_tex_data->tex_count)
+    {
+        zfw_log_warning("Attempting to submit a sprite with an invalid user texture index (%d)!", user_tex_index);
+        return ZFW_FALSE;
+    }
+
+    if (user_shader_prog_index < ZFW_SPRITE_QUEUE_BUILTIN_SHADER_PROG_INDEX || user_shader_prog_index >= queue->user_shader_prog_count || user_shader_prog_index + 1 >= (1 << SPRITE_QUEUE_KEY_SHADER_PROG_BIT_COUNT))
+    {
+        zfw_log_warning("Attempting to submit a sprite with an invalid user shader program index (%d)!", user_shader_prog_index);
+        return ZFW_FALSE;
+    }
 
-    for (int i = 0; i < elem_id; i++)
+    if (queue->cmd_count == ZFW_SPRITE_QUEUE_CMD_LIMIT)
     {
-        bit_index += get_sprite_batch_slot_key_elem_bit_count(i);
+        zfw_log_warning("Attempting to submit a sprite to a full sprite queue!");
+        return ZFW_FALSE;
     }
 
-    return (slot_key >> bit_index) & (get_sprite_batch_slot_key_elem_bit_count(elem_id) - 1);
+    // Commands are allocated contiguously, so the arena buffer doubles as the command array.
+    zfw_sprite_queue_cmd_t *const cmd = zfw_mem_arena_alloc(&queue->cmd_arena, sizeof(*cmd));
+    queue->cmd_count++;
+    queue->prepared = ZFW_FALSE;
+
+    cmd->key = ((zfw_sprite_queue_key_t)batch_group_id << SPRITE_QUEUE_KEY_BATCH_GROUP_SHIFT)
+        | ((zfw_sprite_queue_key_t)layer_index << SPRITE_QUEUE_KEY_LAYER_SHIFT)
+        | ((zfw_sprite_queue_key_t)(user_shader_prog_index + 1) << SPRITE_QUEUE_KEY_SHADER_PROG_SHIFT)
+        | ((zfw_sprite_queue_key_t)user_tex_index << SPRITE_QUEUE_KEY_TEX_SHIFT)
+        | ((zfw_sprite_queue_key_t)ZFW_CLAMP(depth, 0, ZFW_SPRITE_QUEUE_DEPTH_LIMIT - 1) << SPRITE_QUEUE_KEY_DEPTH_SHIFT);
+
+    // In texture array mode the texture index is the array layer. Otherwise, each run of commands has its texture bound to
+    // the first unit.
+    cmd->inst.tex_index = queue->tex_array ? user_tex_index : 0;
+
+    write_sprite_inst(&cmd->inst, pos, rot, scale, origin, src_rect, blend, queue->tex_array ? user_tex_data->array_size : user_tex_data->sizes[user_tex_index]);
+
+    return ZFW_TRUE;
 }
 
-void zfw_init_sprite_batch_slot_key_elems(const zfw_sprite_batch_slot_key_t slot_key, int key_elems[ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT])
+void zfw_prepare_sprite_queue(zfw_sprite_queue_t *const queue, zfw_profiler_counters_t *const profiler_counters)
 {
-    int bit_index = 1; // (Skip the activity bit.)
+    profiler_counters->sprite_queue_cmd_count = queue->cmd_count;
+
+    if (queue->prepared)
+    {
+        return;
+    }
+
+    queue->prepared = ZFW_TRUE;
+
+    const zfw_sprite_queue_cmd_t *const cmds = queue->cmd_arena.buf;
+
+    for (int i = 0; i < queue->cmd_count; i++)
+    {
+        queue->sort_elems[i].key = cmds[i].key;
+        queue->sort_elems[i].cmd_index = i;
+    }
+
+    // Sort with a least significant digit radix sort, which is stable, so commands with equal keys keep their submission
+    // order. Passes over digits that are the same for every command are skipped.
+    zfw_sprite_queue_sort_elem_t *src_elems = queue->sort_elems;
+    zfw_sprite_queue_sort_elem_t *dest_elems = queue->sort_elems_scratch;
 
-    for (int i = 0; i < ZFW_SPRITE_BATCH_SLOT_KEY_ELEM_COUNT; i++)
+    for (int shift = 0; shift < SPRITE_QUEUE_KEY_BIT_COUNT; shift += SPRITE_QUEUE_RADIX_BIT_COUNT)
     {
-        key_elems[i] = (slot_key >> bit_index) & ((1 << get_sprite_batch_slot_key_elem_bit_count(i)) - 1);
-        bit_index += get_sprite_batch_slot_key_elem_bit_count(i);
+        int bucket_offsets[SPRITE_QUEUE_RADIX_BUCKET_COUNT] = {0};
+
+        for (int i = 0; i < queue->cmd_count; i++)
+        {
+            bucket_offsets[(src_elems[i].key >> shift) & (SPRITE_QUEUE_RADIX_BUCKET_COUNT - 1)]++;
+        }
+
+        if (queue->cmd_count && bucket_offsets[(src_elems[0].key >> shift) & (SPRITE_QUEUE_RADIX_BUCKET_COUNT - 1)] == queue->cmd_count)
+        {
+            continue;
+        }
+
+        // Convert the bucket counts into offsets.
+        int offs = 0;
+
+        for (int i = 0; i < SPRITE_QUEUE_RADIX_BUCKET_COUNT; i++)
+        {
+            const int count = bucket_offsets[i];
+            bucket_offsets[i] = offs;
+            offs += count;
+        }
+
+        for (int i = 0; i < queue->cmd_count; i++)
+        {
+            dest_elems[bucket_offsets[(src_elems[i].key >> shift) & (SPRITE_QUEUE_RADIX_BUCKET_COUNT - 1)]++] = src_elems[i];
+        }
+
+        zfw_sprite_queue_sort_elem_t *const temp_elems = src_elems;
+        src_elems = dest_elems;
+        dest_elems = temp_elems;
+    }
+
+    queue->sorted_elems = src_elems;
+
+    // Gather the instances in sorted order and upload them all at once, orphaning the previous contents of the buffer.
+    for (int i = 0; i < queue->cmd_count; i++)
+    {
+        queue->sorted_insts[i] = cmds[queue->sorted_elems[i].cmd_index].inst;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, queue->inst_buf_gl_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(*queue->sorted_insts) * ZFW_SPRITE_QUEUE_CMD_LIMIT, NULL, GL_STREAM_DRAW);
+
+    if (queue->cmd_count)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(*queue->sorted_insts) * queue->cmd_count, queue->sorted_insts);
+
+        profiler_counters->buf_upload_count++;
+        profiler_counters->buf_upload_size += sizeof(*queue->sorted_insts) * queue->cmd_count;
     }
 }
 
@@ -595,35 +1888,55 @@ zfw_bool_t zfw_init_char_batch_group(zfw_char_batch_group_t *const batch_group,
 
     const int batch_group_batch_count = ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT;
 
-    // Generate vertex arrays after allocating memory for OpenGL IDs.
-    batch_group->vert_array_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->vert_array_gl_ids) * batch_group_batch_count);
+    // Allocate memory for batch glyph store pointers. The stores themselves are only allocated once a batch is written to.
+    batch_group->batch_glyphs = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_glyphs) * batch_group_batch_count);
 
-    if (!batch_group->vert_array_gl_ids)
+    if (!batch_group->batch_glyphs)
+    {
+        return ZFW_FALSE;
+    }
+
+    memset(batch_group->batch_glyphs, 0, sizeof(*batch_group->batch_glyphs) * batch_group_batch_count);
+
+    // Allocate memory for batch glyph counts.
+    batch_group->batch_glyph_counts = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_glyph_counts) * batch_group_batch_count);
+
+    if (!batch_group->batch_glyph_counts)
     {
         return ZFW_FALSE;
     }
 
-    glGenVertexArrays(batch_group_batch_count, batch_group->vert_array_gl_ids);
+    memset(batch_group->batch_glyph_counts, 0, sizeof(*batch_group->batch_glyph_counts) * batch_group_batch_count);
 
-    // Generate vertex buffers after allocating memory for OpenGL IDs.
-    batch_group->vert_buf_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->vert_buf_gl_ids) * batch_group_batch_count);
+    // Allocate memory for batch layout hashes. A hash of 0 means the batch holds no layout.
+    batch_group->batch_layout_hashes = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_layout_hashes) * batch_group_batch_count);
 
-    if (!batch_group->vert_buf_gl_ids)
+    if (!batch_group->batch_layout_hashes)
     {
         return ZFW_FALSE;
     }
 
-    glGenBuffers(batch_group_batch_count, batch_group->vert_buf_gl_ids);
+    memset(batch_group->batch_layout_hashes, 0, sizeof(*batch_group->batch_layout_hashes) * batch_group_batch_count);
 
-    // Generate element buffers after allocating memory for OpenGL IDs.
-    batch_group->elem_buf_gl_ids = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->elem_buf_gl_ids) * batch_group_batch_count);
+    // Allocate memory for batch glyph store capacities.
+    batch_group->batch_glyph_caps = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_glyph_caps) * batch_group_batch_count);
 
-    if (!batch_group->elem_buf_gl_ids)
+    if (!batch_group->batch_glyph_caps)
     {
         return ZFW_FALSE;
     }
 
-    glGenBuffers(batch_group_batch_count, batch_group->elem_buf_gl_ids);
+    memset(batch_group->batch_glyph_caps, 0, sizeof(*batch_group->batch_glyph_caps) * batch_group_batch_count);
+
+    // Allocate memory for batch idle frame counts.
+    batch_group->batch_idle_frame_counts = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->batch_idle_frame_counts) * batch_group_batch_count);
+
+    if (!batch_group->batch_idle_frame_counts)
+    {
+        return ZFW_FALSE;
+    }
+
+    memset(batch_group->batch_idle_frame_counts, 0, sizeof(*batch_group->batch_idle_frame_counts) * batch_group_batch_count);
 
     // Allocate memory for batch user font indexes.
     batch_group->user_font_indexes = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->user_font_indexes) * batch_group_batch_count);
@@ -652,136 +1965,307 @@ zfw_bool_t zfw_init_char_batch_group(zfw_char_batch_group_t *const batch_group,
     // Allocate memory for batch blends.
     batch_group->blends = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->blends) * batch_group_batch_count);
 
-    if (!batch_group->blends)
-    {
-        return ZFW_FALSE;
+    if (!batch_group->blends)
+    {
+        return ZFW_FALSE;
+    }
+
+    // Allocate memory for instance runs. There can be no more runs than batches, since each batch has a single font.
+    batch_group->inst_runs = zfw_mem_arena_alloc(main_mem_arena, sizeof(*batch_group->inst_runs) * batch_group_batch_count);
+
+    if (!batch_group->inst_runs)
+    {
+        return ZFW_FALSE;
+    }
+
+    // Set up the vertex array shared by all batches. The instance buffer is only given storage once there are glyphs.
+    glGenVertexArrays(1, &batch_group->vert_array_gl_id);
+    glBindVertexArray(batch_group->vert_array_gl_id);
+
+    batch_group->quad_vert_buf_gl_id = gen_sprite_quad_vert_buf();
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void *)0);
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &batch_group->inst_buf_gl_id);
+    glBindBuffer(GL_ARRAY_BUFFER, batch_group->inst_buf_gl_id);
+
+    set_up_char_inst_vert_attribs();
+
+    glBindVertexArray(0);
+
+    return ZFW_TRUE;
+}
+
+void zfw_clean_char_batch_group(zfw_char_batch_group_t *const batch_group)
+{
+    if (batch_group->inst_buf_gl_id)
+    {
+        glDeleteBuffers(1, &batch_group->inst_buf_gl_id);
+    }
+
+    if (batch_group->quad_vert_buf_gl_id)
+    {
+        glDeleteBuffers(1, &batch_group->quad_vert_buf_gl_id);
+    }
+
+    if (batch_group->vert_array_gl_id)
+    {
+        glDeleteVertexArrays(1, &batch_group->vert_array_gl_id);
+    }
+
+    free(batch_group->insts);
+
+    if (batch_group->batch_glyphs)
+    {
+        for (int i = 0; i < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT; i++)
+        {
+            free(batch_group->batch_glyphs[i]);
+        }
+    }
+}
+
+void zfw_set_char_batch_group_defaults(zfw_char_batch_group_t *const batch_group)
+{
+    memset(batch_group->batch_init_bits, 0, sizeof(batch_group->batch_init_bits));
+    memset(batch_group->batch_activity_bits, 0, sizeof(batch_group->batch_activity_bits));
+
+    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+    {
+        for (int j = 0; j < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; j++)
+        {
+            const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(i, j);
+
+            batch_group->user_font_indexes[batch_group_batch_index] = 0;
+
+            batch_group->positions[batch_group_batch_index] = zfw_create_vec_2d(0.0f, 0.0f);
+
+            batch_group->scales[batch_group_batch_index].x = 1.0f;
+            batch_group->scales[batch_group_batch_index].y = 1.0f;
+
+            batch_group->blends[batch_group_batch_index].r = 1.0f;
+            batch_group->blends[batch_group_batch_index].g = 1.0f;
+            batch_group->blends[batch_group_batch_index].b = 1.0f;
+            batch_group->blends[batch_group_batch_index].a = 1.0f;
+
+            batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+            batch_group->batch_glyph_counts[batch_group_batch_index] = 0;
+            batch_group->batch_layout_hashes[batch_group_batch_index] = 0;
+        }
+    }
+
+    batch_group->prepared = ZFW_FALSE;
+}
+
+void zfw_release_idle_char_batches(zfw_char_batch_group_t *const batch_group)
+{
+    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+    {
+        // Only batches that are initialised but not taken are idle.
+        const zfw_render_layer_char_batch_bits_t idle_batch_bits = batch_group->batch_init_bits[i] & ~batch_group->batch_activity_bits[i];
+
+        if (!idle_batch_bits)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; j++)
+        {
+            const zfw_render_layer_char_batch_bits_t batch_bitmask = (zfw_render_layer_char_batch_bits_t)1 << j;
+
+            if (!(idle_batch_bits & batch_bitmask))
+            {
+                continue;
+            }
+
+            const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(i, j);
+
+            batch_group->batch_idle_frame_counts[batch_group_batch_index]++;
+
+            if (batch_group->batch_idle_frame_counts[batch_group_batch_index] < ZFW_RENDER_BATCH_IDLE_FRAME_LIMIT)
+            {
+                continue;
+            }
+
+            free(batch_group->batch_glyphs[batch_group_batch_index]);
+            batch_group->batch_glyphs[batch_group_batch_index] = NULL;
+            batch_group->batch_glyph_caps[batch_group_batch_index] = 0;
+
+            batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+            batch_group->batch_init_bits[i] &= ~batch_bitmask;
+        }
     }
-
-    return ZFW_TRUE;
 }
 
-void zfw_clean_char_batch_group(zfw_char_batch_group_t *const batch_group)
+void zfw_prepare_char_batch_group(zfw_char_batch_group_t *const batch_group, zfw_profiler_counters_t *const profiler_counters)
 {
-    if (batch_group->elem_buf_gl_ids)
+    if (batch_group->prepared)
     {
-        glDeleteBuffers(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->elem_buf_gl_ids);
+        return;
     }
 
-    if (batch_group->vert_buf_gl_ids)
-    {
-        glDeleteBuffers(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->vert_buf_gl_ids);
-    }
+    // Count the glyphs of all active batches, growing the instance store and buffer if they can't all fit.
+    int inst_count = 0;
 
-    if (batch_group->vert_array_gl_ids)
+    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
     {
-        glDeleteVertexArrays(ZFW_RENDER_LAYER_SPRITE_BATCH_LIMIT * ZFW_RENDER_LAYER_LIMIT, batch_group->vert_array_gl_ids);
-    }
-}
+        zfw_render_layer_char_batch_bits_t batch_bits = batch_group->batch_activity_bits[i];
 
-void zfw_set_char_batch_group_defaults(zfw_char_batch_group_t *const batch_group)
-{
-    memset(batch_group->batch_init_bits, 0, sizeof(batch_group->batch_init_bits));
-    memset(batch_group->batch_activity_bits, 0, sizeof(batch_group->batch_activity_bits));
+        while (batch_bits)
+        {
+            inst_count += batch_group->batch_glyph_counts[zfw_get_char_batch_group_batch_index(i, zfw_get_index_of_lowest_active_bit_64(batch_bits))];
+            batch_bits &= batch_bits - 1;
+        }
+    }
 
-    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+    if (inst_count > batch_group->inst_cap)
     {
-        for (int j = 0; j < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; j++)
+        int inst_cap = ZFW_MAX(batch_group->inst_cap * 2, CHAR_INST_CAP_MIN);
+
+        while (inst_cap < inst_count)
         {
-            const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(i, j);
+            inst_cap *= 2;
+        }
 
-            batch_group->user_font_indexes[batch_group_batch_index] = 0;
+        zfw_char_inst_t *const insts = realloc(batch_group->insts, sizeof(*insts) * inst_cap);
 
-            batch_group->positions[batch_group_batch_index] = zfw_create_vec_2d(0.0f, 0.0f);
+        if (!insts)
+        {
+            zfw_log_error("Failed to allocate %d bytes for character batch instances!", sizeof(*insts) * inst_cap);
 
-            batch_group->scales[batch_group_batch_index].x = 1.0f;
-            batch_group->scales[batch_group_batch_index].y = 1.0f;
+            // Draw nothing rather than stale instances.
+            memset(batch_group->layer_inst_run_counts, 0, sizeof(batch_group->layer_inst_run_counts));
 
-            batch_group->blends[batch_group_batch_index].r = 1.0f;
-            batch_group->blends[batch_group_batch_index].g = 1.0f;
-            batch_group->blends[batch_group_batch_index].b = 1.0f;
-            batch_group->blends[batch_group_batch_index].a = 1.0f;
+            return;
         }
+
+        batch_group->insts = insts;
+        batch_group->inst_cap = inst_cap;
     }
-}
 
-zfw_char_batch_key_t zfw_take_render_layer_char_batch(const int layer_index, zfw_char_batch_group_t *const batch_group, zfw_mem_arena_t *const main_mem_arena)
-{
-    for (int i = 0; i < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; i++)
+    batch_group->prepared = ZFW_TRUE;
+
+    // Write the instances of each layer, grouped into runs by font.
+    int inst_index = 0;
+    int run_index = 0;
+
+    for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
     {
-        const zfw_render_layer_char_batch_bits_t batch_bitmask = (zfw_render_layer_char_batch_bits_t)1 << i;
+        batch_group->layer_inst_run_begin_indexes[i] = run_index;
+        batch_group->layer_inst_run_counts[i] = 0;
 
-        if (!(batch_group->batch_activity_bits[layer_index] & batch_bitmask))
+        // Gather the batches with glyphs, ordered by font. The insertion sort keeps batches of the same font in their
+        // original order, so only text of different fonts can be drawn out of batch order.
+        int batch_group_batch_indexes[ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT];
+        int batch_count = 0;
+
+        zfw_render_layer_char_batch_bits_t batch_bits = batch_group->batch_activity_bits[i];
+
+        while (batch_bits)
         {
-            // Initialise the batch if not already done.
-            if (!(batch_group->batch_init_bits[layer_index] & batch_bitmask))
+            const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(i, zfw_get_index_of_lowest_active_bit_64(batch_bits));
+            batch_bits &= batch_bits - 1;
+
+            if (!batch_group->batch_glyph_counts[batch_group_batch_index])
             {
-                const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(layer_index, i);
+                continue;
+            }
 
-                glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
+            const int user_font_index = batch_group->user_font_indexes[batch_group_batch_index];
 
-                glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
+            int j = batch_count;
 
-                {
-                    float *verts;
-                    const int verts_size = sizeof(*verts) * ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT * 4 * ZFW_CHAR_BATCH_SLOT_LIMIT;
-                    verts = zfw_mem_arena_alloc(main_mem_arena, verts_size);
+            while (j > 0 && batch_group->user_font_indexes[batch_group_batch_indexes[j - 1]] > user_font_index)
+            {
+                batch_group_batch_indexes[j] = batch_group_batch_indexes[j - 1];
+                j--;
+            }
+
+            batch_group_batch_indexes[j] = batch_group_batch_index;
+            batch_count++;
+        }
 
-                    if (!verts)
-                    {
-                        zfw_log_error("Failed to allocate %d bytes for render layer character batch vertices!", verts_size);
-                        return 0;
-                    }
+        for (int j = 0; j < batch_count; j++)
+        {
+            const int batch_group_batch_index = batch_group_batch_indexes[j];
+            const int user_font_index = batch_group->user_font_indexes[batch_group_batch_index];
 
-                    memset(verts, 0, verts_size);
+            // Begin a new run if the font differs from that of the last batch.
+            if (j == 0 || user_font_index != batch_group->inst_runs[run_index - 1].user_font_index)
+            {
+                batch_group->inst_runs[run_index].user_font_index = user_font_index;
+                batch_group->inst_runs[run_index].inst_begin_index = inst_index;
+                batch_group->inst_runs[run_index].inst_count = 0;
 
-                    glBufferData(GL_ARRAY_BUFFER, verts_size, verts, GL_DYNAMIC_DRAW);
+                run_index++;
+                batch_group->layer_inst_run_counts[i]++;
+            }
 
-                    zfw_rewind_mem_arena(main_mem_arena);
-                }
+            // Apply the batch properties to its glyphs.
+            const zfw_vec_2d_t pos = batch_group->positions[batch_group_batch_index];
+            const zfw_vec_2d_t scale = batch_group->scales[batch_group_batch_index];
+            const zfw_color_t *const blend = &batch_group->blends[batch_group_batch_index];
 
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch_group->elem_buf_gl_ids[batch_group_batch_index]);
+            const unsigned char blend_bytes[4] = {
+                zfw_get_color_elem_as_byte(blend->r),
+                zfw_get_color_elem_as_byte(blend->g),
+                zfw_get_color_elem_as_byte(blend->b),
+                zfw_get_color_elem_as_byte(blend->a)
+            };
 
-                {
-                    unsigned short *indices;
-                    const int indices_size = sizeof(*indices) * 6 * ZFW_CHAR_BATCH_SLOT_LIMIT;
-                    indices = zfw_mem_arena_alloc(main_mem_arena, indices_size);
-
-                    if (!indices)
-                    {
-                        zfw_log_error("Failed to allocate %d bytes for render layer character batch elements!", indices_size);
-                        return 0;
-                    }
-
-                    for (int i = 0; i < ZFW_CHAR_BATCH_SLOT_LIMIT; i++)
-                    {
-                        indices[(i * 6) + 0] = (i * 4) + 0;
-                        indices[(i * 6) + 1] = (i * 4) + 1;
-                        indices[(i * 6) + 2] = (i * 4) + 2;
-                        indices[(i * 6) + 3] = (i * 4) + 2;
-                        indices[(i * 6) + 4] = (i * 4) + 3;
-                        indices[(i * 6) + 5] = (i * 4) + 0;
-                    }
-
-                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_size, indices, GL_STATIC_DRAW);
-
-                    zfw_rewind_mem_arena(main_mem_arena);
-                }
+            const zfw_char_batch_glyph_t *const glyphs = batch_group->batch_glyphs[batch_group_batch_index];
+            const int glyph_count = batch_group->batch_glyph_counts[batch_group_batch_index];
+
+            for (int k = 0; k < glyph_count; k++)
+            {
+                zfw_char_inst_t *const inst = &batch_group->insts[inst_index + k];
+                inst->pos.x = pos.x + (glyphs[k].pos.x * scale.x);
+                inst->pos.y = pos.y + (glyphs[k].pos.y * scale.y);
+                inst->size.x = glyphs[k].size.x * scale.x;
+                inst->size.y = glyphs[k].size.y * scale.y;
+                memcpy(inst->tex_coords, glyphs[k].tex_coords, sizeof(inst->tex_coords));
+                memcpy(inst->blend, blend_bytes, sizeof(inst->blend));
+            }
 
-                const int verts_stride = sizeof(float) * ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT;
+            inst_index += glyph_count;
+            batch_group->inst_runs[run_index - 1].inst_count += glyph_count;
+        }
+    }
 
-                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 0));
-                glEnableVertexAttribArray(0);
+    // Upload all the instances at once, orphaning the previous contents of the buffer.
+    glBindBuffer(GL_ARRAY_BUFFER, batch_group->inst_buf_gl_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(*batch_group->insts) * batch_group->inst_cap, NULL, GL_STREAM_DRAW);
 
-                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, verts_stride, (void *)(sizeof(float) * 2));
-                glEnableVertexAttribArray(1);
+    if (inst_index)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(*batch_group->insts) * inst_index, batch_group->insts);
 
-                glBindVertexArray(0);
+        profiler_counters->buf_upload_count++;
+        profiler_counters->buf_upload_size += sizeof(*batch_group->insts) * inst_index;
+    }
+}
 
-                batch_group->batch_init_bits[layer_index] |= batch_bitmask;
-            }
+zfw_char_batch_key_t zfw_take_render_layer_char_batch(const int layer_index, zfw_char_batch_group_t *const batch_group)
+{
+    const zfw_render_capture_take_char_batch_cmd_t capture_cmd = {layer_index};
+    begin_render_capture_cmd(batch_group->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_CHAR_BATCH, &capture_cmd, sizeof(capture_cmd), 0);
+
+    for (int i = 0; i < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; i++)
+    {
+        const zfw_render_layer_char_batch_bits_t batch_bitmask = (zfw_render_layer_char_batch_bits_t)1 << i;
+
+        if (!(batch_group->batch_activity_bits[layer_index] & batch_bitmask))
+        {
+            // Initialise the batch if not already done.
+            const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(layer_index, i);
 
-            // Take the batch and return a key.
+            // Take the batch and return a key. Its glyph store is allocated on its first write.
+            batch_group->batch_init_bits[layer_index] |= batch_bitmask;
             batch_group->batch_activity_bits[layer_index] |= batch_bitmask;
+            batch_group->batch_idle_frame_counts[batch_group_batch_index] = 0;
+            batch_group->batch_glyph_counts[batch_group_batch_index] = 0;
+            batch_group->batch_layout_hashes[batch_group_batch_index] = 0;
+            batch_group->prepared = ZFW_FALSE;
 
             return zfw_create_char_batch_key(layer_index, i);
         }
@@ -792,6 +2276,13 @@ zfw_char_batch_key_t zfw_take_render_layer_char_batch(const int layer_index, zfw
 
 zfw_bool_t zfw_write_to_render_layer_char_batch(const zfw_char_batch_key_t key, const char *const text, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align, zfw_char_batch_group_t *const batch_group, const zfw_user_font_data_t *const user_font_data)
 {
+    const zfw_render_capture_write_char_batch_cmd_t capture_cmd = {key, hor_align, vert_align};
+
+    if (begin_render_capture_cmd(batch_group->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_CHAR_BATCH, &capture_cmd, sizeof(capture_cmd), strlen(text) + 1))
+    {
+        write_render_capture_data(batch_group->capture, text, strlen(text) + 1);
+    }
+
     if (!zfw_is_char_batch_slot_key_active(key))
     {
         zfw_log_warning("Attempting to write to a render layer character batch using an inactive key!");
@@ -802,7 +2293,7 @@ zfw_bool_t zfw_write_to_render_layer_char_batch(const zfw_char_batch_key_t key,
 
     const int batch_user_font_index = batch_group->user_font_indexes[batch_group_batch_index];
 
-    const int text_len = strnlen(text, ZFW_CHAR_BATCH_SLOT_LIMIT);
+    const int text_len = strlen(text);
 
     if (text_len == 0)
     {
@@ -810,155 +2301,53 @@ zfw_bool_t zfw_write_to_render_layer_char_batch(const zfw_char_batch_key_t key,
         return ZFW_FALSE;
     }
 
-    if (text_len == ZFW_CHAR_BATCH_SLOT_LIMIT && text[text_len])
+    // If the batch already holds the layout of this text, there is nothing to redo or upload. This includes layouts with
+    // no glyphs, such as text made up only of characters that the font doesn't have.
+    const zfw_char_batch_layout_hash_t layout_hash = calc_char_batch_layout_hash(text, text_len, batch_user_font_index, hor_align, vert_align);
+
+    if (batch_group->batch_layout_hashes[batch_group_batch_index] == layout_hash)
     {
-        zfw_log_warning("Attempting to write to a render layer character batch using text of a length exceeding the limit of %d!", ZFW_CHAR_BATCH_SLOT_LIMIT);
-        return ZFW_FALSE;
+        return ZFW_TRUE;
     }
 
-    // Determine the positions of text characters based on font information, alongside the overall dimensions of the text to be used when applying alignment.
-    zfw_vec_2d_t char_draw_positions[ZFW_CHAR_BATCH_SLOT_LIMIT];
-    zfw_vec_2d_t char_draw_pos_pen = {0};
-
-    int text_line_ws[ZFW_CHAR_BATCH_SLOT_LIMIT] = {0};
-    int text_first_line_min_offs;
-    int text_first_line_min_offs_updated = ZFW_FALSE;
-    int text_last_line_max_h;
-    int text_last_line_max_h_updated = ZFW_FALSE;
-    int text_line_counter = 0;
-
-    for (int i = 0; i < text_len; i++)
+    // Grow the glyph store of the batch if the text could have more glyphs than it can hold.
+    if (text_len > batch_group->batch_glyph_caps[batch_group_batch_index])
     {
-        if (text[i] == '\n')
-        {
-            text_line_ws[text_line_counter] = char_draw_pos_pen.x;
-
-            if (!text_first_line_min_offs_updated)
-            {
-                // Set the first line minimum offset to the vertical offset of the space character.
-                text_first_line_min_offs = user_font_data->chars_vert_offsets[batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE];
-                text_first_line_min_offs_updated = ZFW_TRUE;
-            }
-
-            // Set the last line maximum h to the h of a space.
-            text_last_line_max_h = user_font_data->chars_vert_offsets[batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE] + user_font_data->chars_src_rects[batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE].height;
-
-            text_last_line_max_h_updated = ZFW_FALSE;
-
-            text_line_counter++;
-
-            // Move the pen to a new line.
-            char_draw_pos_pen.x = 0.0f;
-            char_draw_pos_pen.y += user_font_data->line_heights[batch_user_font_index];
-
-            continue;
-        }
-
-        const int text_char_index = text[i] - ZFW_FONT_CHAR_RANGE_BEGIN;
-        const int user_font_chars_index = (batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE) + text_char_index;
+        int glyph_cap = ZFW_MAX(batch_group->batch_glyph_caps[batch_group_batch_index] * 2, CHAR_BATCH_GLYPH_CAP_MIN);
 
-        // If we are on the first line, update the first line minimum offset.
-        if (text_line_counter == 0)
+        while (glyph_cap < text_len)
         {
-            if (!text_first_line_min_offs_updated)
-            {
-                text_first_line_min_offs = user_font_data->chars_vert_offsets[user_font_chars_index];
-                text_first_line_min_offs_updated = ZFW_TRUE;
-            }
-            else
-            {
-                text_first_line_min_offs = ZFW_MIN(user_font_data->chars_vert_offsets[user_font_chars_index], text_first_line_min_offs);
-            }
+            glyph_cap *= 2;
         }
 
-        if (!text_last_line_max_h_updated)
-        {
-            text_last_line_max_h = user_font_data->chars_vert_offsets[user_font_chars_index] + user_font_data->chars_src_rects[user_font_chars_index].height;
-            text_last_line_max_h_updated = ZFW_TRUE;
-        }
-        else
-        {
-            text_last_line_max_h = ZFW_MAX(user_font_data->chars_vert_offsets[user_font_chars_index] + user_font_data->chars_src_rects[user_font_chars_index].height, text_last_line_max_h);
-        }
+        zfw_char_batch_glyph_t *const glyphs = realloc(batch_group->batch_glyphs[batch_group_batch_index], sizeof(*glyphs) * glyph_cap);
 
-        if (i > 0)
+        if (!glyphs)
         {
-            // Apply kerning based on the previous character.
-            const int text_char_index_last = text[i - 1] - ZFW_FONT_CHAR_RANGE_BEGIN;
-            char_draw_pos_pen.x += user_font_data->chars_kernings[(batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE * ZFW_FONT_CHAR_RANGE_SIZE) + (text_char_index * ZFW_FONT_CHAR_RANGE_SIZE) + text_char_index_last];
+            zfw_log_error("Failed to allocate %d bytes for render layer character batch glyphs!", sizeof(*glyphs) * glyph_cap);
+            return ZFW_FALSE;
         }
 
-        char_draw_positions[i].x = char_draw_pos_pen.x + user_font_data->chars_hor_offsets[user_font_chars_index];
-        char_draw_positions[i].y = char_draw_pos_pen.y + user_font_data->chars_vert_offsets[user_font_chars_index];
-
-        char_draw_pos_pen.x += user_font_data->chars_hor_advances[user_font_chars_index];
-    }
-
-    text_line_ws[text_line_counter] = char_draw_pos_pen.x;
-    text_line_counter = 0;
-
-    const int text_h = text_first_line_min_offs + char_draw_pos_pen.y + text_last_line_max_h;
-
-    // Clear the batch then write the character render data.
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
-
-    {
-        const float batch_clear_verts[(ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT * 4) * ZFW_CHAR_BATCH_SLOT_LIMIT] = {0};
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(batch_clear_verts), batch_clear_verts);
+        batch_group->batch_glyphs[batch_group_batch_index] = glyphs;
+        batch_group->batch_glyph_caps[batch_group_batch_index] = glyph_cap;
     }
 
-    for (int i = 0; i < text_len; i++)
-    {
-        if (text[i] == '\n')
-        {
-            text_line_counter++;
-            continue;
-        }
-
-        if (text[i] != ' ')
-        {
-            const int font_chars_index = (batch_user_font_index * ZFW_FONT_CHAR_RANGE_SIZE) + (text[i] - ZFW_FONT_CHAR_RANGE_BEGIN);
-
-            const zfw_vec_2d_t char_draw_pos = zfw_create_vec_2d(char_draw_positions[i].x - (text_line_ws[text_line_counter] * (hor_align / 2.0f)), char_draw_positions[i].y - (text_h * (vert_align / 2.0f)));
-
-            zfw_rect_f_t char_tex_coords_rect;
-            char_tex_coords_rect.x = (float)user_font_data->chars_src_rects[font_chars_index].x / user_font_data->tex_sizes[batch_user_font_index].x;
-            char_tex_coords_rect.y = (float)user_font_data->chars_src_rects[font_chars_index].y / user_font_data->tex_sizes[batch_user_font_index].y;
-            char_tex_coords_rect.width = (float)user_font_data->chars_src_rects[font_chars_index].width / user_font_data->tex_sizes[batch_user_font_index].x;
-            char_tex_coords_rect.height = (float)user_font_data->chars_src_rects[font_chars_index].height / user_font_data->tex_sizes[batch_user_font_index].y;
-
-            const float verts[ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT * 4] = {
-                char_draw_pos.x,
-                char_draw_pos.y,
-                char_tex_coords_rect.x,
-                char_tex_coords_rect.y,
-
-                char_draw_pos.x + user_font_data->chars_src_rects[font_chars_index].width,
-                char_draw_pos.y,
-                char_tex_coords_rect.x + char_tex_coords_rect.width,
-                char_tex_coords_rect.y,
-
-                char_draw_pos.x + user_font_data->chars_src_rects[font_chars_index].width,
-                char_draw_pos.y + user_font_data->chars_src_rects[font_chars_index].height,
-                char_tex_coords_rect.x + char_tex_coords_rect.width,
-                char_tex_coords_rect.y + char_tex_coords_rect.height,
-
-                char_draw_pos.x,
-                char_draw_pos.y + user_font_data->chars_src_rects[font_chars_index].height,
-                char_tex_coords_rect.x,
-                char_tex_coords_rect.y + char_tex_coords_rect.height
-            };
+    zfw_char_batch_glyph_t *const glyphs = batch_group->batch_glyphs[batch_group_batch_index];
+    int glyph_count;
+    lay_out_text(text, text_len, batch_user_font_index, hor_align, vert_align, user_font_data, glyphs, &glyph_count);
 
-            glBufferSubData(GL_ARRAY_BUFFER, i * sizeof(verts), sizeof(verts), verts);
-        }
-    }
+    batch_group->batch_glyph_counts[batch_group_batch_index] = glyph_count;
+    batch_group->batch_layout_hashes[batch_group_batch_index] = layout_hash;
+    batch_group->prepared = ZFW_FALSE;
 
     return ZFW_TRUE;
 }
 
 zfw_bool_t zfw_clear_render_layer_char_batch(const zfw_char_batch_key_t key, zfw_char_batch_group_t *const batch_group)
 {
+    const zfw_render_capture_char_batch_cmd_t capture_cmd = {key};
+    begin_render_capture_cmd(batch_group->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_CHAR_BATCH, &capture_cmd, sizeof(capture_cmd), 0);
+
     if (!zfw_is_char_batch_slot_key_active(key))
     {
         zfw_log_warning("Attempting to clear a render layer character batch using an inactive key!");
@@ -967,17 +2356,18 @@ zfw_bool_t zfw_clear_render_layer_char_batch(const zfw_char_batch_key_t key, zfw
 
     const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(zfw_get_char_batch_slot_key_layer_index(key), zfw_get_char_batch_slot_key_batch_index(key));
 
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
-
-    const float verts[(ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT * 4) * ZFW_CHAR_BATCH_SLOT_LIMIT] = {0};
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+    batch_group->batch_glyph_counts[batch_group_batch_index] = 0;
+    batch_group->batch_layout_hashes[batch_group_batch_index] = 0;
+    batch_group->prepared = ZFW_FALSE;
 
     return ZFW_TRUE;
 }
 
 zfw_bool_t zfw_free_render_layer_char_batch(const zfw_char_batch_key_t key, zfw_char_batch_group_t *const batch_group)
 {
+    const zfw_render_capture_char_batch_cmd_t capture_cmd = {key};
+    begin_render_capture_cmd(batch_group->capture, ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_CHAR_BATCH, &capture_cmd, sizeof(capture_cmd), 0);
+
     if (!zfw_is_char_batch_slot_key_active(key))
     {
         zfw_log_warning("Attempting to free a render layer character batch using an inactive key!");
@@ -988,34 +2378,76 @@ zfw_bool_t zfw_free_render_layer_char_batch(const zfw_char_batch_key_t key, zfw_
     const int batch_index = zfw_get_char_batch_slot_key_batch_index(key);
     const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(layer_index, batch_index);
 
-    glBindVertexArray(batch_group->vert_array_gl_ids[batch_group_batch_index]);
-    glBindBuffer(GL_ARRAY_BUFFER, batch_group->vert_buf_gl_ids[batch_group_batch_index]);
-
-    const float verts[(ZFW_BUILTIN_CHAR_QUAD_SHADER_PROG_VERT_COUNT * 4) * ZFW_CHAR_BATCH_SLOT_LIMIT] = {0};
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
-
+    batch_group->batch_glyph_counts[batch_group_batch_index] = 0;
+    batch_group->batch_layout_hashes[batch_group_batch_index] = 0;
     batch_group->batch_activity_bits[layer_index] &= ~((zfw_render_layer_char_batch_bits_t)1 << batch_index);
+    batch_group->prepared = ZFW_FALSE;
 
     return ZFW_TRUE;
 }
 
-zfw_char_batch_key_t zfw_create_char_batch_key(const int layer_index, const int batch_index)
+zfw_rect_f_t zfw_measure_text(const char *const text, const int user_font_index, const zfw_font_hor_align_t hor_align, const zfw_font_vert_align_t vert_align, const zfw_user_font_data_t *const user_font_data)
 {
-    zfw_char_batch_key_t key = 1; // Initialise the key as active.
-    key |= (zfw_char_batch_key_t)layer_index << 1;
-    key |= (zfw_char_batch_key_t)batch_index << (1 + (int)log2(ZFW_RENDER_LAYER_LIMIT));
-    return key;
+    return lay_out_text(text, strlen(text), user_font_index, hor_align, vert_align, user_font_data, NULL, NULL);
 }
 
-void zfw_render_sprite_and_character_batches(const zfw_sprite_batch_group_t sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_char_batch_group_t *const char_batch_group, const zfw_view_state_t *const view_state, const zfw_vec_2d_i_t window_size, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data)
+void zfw_render_sprite_and_character_batches(const zfw_sprite_batch_group_t sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT], const zfw_char_batch_group_t *const char_batch_group, const zfw_sprite_queue_t *const sprite_queue, const zfw_view_state_t *const view_state, const zfw_vec_2d_i_t window_size, const zfw_user_tex_data_t *const user_tex_data, const zfw_user_shader_prog_data_t *const user_shader_prog_data, const zfw_user_font_data_t *const user_font_data, const zfw_builtin_shader_prog_data_t *const builtin_shader_prog_data, const zfw_render_context_t *const render_context, zfw_profiler_t *const profiler)
 {
+    zfw_render_capture_t *const capture = char_batch_group->capture;
+
+    if (capture && capture->fs)
+    {
+        zfw_render_capture_render_cmd_t capture_cmd = {window_size, *view_state, 0};
+
+        for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+        {
+            capture_cmd.char_batch_count += zfw_get_active_bit_count_64(char_batch_group->batch_activity_bits[i]);
+        }
+
+        begin_render_capture_cmd(capture, ZFW_RENDER_CAPTURE_CMD_TYPE__RENDER, &capture_cmd, sizeof(capture_cmd), sizeof(zfw_render_capture_char_batch_props_t) * capture_cmd.char_batch_count);
+
+        for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
+        {
+            for (int j = 0; j < ZFW_RENDER_LAYER_CHAR_BATCH_LIMIT; j++)
+            {
+                if (!(char_batch_group->batch_activity_bits[i] & ((zfw_render_layer_char_batch_bits_t)1 << j)))
+                {
+                    continue;
+                }
+
+                const int batch_group_batch_index = zfw_get_char_batch_group_batch_index(i, j);
+
+                const zfw_render_capture_char_batch_props_t props = {
+                    zfw_create_char_batch_key(i, j),
+                    char_batch_group->user_font_indexes[batch_group_batch_index],
+                    char_batch_group->positions[batch_group_batch_index],
+                    char_batch_group->scales[batch_group_batch_index],
+                    char_batch_group->blends[batch_group_batch_index]
+                };
+
+                write_render_capture_data(capture, &props, sizeof(props));
+            }
+        }
+
+        capture->frame_count++;
+
+        if (--capture->frames_left == 0)
+        {
+            zfw_end_render_capture(capture);
+        }
+    }
+
     zfw_matrix_4x4_t proj;
     zfw_init_ortho_matrix_4x4(&proj, 0.0f, window_size.x, window_size.y, 0.0f, -1.0f, 1.0f);
 
+    // Queued sprites are sorted by batch group then layer, so they're drawn by advancing through them alongside the layers.
+    int sprite_queue_cmd_index = 0;
+
     // Draw view sprite batches.
     {
         glUseProgram(builtin_shader_prog_data->sprite_quad_prog_gl_id);
 
+        // Combine the view and projection matrices here, so that the shader only needs a single multiplication per vertex.
         zfw_matrix_4x4_t view;
         zfw_init_identity_matrix_4x4(&view);
         view.elems[0][0] = view_state->scale;
@@ -1023,35 +2455,140 @@ void zfw_render_sprite_and_character_batches(const zfw_sprite_batch_group_t spri
         view.elems[2][2] = 1.0f;
         view.elems[3][0] = -view_state->pos.x * view_state->scale;
         view.elems[3][1] = -view_state->pos.y * view_state->scale;
-        glUniformMatrix4fv(glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_view"), 1, GL_FALSE, (float *)view.elems);
 
-        glUniformMatrix4fv(glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_proj"), 1, GL_FALSE, (float *)proj.elems);
+        zfw_matrix_4x4_t view_proj;
+        zfw_init_matrix_4x4_product(&view_proj, &proj, &view);
+        glUniformMatrix4fv(render_context->builtin_uniform_locs.sprite_quad_view_proj, 1, GL_FALSE, (float *)view_proj.elems);
 
         for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
         {
-            draw_sprite_batches_of_layer(&sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_ID__VIEW], i, user_tex_data, builtin_shader_prog_data);
+            zfw_begin_profiler_gpu_timer(profiler, zfw_get_render_layer_gpu_timer_index(ZFW_SPRITE_BATCH_GROUP_ID__VIEW, i));
+
+            draw_sprite_batches_of_layer(&sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_ID__VIEW], i, user_tex_data, render_context, &profiler->frame.counters);
+            draw_sprite_queue_cmds_of_layer(sprite_queue, ZFW_SPRITE_BATCH_GROUP_ID__VIEW, i, &sprite_queue_cmd_index, &view_proj, user_tex_data, user_shader_prog_data, builtin_shader_prog_data, render_context, &profiler->frame.counters);
+
+            zfw_end_profiler_gpu_timer(profiler);
         }
     }
 
-    // Draw screen sprite batches and character batches.
+    // Draw screen sprite batches and character batches. Screen sprites have no view transform, so only the projection is used.
     for (int i = 0; i < ZFW_RENDER_LAYER_LIMIT; i++)
     {
+        zfw_begin_profiler_gpu_timer(profiler, zfw_get_render_layer_gpu_timer_index(ZFW_SPRITE_BATCH_GROUP_ID__SCREEN, i));
+
         // Draw layer screen sprite batches.
         glUseProgram(builtin_shader_prog_data->sprite_quad_prog_gl_id);
 
-        zfw_matrix_4x4_t view;
-        zfw_init_identity_matrix_4x4(&view);
-        glUniformMatrix4fv(glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_view"), 1, GL_FALSE, (float *)view.elems);
-
-        glUniformMatrix4fv(glGetUniformLocation(builtin_shader_prog_data->sprite_quad_prog_gl_id, "u_proj"), 1, GL_FALSE, (float *)proj.elems);
+        glUniformMatrix4fv(render_context->builtin_uniform_locs.sprite_quad_view_proj, 1, GL_FALSE, (float *)proj.elems);
 
-        draw_sprite_batches_of_layer(&sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_ID__SCREEN], i, user_tex_data, builtin_shader_prog_data);
+        draw_sprite_batches_of_layer(&sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_ID__SCREEN], i, user_tex_data, render_context, &profiler->frame.counters);
+        draw_sprite_queue_cmds_of_layer(sprite_queue, ZFW_SPRITE_BATCH_GROUP_ID__SCREEN, i, &sprite_queue_cmd_index, &proj, user_tex_data, user_shader_prog_data, builtin_shader_prog_data, render_context, &profiler->frame.counters);
 
         // Draw layer character batches.
-        glUseProgram(builtin_shader_prog_data->char_quad_prog_gl_id);
-        glUniformMatrix4fv(glGetUniformLocation(builtin_shader_prog_data->char_quad_prog_gl_id, "u_proj"), 1, GL_FALSE, (float *)proj.elems);
-        draw_char_batches_of_layer(char_batch_group, i, user_font_data, builtin_shader_prog_data);
+        draw_char_batches_of_layer(char_batch_group, i, &proj, user_font_data, builtin_shader_prog_data, render_context, &profiler->frame.counters);
+
+        zfw_end_profiler_gpu_timer(profiler);
+    }
+}
+
+zfw_bool_t zfw_begin_render_capture(zfw_render_capture_t *const capture, const char *const file_name, const int frame_count, const zfw_bool_t tex_array)
+{
+    memset(capture, 0, sizeof(*capture));
+
+    capture->fs = fopen(file_name, "wb");
+
+    if (!capture->fs)
+    {
+        zfw_log_error("Failed to open render capture file \"%s\"!", file_name);
+        return ZFW_FALSE;
+    }
+
+    capture->frames_left = frame_count;
+
+    // The frame count is written over once the capture ends.
+    const zfw_render_capture_file_header_t header = {ZFW_RENDER_CAPTURE_FILE_MAGIC, ZFW_RENDER_CAPTURE_FILE_VERSION, tex_array, 0};
+    fwrite(&header, sizeof(header), 1, capture->fs);
+
+    return ZFW_TRUE;
+}
+
+void zfw_end_render_capture(zfw_render_capture_t *const capture)
+{
+    if (!capture->fs)
+    {
+        return;
+    }
+
+    fseek(capture->fs, offsetof(zfw_render_capture_file_header_t, frame_count), SEEK_SET);
+    fwrite(&capture->frame_count, sizeof(capture->frame_count), 1, capture->fs);
+
+    if (ferror(capture->fs))
+    {
+        zfw_log_error("Failed to write to the render capture file!");
     }
+    else
+    {
+        zfw_log("Captured %d frames of the render stream.", capture->frame_count);
+    }
+
+    fclose(capture->fs);
+    capture->fs = NULL;
+}
+
+zfw_bool_t zfw_init_offscreen_target(zfw_offscreen_target_t *const target, const zfw_vec_2d_i_t size)
+{
+    memset(target, 0, sizeof(*target));
+
+    target->size = size;
+
+    glGenRenderbuffers(1, &target->color_rb_gl_id);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->color_rb_gl_id);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+
+    glGenFramebuffers(1, &target->fb_gl_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fb_gl_id);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->color_rb_gl_id);
+
+    const GLenum fb_status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (fb_status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        zfw_log_error("Failed to create a %dx%d offscreen target! (Framebuffer status: 0x%X)", size.x, size.y, fb_status);
+        return ZFW_FALSE;
+    }
+
+    return ZFW_TRUE;
+}
+
+void zfw_clean_offscreen_target(zfw_offscreen_target_t *const target)
+{
+    if (target->fb_gl_id)
+    {
+        glDeleteFramebuffers(1, &target->fb_gl_id);
+    }
+
+    if (target->color_rb_gl_id)
+    {
+        glDeleteRenderbuffers(1, &target->color_rb_gl_id);
+    }
+
+    memset(target, 0, sizeof(*target));
+}
+
+void zfw_bind_offscreen_target(const zfw_offscreen_target_t *const target)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fb_gl_id);
+    glViewport(0, 0, target->size.x, target->size.y);
+}
+
+void zfw_read_offscreen_target_pixels(const zfw_offscreen_target_t *const target, unsigned char *const pixels)
+{
+    // The pixel buffer must hold 4 bytes (RGBA) for every pixel of the target. Rows are bottom to top, as OpenGL has them.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target->fb_gl_id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, target->size.x, target->size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
 
 void zfw_set_view_state_defaults(zfw_view_state_t *const view_state)
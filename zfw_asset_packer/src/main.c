@@ -19,14 +19,100 @@
 
 #define FONT_PT_SIZE_MIN 11
 #define FONT_PT_SIZE_MAX 144
+#define FONT_CODEPOINT_RANGE_DEFAULT_BEGIN 32
+#define FONT_CODEPOINT_RANGE_DEFAULT_END 126
+#define FONT_TEX_WIDTH_MIN 64
+#define FONT_TEX_SIZE_MAX 16384
+#define FONT_KERNING_PAIR_CAP_INIT 256
+#define FONT_KERNING_CHAR_COUNT_MAX 1024
 
-static void clean_up(const zfw_bool_t packing_successful, char *const packing_instrs_file_chars, FILE *const assets_file_fs, cJSON *const c_json, const char *const assets_file_rel_path)
+#define ASSETS_FILE_ENTRY_CAP_INIT 64
+
+#define ATLAS_PAGE_LIMIT 64
+#define ATLAS_PAGE_SIZE_DEFAULT 2048
+
+typedef struct
+{
+    FILE *fs;
+
+    // Entries are recorded as they're written, then written out as the table of contents once packing is finished.
+    zfw_assets_file_entry_t *entries;
+    int entry_count;
+    int entry_cap;
+} assets_file_writer_t;
+
+typedef struct
+{
+    int x;
+    int y; // The height of the packed area below this stretch of the skyline.
+    int width;
+} atlas_skyline_node_t;
+
+typedef struct
+{
+    int size; // The maximum width and height of the page.
+    zfw_vec_2d_i_t used_size; // The extent of the page actually covered by textures, which is all that gets written.
+
+    zfw_tex_format_t tex_format;
+
+    unsigned char *px_data;
+
+    atlas_skyline_node_t *skyline_nodes;
+    int skyline_node_count;
+} atlas_page_t;
+
+typedef struct
+{
+    int index; // The index of the texture within the atlas.
+    zfw_vec_2d_i_t size;
+    stbi_uc *px_data;
+} atlas_src_tex_t;
+
+typedef struct
+{
+    atlas_page_t pages[ATLAS_PAGE_LIMIT];
+    int page_count;
+
+    int tex_count;
+    int *tex_page_indexes;
+    zfw_rect_t *tex_src_rects;
+} atlas_packing_t;
+
+// The metrics of all fonts, gathered as each font is packed and then written as a single entry.
+typedef struct
+{
+    int *line_heights;
+    int *chars_begin_indexes;
+    int *char_counts;
+    int *kerning_pairs_begin_indexes;
+    int *kerning_pair_counts;
+    zfw_vec_2d_i_t *tex_sizes;
+    zfw_bool_t *sdfs;
+    unsigned int *name_hashes;
+
+    // The characters of all fonts, which grow as each font is packed.
+    unsigned int *chars_codepoints;
+    font_char_hor_offs_t *chars_hor_offsets;
+    font_char_vert_offs_t *chars_vert_offsets;
+    font_char_hor_advance_t *chars_hor_advances;
+    font_char_src_rect_t *chars_src_rects;
+    int char_count;
+    int char_cap;
+
+    font_char_kerning_pair_t *kerning_pairs;
+    int kerning_pair_count;
+    int kerning_pair_cap;
+} font_packing_t;
+
+static void clean_up(const zfw_bool_t packing_successful, char *const packing_instrs_file_chars, assets_file_writer_t *const assets_file_writer, cJSON *const c_json, const char *const assets_file_rel_path)
 {
     cJSON_Delete(c_json);
 
-    if (assets_file_fs)
+    free(assets_file_writer->entries);
+
+    if (assets_file_writer->fs)
     {
-        fclose(assets_file_fs);
+        fclose(assets_file_writer->fs);
 
         // Try to delete the assets file if packing failed.
         if (!packing_successful)
@@ -79,16 +165,84 @@ static char *get_packing_instrs_file_chars(char src_asset_file_path_buf[SRC_ASSE
     return packing_instrs_file_chars;
 }
 
-static cJSON *get_cj_assets_array_and_write_asset_count_to_assets_file(cJSON *const c_json, const char *const packing_instrs_array_name, FILE *const assets_file_fs)
+// Pads the assets file with zeros up to the next entry alignment boundary, returning the resulting offset.
+static int pad_assets_file(assets_file_writer_t *const writer)
 {
-    cJSON *const cj_assets = cJSON_GetObjectItemCaseSensitive(c_json, packing_instrs_array_name);
+    static const unsigned char k_padding[ZFW_ASSETS_FILE_ENTRY_ALIGNMENT] = {0};
+
+    const int offs = ftell(writer->fs);
+    const int padding_size = (ZFW_ASSETS_FILE_ENTRY_ALIGNMENT - (offs % ZFW_ASSETS_FILE_ENTRY_ALIGNMENT)) % ZFW_ASSETS_FILE_ENTRY_ALIGNMENT;
+
+    fwrite(k_padding, 1, padding_size, writer->fs);
+
+    return offs + padding_size;
+}
+
+// Starts a new table of contents entry at the next aligned offset. All data written until the entry is ended belongs to it.
+static zfw_bool_t begin_assets_file_entry(assets_file_writer_t *const writer, const zfw_asset_type_t type, const unsigned int name_hash)
+{
+    if (writer->entry_count == writer->entry_cap)
+    {
+        const int entry_cap_new = writer->entry_cap ? writer->entry_cap * 2 : ASSETS_FILE_ENTRY_CAP_INIT;
+        zfw_assets_file_entry_t *const entries_new = realloc(writer->entries, sizeof(*entries_new) * entry_cap_new);
+
+        if (!entries_new)
+        {
+            zfw_log_error("Failed to allocate %d bytes for assets file entries!", sizeof(*entries_new) * entry_cap_new);
+            return ZFW_FALSE;
+        }
+
+        writer->entries = entries_new;
+        writer->entry_cap = entry_cap_new;
+    }
+
+    zfw_assets_file_entry_t *const entry = &writer->entries[writer->entry_count];
+    entry->type = type;
+    entry->name_hash = name_hash;
+    entry->offs = pad_assets_file(writer);
+    entry->size = 0;
+    entry->checksum = ZFW_FNV_1A_HASH_INIT;
+
+    writer->entry_count++;
+
+    return ZFW_TRUE;
+}
+
+// Writes data belonging to the current entry, updating its checksum.
+static void write_assets_file_entry_data(assets_file_writer_t *const writer, const void *const data, const int elem_size, const int elem_count)
+{
+    zfw_assets_file_entry_t *const entry = &writer->entries[writer->entry_count - 1];
+
+    fwrite(data, elem_size, elem_count, writer->fs);
+    entry->checksum = zfw_update_fnv_1a_hash(entry->checksum, data, elem_size * elem_count);
+}
 
-    const zfw_bool_t cj_array_found = cJSON_IsArray(cj_assets);
+static void end_assets_file_entry(assets_file_writer_t *const writer)
+{
+    zfw_assets_file_entry_t *const entry = &writer->entries[writer->entry_count - 1];
+    entry->size = ftell(writer->fs) - entry->offs;
+}
+
+// Writes the table of contents after all entries, then goes back and fills in the header that was reserved at the start.
+static void finish_assets_file(assets_file_writer_t *const writer)
+{
+    zfw_assets_file_header_t header;
+    header.magic = ZFW_ASSETS_FILE_MAGIC;
+    header.version = ZFW_ASSETS_FILE_VERSION;
+    header.entry_count = writer->entry_count;
+    header.toc_offs = pad_assets_file(writer);
+
+    fwrite(writer->entries, sizeof(*writer->entries), writer->entry_count, writer->fs);
 
-    const int asset_count = cj_array_found ? cJSON_GetArraySize(cj_assets) : 0;
-    fwrite(&asset_count, sizeof(asset_count), 1, assets_file_fs);
+    fseek(writer->fs, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, writer->fs);
+}
 
-    if (!cj_array_found)
+static cJSON *get_cj_assets_array(cJSON *const c_json, const char *const packing_instrs_array_name)
+{
+    cJSON *const cj_assets = cJSON_GetObjectItemCaseSensitive(c_json, packing_instrs_array_name);
+
+    if (!cJSON_IsArray(cj_assets))
     {
         zfw_log_warning("Did not find array with name \"%s\" in \"%s\".", packing_instrs_array_name, PACKING_INSTRS_FILE_NAME);
         return NULL;
@@ -97,21 +251,315 @@ static cJSON *get_cj_assets_array_and_write_asset_count_to_assets_file(cJSON *co
     return cj_assets;
 }
 
-static zfw_bool_t pack_textures(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, FILE *const assets_file_fs)
+// Reads an optional texture format name, defaulting to uncompressed RGBA.
+static zfw_bool_t get_tex_format(const cJSON *const cj_format, zfw_tex_format_t *const tex_format)
 {
-    const cJSON *const cj_textures = get_cj_assets_array_and_write_asset_count_to_assets_file(c_json, "textures", assets_file_fs);
+    *tex_format = ZFW_TEX_FORMAT__RGBA8;
 
-    if (!cj_textures)
+    if (!cj_format)
     {
         return ZFW_TRUE;
     }
 
+    if (cJSON_IsString(cj_format) && strcmp(cj_format->valuestring, "rgba8") == 0)
+    {
+        return ZFW_TRUE;
+    }
+
+    if (cJSON_IsString(cj_format) && strcmp(cj_format->valuestring, "bc7") == 0)
+    {
+        *tex_format = ZFW_TEX_FORMAT__BC7;
+        return ZFW_TRUE;
+    }
+
+    zfw_log_error("Invalid texture format in \"%s\"! Expected \"rgba8\" or \"bc7\".", PACKING_INSTRS_FILE_NAME);
+    return ZFW_FALSE;
+}
+
+// Writes the size, format and data of a texture as its own entry, encoding its RGBA pixel data into the format. The row
+// length is the number of pixels between the starts of consecutive rows, allowing a texture to be written from part of a
+// larger image.
+static zfw_bool_t write_tex(const unsigned char *const px_data, const zfw_vec_2d_i_t tex_size, const int px_data_row_len, const zfw_tex_format_t tex_format, const unsigned int name_hash, assets_file_writer_t *const assets_file_writer)
+{
+    if (!begin_assets_file_entry(assets_file_writer, ZFW_ASSET_TYPE__TEX, name_hash))
+    {
+        return ZFW_FALSE;
+    }
+
+    write_assets_file_entry_data(assets_file_writer, &tex_size, sizeof(tex_size), 1);
+
+    const int tex_format_int = tex_format;
+    write_assets_file_entry_data(assets_file_writer, &tex_format_int, sizeof(tex_format_int), 1);
+
+    if (tex_format == ZFW_TEX_FORMAT__BC7)
+    {
+        const int blocks_size = zfw_get_tex_data_size(tex_size, tex_format);
+        unsigned char *const blocks = malloc(blocks_size);
+
+        if (!blocks)
+        {
+            zfw_log_error("Failed to allocate %d bytes for compressed texture data!", blocks_size);
+            return ZFW_FALSE;
+        }
+
+        zfw_encode_bc7(blocks, px_data, tex_size, px_data_row_len);
+        write_assets_file_entry_data(assets_file_writer, blocks, 1, blocks_size);
+
+        free(blocks);
+    }
+    else
+    {
+        for (int y = 0; y < tex_size.y; y++)
+        {
+            write_assets_file_entry_data(assets_file_writer, px_data + (y * px_data_row_len * ZFW_TEX_CHANNEL_COUNT), 1, tex_size.x * ZFW_TEX_CHANNEL_COUNT);
+        }
+    }
+
+    end_assets_file_entry(assets_file_writer);
+
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t init_atlas_page(atlas_page_t *const page, const int size, const zfw_tex_format_t tex_format)
+{
+    memset(page, 0, sizeof(*page));
+
+    page->size = size;
+    page->tex_format = tex_format;
+
+    // Pixels not covered by a texture are left fully transparent.
+    page->px_data = calloc(size * size, ZFW_TEX_CHANNEL_COUNT);
+
+    if (!page->px_data)
+    {
+        zfw_log_error("Failed to allocate %d bytes for atlas page pixel data!", size * size * ZFW_TEX_CHANNEL_COUNT);
+        return ZFW_FALSE;
+    }
+
+    // The skyline can never have more nodes than the page has columns.
+    page->skyline_nodes = malloc(sizeof(*page->skyline_nodes) * size);
+
+    if (!page->skyline_nodes)
+    {
+        zfw_log_error("Failed to allocate %d bytes for atlas page skyline nodes!", sizeof(*page->skyline_nodes) * size);
+        return ZFW_FALSE;
+    }
+
+    page->skyline_nodes[0].x = 0;
+    page->skyline_nodes[0].y = 0;
+    page->skyline_nodes[0].width = size;
+    page->skyline_node_count = 1;
+
+    return ZFW_TRUE;
+}
+
+static void clean_atlas_page(atlas_page_t *const page)
+{
+    free(page->skyline_nodes);
+    free(page->px_data);
+    memset(page, 0, sizeof(*page));
+}
+
+static void clean_atlas_packing(atlas_packing_t *const packing)
+{
+    for (int i = 0; i < packing->page_count; i++)
+    {
+        clean_atlas_page(&packing->pages[i]);
+    }
+
+    free(packing->tex_src_rects);
+    free(packing->tex_page_indexes);
+
+    memset(packing, 0, sizeof(*packing));
+}
+
+// Returns the lowest y at which a rectangle of the given size can rest on the skyline with its left edge at the node,
+// or -1 if it would not fit in the page there.
+static int get_atlas_skyline_fit_y(const atlas_page_t *const page, const int node_index, const zfw_vec_2d_i_t size)
+{
+    if (page->skyline_nodes[node_index].x + size.x > page->size)
+    {
+        return -1;
+    }
+
+    int y = 0;
+    int width_left = size.x;
+
+    for (int i = node_index; width_left > 0; i++)
+    {
+        y = ZFW_MAX(page->skyline_nodes[i].y, y);
+        width_left -= page->skyline_nodes[i].width;
+    }
+
+    return y + size.y <= page->size ? y : -1;
+}
+
+// Places a rectangle of the given size on the skyline using the bottom-left rule, writing its position. Returns whether
+// there was room for it.
+static zfw_bool_t pack_into_atlas_page(atlas_page_t *const page, const zfw_vec_2d_i_t size, zfw_vec_2d_i_t *const pos)
+{
+    int best_node_index = -1;
+    int best_top = 0;
+    int best_node_width = 0;
+
+    for (int i = 0; i < page->skyline_node_count; i++)
+    {
+        const int y = get_atlas_skyline_fit_y(page, i, size);
+
+        if (y == -1)
+        {
+            continue;
+        }
+
+        const int top = y + size.y;
+
+        if (best_node_index == -1 || top < best_top || (top == best_top && page->skyline_nodes[i].width < best_node_width))
+        {
+            best_node_index = i;
+            best_top = top;
+            best_node_width = page->skyline_nodes[i].width;
+            *pos = zfw_create_vec_2d_i(page->skyline_nodes[i].x, y);
+        }
+    }
+
+    if (best_node_index == -1)
+    {
+        return ZFW_FALSE;
+    }
+
+    // Insert a node for the top of the new rectangle.
+    memmove(&page->skyline_nodes[best_node_index + 1], &page->skyline_nodes[best_node_index], sizeof(*page->skyline_nodes) * (page->skyline_node_count - best_node_index));
+    page->skyline_node_count++;
+
+    page->skyline_nodes[best_node_index].x = pos->x;
+    page->skyline_nodes[best_node_index].y = best_top;
+    page->skyline_nodes[best_node_index].width = size.x;
+
+    // Shrink or remove the nodes now covered by it.
+    const int right = pos->x + size.x;
+
+    while (best_node_index + 1 < page->skyline_node_count && page->skyline_nodes[best_node_index + 1].x < right)
+    {
+        atlas_skyline_node_t *const node = &page->skyline_nodes[best_node_index + 1];
+        const int node_right = node->x + node->width;
+
+        if (node_right > right)
+        {
+            node->width = node_right - right;
+            node->x = right;
+            break;
+        }
+
+        memmove(node, node + 1, sizeof(*page->skyline_nodes) * (page->skyline_node_count - best_node_index - 2));
+        page->skyline_node_count--;
+    }
+
+    // Merge neighbouring nodes of the same height.
+    for (int i = 0; i < page->skyline_node_count - 1;)
+    {
+        if (page->skyline_nodes[i].y == page->skyline_nodes[i + 1].y)
+        {
+            page->skyline_nodes[i].width += page->skyline_nodes[i + 1].width;
+            memmove(&page->skyline_nodes[i + 1], &page->skyline_nodes[i + 2], sizeof(*page->skyline_nodes) * (page->skyline_node_count - i - 2));
+            page->skyline_node_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return ZFW_TRUE;
+}
+
+// Copies the texture into the page with its top-left at the given position, also repeating its edge pixels outward by
+// the extrusion amount so that filtering at the edges doesn't sample neighbouring textures.
+static void blit_into_atlas_page(atlas_page_t *const page, const atlas_src_tex_t *const tex, const zfw_vec_2d_i_t pos, const int extrusion)
+{
+    for (int y = -extrusion; y < tex->size.y + extrusion; y++)
+    {
+        const int src_y = ZFW_CLAMP(y, 0, tex->size.y - 1);
+
+        for (int x = -extrusion; x < tex->size.x + extrusion; x++)
+        {
+            const int src_x = ZFW_CLAMP(x, 0, tex->size.x - 1);
+
+            const int src_px_data_index = ((src_y * tex->size.x) + src_x) * ZFW_TEX_CHANNEL_COUNT;
+            const int dest_px_data_index = (((pos.y + y) * page->size) + pos.x + x) * ZFW_TEX_CHANNEL_COUNT;
+
+            memcpy(page->px_data + dest_px_data_index, tex->px_data + src_px_data_index, ZFW_TEX_CHANNEL_COUNT);
+        }
+    }
+}
+
+static int compare_atlas_src_texs(const void *const a, const void *const b)
+{
+    // Taller textures first, which keeps the skyline flatter.
+    const atlas_src_tex_t *const tex_a = a;
+    const atlas_src_tex_t *const tex_b = b;
+
+    if (tex_a->size.y != tex_b->size.y)
+    {
+        return tex_b->size.y - tex_a->size.y;
+    }
+
+    return tex_b->size.x - tex_a->size.x;
+}
+
+static void free_atlas_src_texs(atlas_src_tex_t *const src_texs, const int src_tex_count)
+{
+    for (int i = 0; i < src_tex_count; i++)
+    {
+        stbi_image_free(src_texs[i].px_data);
+    }
+
+    free(src_texs);
+}
+
+// Packs the textures of a single atlas packing instruction into new or existing pages of the atlas packing.
+static zfw_bool_t pack_atlas(const cJSON *const cj_atlas, const int atlas_tex_begin_index, atlas_packing_t *const packing, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len)
+{
+    const cJSON *const cj_page_size = cJSON_GetObjectItemCaseSensitive(cj_atlas, "page_size");
+    const cJSON *const cj_padding = cJSON_GetObjectItemCaseSensitive(cj_atlas, "padding");
+    const cJSON *const cj_extrusion = cJSON_GetObjectItemCaseSensitive(cj_atlas, "extrusion");
+    const cJSON *const cj_textures = cJSON_GetObjectItemCaseSensitive(cj_atlas, "textures");
+
+    const int page_size = cJSON_IsNumber(cj_page_size) ? cj_page_size->valueint : ATLAS_PAGE_SIZE_DEFAULT;
+    const int padding = cJSON_IsNumber(cj_padding) ? cj_padding->valueint : 0;
+    const int extrusion = cJSON_IsNumber(cj_extrusion) ? cj_extrusion->valueint : 0;
+
+    zfw_tex_format_t tex_format;
+
+    if (!get_tex_format(cJSON_GetObjectItemCaseSensitive(cj_atlas, "format"), &tex_format))
+    {
+        return ZFW_FALSE;
+    }
+
+    if (page_size <= 0 || padding < 0 || extrusion < 0)
+    {
+        zfw_log_error("Atlas page sizes must be positive, and paddings and extrusions must not be negative!");
+        return ZFW_FALSE;
+    }
+
+    const int src_tex_count = cJSON_GetArraySize(cj_textures);
+    atlas_src_tex_t *const src_texs = calloc(src_tex_count, sizeof(*src_texs));
+
+    if (!src_texs)
+    {
+        zfw_log_error("Failed to allocate %d bytes for atlas source textures!", sizeof(*src_texs) * src_tex_count);
+        return ZFW_FALSE;
+    }
+
+    // Load all textures of the atlas up front so that they can be packed from tallest to shortest.
     const cJSON *cj_tex = NULL;
 
+    int i = 0;
+
     cJSON_ArrayForEach(cj_tex, cj_textures)
     {
         if (!cJSON_IsString(cj_tex))
         {
+            free_atlas_src_texs(src_texs, i);
             return ZFW_FALSE;
         }
 
@@ -119,31 +567,258 @@ static zfw_bool_t pack_textures(cJSON *const c_json, char src_asset_file_path_bu
 
         if (src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE - 1])
         {
-            zfw_log_error("The texture relative file path of \"%s\" exceeds the size limit of %d characters!", cj_tex->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - 1 - src_asset_file_path_start_len);
+            zfw_log_error("The texture relative file path of \"%s\" exceeds the size limit of %d characters!", cj_tex->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - 1 - src_asset_file_path_start_len);
+            free_atlas_src_texs(src_texs, i);
+            return ZFW_FALSE;
+        }
+
+        src_texs[i].index = i;
+        src_texs[i].px_data = stbi_load(src_asset_file_path_buf, &src_texs[i].size.x, &src_texs[i].size.y, NULL, ZFW_TEX_CHANNEL_COUNT);
+
+        if (!src_texs[i].px_data)
+        {
+            zfw_log_error("Failed to load pixel data for texture with relative file path \"%s\"!", cj_tex->valuestring);
+            free_atlas_src_texs(src_texs, i);
+            return ZFW_FALSE;
+        }
+
+        i++;
+    }
+
+    qsort(src_texs, src_tex_count, sizeof(*src_texs), compare_atlas_src_texs);
+
+    // Only pages opened for this atlas are candidates, since atlases can differ in page size.
+    const int atlas_page_begin_index = packing->page_count;
+
+    for (int j = 0; j < src_tex_count; j++)
+    {
+        const atlas_src_tex_t *const src_tex = &src_texs[j];
+        const zfw_vec_2d_i_t packed_size = zfw_create_vec_2d_i(src_tex->size.x + (extrusion * 2) + padding, src_tex->size.y + (extrusion * 2) + padding);
+
+        if (packed_size.x > page_size || packed_size.y > page_size)
+        {
+            zfw_log_error("An atlas texture of size %dx%d does not fit in an atlas page of size %d with the given padding and extrusion!", src_tex->size.x, src_tex->size.y, page_size);
+            free_atlas_src_texs(src_texs, src_tex_count);
+            return ZFW_FALSE;
+        }
+
+        int page_index = atlas_page_begin_index;
+        zfw_vec_2d_i_t pos;
+
+        while (page_index < packing->page_count && !pack_into_atlas_page(&packing->pages[page_index], packed_size, &pos))
+        {
+            page_index++;
+        }
+
+        if (page_index == packing->page_count)
+        {
+            // No existing page has room, so open a new one.
+            if (packing->page_count == ATLAS_PAGE_LIMIT)
+            {
+                zfw_log_error("The atlas page limit of %d has been exceeded!", ATLAS_PAGE_LIMIT);
+                free_atlas_src_texs(src_texs, src_tex_count);
+                return ZFW_FALSE;
+            }
+
+            packing->page_count++;
+
+            if (!init_atlas_page(&packing->pages[page_index], page_size, tex_format))
+            {
+                free_atlas_src_texs(src_texs, src_tex_count);
+                return ZFW_FALSE;
+            }
+
+            pack_into_atlas_page(&packing->pages[page_index], packed_size, &pos);
+        }
+
+        atlas_page_t *const page = &packing->pages[page_index];
+
+        const zfw_vec_2d_i_t tex_pos = zfw_create_vec_2d_i(pos.x + extrusion, pos.y + extrusion);
+        blit_into_atlas_page(page, src_tex, tex_pos, extrusion);
+
+        page->used_size.x = ZFW_MAX(tex_pos.x + src_tex->size.x + extrusion, page->used_size.x);
+        page->used_size.y = ZFW_MAX(tex_pos.y + src_tex->size.y + extrusion, page->used_size.y);
+
+        const int atlas_tex_index = atlas_tex_begin_index + src_tex->index;
+        packing->tex_page_indexes[atlas_tex_index] = page_index;
+        packing->tex_src_rects[atlas_tex_index].x = tex_pos.x;
+        packing->tex_src_rects[atlas_tex_index].y = tex_pos.y;
+        packing->tex_src_rects[atlas_tex_index].width = src_tex->size.x;
+        packing->tex_src_rects[atlas_tex_index].height = src_tex->size.y;
+    }
+
+    free_atlas_src_texs(src_texs, src_tex_count);
+
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t pack_atlases(const cJSON *const cj_atlases, atlas_packing_t *const packing, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len)
+{
+    // Count the textures across all atlases so that their page indexes and source rectangles can be allocated at once.
+    const cJSON *cj_atlas = NULL;
+
+    cJSON_ArrayForEach(cj_atlas, cj_atlases)
+    {
+        const cJSON *const cj_textures = cJSON_GetObjectItemCaseSensitive(cj_atlas, "textures");
+
+        if (!cJSON_IsArray(cj_textures))
+        {
+            zfw_log_error("An atlas in \"%s\" does not have a \"textures\" array!", PACKING_INSTRS_FILE_NAME);
+            return ZFW_FALSE;
+        }
+
+        packing->tex_count += cJSON_GetArraySize(cj_textures);
+    }
+
+    if (!packing->tex_count)
+    {
+        return ZFW_TRUE;
+    }
+
+    packing->tex_page_indexes = malloc(sizeof(*packing->tex_page_indexes) * packing->tex_count);
+
+    if (!packing->tex_page_indexes)
+    {
+        zfw_log_error("Failed to allocate %d bytes for atlas texture page indexes!", sizeof(*packing->tex_page_indexes) * packing->tex_count);
+        return ZFW_FALSE;
+    }
+
+    packing->tex_src_rects = malloc(sizeof(*packing->tex_src_rects) * packing->tex_count);
+
+    if (!packing->tex_src_rects)
+    {
+        zfw_log_error("Failed to allocate %d bytes for atlas texture source rectangles!", sizeof(*packing->tex_src_rects) * packing->tex_count);
+        return ZFW_FALSE;
+    }
+
+    int atlas_tex_begin_index = 0;
+
+    cJSON_ArrayForEach(cj_atlas, cj_atlases)
+    {
+        if (!pack_atlas(cj_atlas, atlas_tex_begin_index, packing, src_asset_file_path_buf, src_asset_file_path_start_len))
+        {
+            return ZFW_FALSE;
+        }
+
+        atlas_tex_begin_index += cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(cj_atlas, "textures"));
+    }
+
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t pack_textures(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, assets_file_writer_t *const assets_file_writer)
+{
+    const cJSON *const cj_textures = cJSON_GetObjectItemCaseSensitive(c_json, "textures");
+    const cJSON *const cj_atlases = cJSON_GetObjectItemCaseSensitive(c_json, "atlases");
+
+    if (!cJSON_IsArray(cj_textures) && !cJSON_IsArray(cj_atlases))
+    {
+        zfw_log_warning("Did not find array with name \"textures\" or \"atlases\" in \"%s\".", PACKING_INSTRS_FILE_NAME);
+    }
+
+    // Pack atlases first, since their pages are written as textures following the standalone ones.
+    atlas_packing_t atlas_packing = {0};
+
+    if (cJSON_IsArray(cj_atlases) && !pack_atlases(cj_atlases, &atlas_packing, src_asset_file_path_buf, src_asset_file_path_start_len))
+    {
+        clean_atlas_packing(&atlas_packing);
+        return ZFW_FALSE;
+    }
+
+    const cJSON *const cj_standalone_textures = cJSON_IsArray(cj_textures) ? cj_textures : NULL;
+    const int standalone_tex_count = cJSON_GetArraySize(cj_standalone_textures);
+
+    // Write standalone textures.
+    const cJSON *cj_tex = NULL;
+
+    cJSON_ArrayForEach(cj_tex, cj_standalone_textures)
+    {
+        // A texture is either just a relative file path, or an object with a relative file path and a format.
+        const cJSON *const cj_rfp = cJSON_IsObject(cj_tex) ? cJSON_GetObjectItemCaseSensitive(cj_tex, "rfp") : cj_tex;
+
+        zfw_tex_format_t tex_format;
+
+        if (!cJSON_IsString(cj_rfp) || !get_tex_format(cJSON_IsObject(cj_tex) ? cJSON_GetObjectItemCaseSensitive(cj_tex, "format") : NULL, &tex_format))
+        {
+            clean_atlas_packing(&atlas_packing);
+            return ZFW_FALSE;
+        }
+
+        strncpy(src_asset_file_path_buf + src_asset_file_path_start_len, cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - src_asset_file_path_start_len);
+
+        if (src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE - 1])
+        {
+            zfw_log_error("The texture relative file path of \"%s\" exceeds the size limit of %d characters!", cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - 1 - src_asset_file_path_start_len);
+            clean_atlas_packing(&atlas_packing);
+            return ZFW_FALSE;
+        }
+
+        zfw_vec_2d_i_t tex_size;
+        stbi_uc *const tex_px_data = stbi_load(src_asset_file_path_buf, &tex_size.x, &tex_size.y, NULL, ZFW_TEX_CHANNEL_COUNT);
+
+        if (!tex_px_data)
+        {
+            zfw_log_error("Failed to load pixel data for texture with relative file path \"%s\"!", cj_rfp->valuestring);
+            clean_atlas_packing(&atlas_packing);
+            return ZFW_FALSE;
+        }
+
+        const zfw_bool_t tex_written = write_tex(tex_px_data, tex_size, tex_size.x, tex_format, zfw_get_asset_name_hash(cj_rfp->valuestring), assets_file_writer);
+
+        stbi_image_free(tex_px_data);
+
+        if (!tex_written)
+        {
+            clean_atlas_packing(&atlas_packing);
+            return ZFW_FALSE;
+        }
+    }
+
+    // Write atlas pages, cropped to the area covered by textures. They're named by their index, as they have no source file.
+    for (int i = 0; i < atlas_packing.page_count; i++)
+    {
+        const atlas_page_t *const page = &atlas_packing.pages[i];
+
+        char page_name[32];
+        snprintf(page_name, sizeof(page_name), "atlas_page_%d", i);
+
+        if (!write_tex(page->px_data, page->used_size, page->size, page->tex_format, zfw_get_asset_name_hash(page_name), assets_file_writer))
+        {
+            clean_atlas_packing(&atlas_packing);
+            return ZFW_FALSE;
+        }
+    }
+
+    // Write the atlas texture lookup, mapping each atlas texture to the texture index of its page and its rectangle in it.
+    if (atlas_packing.tex_count)
+    {
+        if (!begin_assets_file_entry(assets_file_writer, ZFW_ASSET_TYPE__ATLAS_TEX_LOOKUP, zfw_get_asset_name_hash("atlas_tex_lookup")))
+        {
+            clean_atlas_packing(&atlas_packing);
             return ZFW_FALSE;
         }
 
-        zfw_vec_2d_i_t tex_size;
-        stbi_uc *const tex_px_data = stbi_load(src_asset_file_path_buf, &tex_size.x, &tex_size.y, NULL, ZFW_TEX_CHANNEL_COUNT);
+        write_assets_file_entry_data(assets_file_writer, &atlas_packing.tex_count, sizeof(atlas_packing.tex_count), 1);
 
-        if (!tex_px_data)
+        for (int i = 0; i < atlas_packing.tex_count; i++)
         {
-            zfw_log_error("Failed to load pixel data for texture with relative file path \"%s\"!", cj_tex->valuestring);
-            return ZFW_FALSE;
+            const int page_tex_index = standalone_tex_count + atlas_packing.tex_page_indexes[i];
+            write_assets_file_entry_data(assets_file_writer, &page_tex_index, sizeof(page_tex_index), 1);
         }
 
-        fwrite(&tex_size, sizeof(tex_size), 1, assets_file_fs);
-        fwrite(tex_px_data, sizeof(*tex_px_data), tex_size.x * tex_size.y * ZFW_TEX_CHANNEL_COUNT, assets_file_fs);
+        write_assets_file_entry_data(assets_file_writer, atlas_packing.tex_src_rects, sizeof(*atlas_packing.tex_src_rects), atlas_packing.tex_count);
 
-        stbi_image_free(tex_px_data);
+        end_assets_file_entry(assets_file_writer);
     }
 
+    clean_atlas_packing(&atlas_packing);
+
     return ZFW_TRUE;
 }
 
-static zfw_bool_t pack_shader_progs(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, FILE *const assets_file_fs)
+static zfw_bool_t pack_shader_progs(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, assets_file_writer_t *const assets_file_writer)
 {
-    const cJSON *const cj_progs = get_cj_assets_array_and_write_asset_count_to_assets_file(c_json, "shader_progs", assets_file_fs);
+    const cJSON *const cj_progs = get_cj_assets_array(c_json, "shader_progs");
 
     if (!cj_progs)
     {
@@ -162,6 +837,14 @@ static zfw_bool_t pack_shader_progs(cJSON *const c_json, char src_asset_file_pat
             return ZFW_FALSE;
         }
 
+        // A program is named by both of its shader file paths together.
+        const unsigned int name_hash = zfw_update_fnv_1a_hash(zfw_get_asset_name_hash(cj_vert_shader_rfp->valuestring), cj_frag_shader_rfp->valuestring, strlen(cj_frag_shader_rfp->valuestring));
+
+        if (!begin_assets_file_entry(assets_file_writer, ZFW_ASSET_TYPE__SHADER_PROG, name_hash))
+        {
+            return ZFW_FALSE;
+        }
+
         for (int i = 0; i < 2; i++)
         {
             const char *const shader_file_rel_path = i == 0 ? cj_vert_shader_rfp->valuestring : cj_frag_shader_rfp->valuestring;
@@ -197,282 +880,616 @@ static zfw_bool_t pack_shader_progs(cJSON *const c_json, char src_asset_file_pat
             fseek(shader_file_fs, 0, SEEK_SET);
             fread(shader_src_buf, 1, shader_file_size, shader_file_fs);
 
-            fwrite(shader_src_buf, 1, sizeof(shader_src_buf), assets_file_fs);
+            write_assets_file_entry_data(assets_file_writer, shader_src_buf, 1, sizeof(shader_src_buf));
 
             fclose(shader_file_fs);
         }
+
+        end_assets_file_entry(assets_file_writer);
     }
 
     return ZFW_TRUE;
 }
 
-static zfw_bool_t pack_fonts(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, FILE *const assets_file_fs)
+static void clean_font_packing(font_packing_t *const packing)
 {
-    const cJSON *const cj_fonts = get_cj_assets_array_and_write_asset_count_to_assets_file(c_json, "fonts", assets_file_fs);
+    free(packing->line_heights);
+    free(packing->chars_begin_indexes);
+    free(packing->char_counts);
+    free(packing->kerning_pairs_begin_indexes);
+    free(packing->kerning_pair_counts);
+    free(packing->tex_sizes);
+    free(packing->sdfs);
+    free(packing->name_hashes);
+
+    free(packing->chars_codepoints);
+    free(packing->chars_hor_offsets);
+    free(packing->chars_vert_offsets);
+    free(packing->chars_hor_advances);
+    free(packing->chars_src_rects);
+
+    free(packing->kerning_pairs);
+
+    memset(packing, 0, sizeof(*packing));
+}
 
-    if (!cj_fonts)
+static zfw_bool_t init_font_packing(font_packing_t *const packing, const int font_count)
+{
+    memset(packing, 0, sizeof(*packing));
+
+    packing->line_heights = calloc(font_count, sizeof(*packing->line_heights));
+    packing->chars_begin_indexes = calloc(font_count, sizeof(*packing->chars_begin_indexes));
+    packing->char_counts = calloc(font_count, sizeof(*packing->char_counts));
+    packing->kerning_pairs_begin_indexes = calloc(font_count, sizeof(*packing->kerning_pairs_begin_indexes));
+    packing->kerning_pair_counts = calloc(font_count, sizeof(*packing->kerning_pair_counts));
+    packing->tex_sizes = calloc(font_count, sizeof(*packing->tex_sizes));
+    packing->sdfs = calloc(font_count, sizeof(*packing->sdfs));
+    packing->name_hashes = calloc(font_count, sizeof(*packing->name_hashes));
+
+    if (!packing->line_heights || !packing->chars_begin_indexes || !packing->char_counts || !packing->kerning_pairs_begin_indexes || !packing->kerning_pair_counts || !packing->tex_sizes || !packing->sdfs || !packing->name_hashes)
     {
-        return ZFW_TRUE;
+        zfw_log_error("Failed to allocate font packing data for %d fonts!", font_count);
+        clean_font_packing(packing);
+        return ZFW_FALSE;
     }
 
-    const int cj_fonts_len = cJSON_GetArraySize(cj_fonts);
-
-    // Set up buffers for font data.
-    zfw_mem_arena_t main_mem_arena;
-    zfw_init_mem_arena(&main_mem_arena, (1 << 20) * 10);
+    return ZFW_TRUE;
+}
 
-    int *line_heights = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*line_heights) * cj_fonts_len);
+// Resizes an array of font packing data, leaving it untouched on failure.
+static zfw_bool_t resize_font_packing_array(void **const array, const int elem_size, const int cap)
+{
+    void *const array_new = realloc(*array, elem_size * cap);
 
-    if (!line_heights)
+    if (!array_new)
     {
-        zfw_clean_mem_arena(&main_mem_arena);
+        zfw_log_error("Failed to allocate %d bytes for font packing data!", elem_size * cap);
         return ZFW_FALSE;
     }
 
-    font_char_hor_offs_t *char_hor_offsets = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*char_hor_offsets) * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len);
+    *array = array_new;
 
-    if (!char_hor_offsets)
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t ensure_font_packing_char_cap(font_packing_t *const packing, const int cap)
+{
+    if (cap <= packing->char_cap)
     {
-        zfw_clean_mem_arena(&main_mem_arena);
-        return ZFW_FALSE;
+        return ZFW_TRUE;
     }
 
-    font_char_vert_offs_t *char_vert_offsets = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*char_vert_offsets) * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len);
+    const int cap_new = ZFW_MAX(packing->char_cap * 2, cap);
 
-    if (!char_vert_offsets)
+    if (!resize_font_packing_array((void **)&packing->chars_codepoints, sizeof(*packing->chars_codepoints), cap_new)
+        || !resize_font_packing_array((void **)&packing->chars_hor_offsets, sizeof(*packing->chars_hor_offsets), cap_new)
+        || !resize_font_packing_array((void **)&packing->chars_vert_offsets, sizeof(*packing->chars_vert_offsets), cap_new)
+        || !resize_font_packing_array((void **)&packing->chars_hor_advances, sizeof(*packing->chars_hor_advances), cap_new)
+        || !resize_font_packing_array((void **)&packing->chars_src_rects, sizeof(*packing->chars_src_rects), cap_new))
     {
-        zfw_clean_mem_arena(&main_mem_arena);
         return ZFW_FALSE;
     }
 
-    font_char_hor_advance_t *chars_hor_advances = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*chars_hor_advances) * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len);
+    packing->char_cap = cap_new;
+
+    return ZFW_TRUE;
+}
 
-    if (!chars_hor_advances)
+static zfw_bool_t add_font_kerning_pair(font_packing_t *const packing, const unsigned int char_indexes_key, const font_char_kerning_t kerning)
+{
+    if (packing->kerning_pair_count == packing->kerning_pair_cap)
     {
-        zfw_clean_mem_arena(&main_mem_arena);
-        return ZFW_FALSE;
-    }
+        const int cap_new = packing->kerning_pair_cap ? packing->kerning_pair_cap * 2 : FONT_KERNING_PAIR_CAP_INIT;
 
-    font_char_src_rect_t *char_src_rects = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*char_src_rects) * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len);
+        if (!resize_font_packing_array((void **)&packing->kerning_pairs, sizeof(*packing->kerning_pairs), cap_new))
+        {
+            return ZFW_FALSE;
+        }
 
-    if (!char_src_rects)
-    {
-        zfw_clean_mem_arena(&main_mem_arena);
-        return ZFW_FALSE;
+        packing->kerning_pair_cap = cap_new;
     }
 
-    font_char_kerning_t *char_kernings = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*char_kernings) * ZFW_FONT_CHAR_RANGE_SIZE * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len);
+    // The padding of the pair is cleared too, since it gets written to the assets file.
+    font_char_kerning_pair_t *const pair = &packing->kerning_pairs[packing->kerning_pair_count];
+    memset(pair, 0, sizeof(*pair));
+    pair->char_indexes_key = char_indexes_key;
+    pair->kerning = kerning;
+
+    packing->kerning_pair_count++;
+
+    return ZFW_TRUE;
+}
+
+static int compare_codepoints(const void *const a, const void *const b)
+{
+    const unsigned int codepoint_a = *(const unsigned int *)a;
+    const unsigned int codepoint_b = *(const unsigned int *)b;
+
+    return (codepoint_a > codepoint_b) - (codepoint_a < codepoint_b);
+}
 
-    if (!char_kernings)
+// Gets the first and last codepoint of a range of a font, which is an array of the two. Fonts without ranges have a
+// single range covering printable ASCII.
+static zfw_bool_t get_font_codepoint_range(const cJSON *const cj_ranges, const int range_index, int *const begin, int *const end)
+{
+    if (!cj_ranges)
     {
-        zfw_clean_mem_arena(&main_mem_arena);
-        return ZFW_FALSE;
+        *begin = FONT_CODEPOINT_RANGE_DEFAULT_BEGIN;
+        *end = FONT_CODEPOINT_RANGE_DEFAULT_END;
+        return ZFW_TRUE;
     }
 
-    zfw_vec_2d_i_t *tex_sizes = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*tex_sizes) * cj_fonts_len);
+    const cJSON *const cj_range = cJSON_GetArrayItem(cj_ranges, range_index);
 
-    if (!tex_sizes)
+    if (!cJSON_IsArray(cj_range) || cJSON_GetArraySize(cj_range) != 2 || !cJSON_IsNumber(cJSON_GetArrayItem(cj_range, 0)) || !cJSON_IsNumber(cJSON_GetArrayItem(cj_range, 1)))
     {
-        zfw_clean_mem_arena(&main_mem_arena);
+        zfw_log_error("Font codepoint ranges must each be an array of a first and last codepoint!");
         return ZFW_FALSE;
     }
 
-    unsigned char **tex_px_datas = zfw_mem_arena_alloc(&main_mem_arena, sizeof(*tex_px_datas) * cj_fonts_len);
+    *begin = cJSON_GetArrayItem(cj_range, 0)->valueint;
+    *end = cJSON_GetArrayItem(cj_range, 1)->valueint;
 
-    if (!tex_px_datas)
+    if (*begin < 0 || *begin > *end || *end > ZFW_FONT_CODEPOINT_MAX)
     {
-        zfw_clean_mem_arena(&main_mem_arena);
+        zfw_log_error("The font codepoint range of %d to %d is invalid!", *begin, *end);
         return ZFW_FALSE;
     }
 
-    // Initialise FreeType.
-    FT_Library ft_lib;
+    return ZFW_TRUE;
+}
 
-    if (FT_Init_FreeType(&ft_lib))
+// Returns the sorted codepoints covered by the ranges of a font, without duplicates from overlapping ranges. These must
+// be freed.
+static unsigned int *load_font_codepoints(const cJSON *const cj_ranges, int *const codepoint_count)
+{
+    if (cj_ranges && (!cJSON_IsArray(cj_ranges) || !cJSON_GetArraySize(cj_ranges)))
     {
-        zfw_log_error("Failed to initialise FreeType!");
-        return ZFW_FALSE;
+        zfw_log_error("Font codepoint ranges must be given as a non-empty array!");
+        return NULL;
     }
 
-    // Iterate through each font array element.
-    const cJSON *cj_font = NULL;
+    const int range_count = cj_ranges ? cJSON_GetArraySize(cj_ranges) : 1;
 
-    int i = 0;
+    // Count the codepoints of all ranges, checking against the character limit as we go so that the count can't overflow.
+    int range_codepoint_count = 0;
 
-    cJSON_ArrayForEach(cj_font, cj_fonts)
+    for (int i = 0; i < range_count; i++)
     {
-        const cJSON *const cj_rfp = cJSON_GetObjectItemCaseSensitive(cj_font, "rfp");
-        const cJSON *const cj_pt_size = cJSON_GetObjectItemCaseSensitive(cj_font, "pt_size");
+        int begin, end;
 
-        if (!cJSON_IsString(cj_rfp) || !cJSON_IsNumber(cj_pt_size))
+        if (!get_font_codepoint_range(cj_ranges, i, &begin, &end))
         {
-            zfw_clean_mem_arena(&main_mem_arena);
-            return ZFW_FALSE;
+            return NULL;
         }
 
-        strncpy(src_asset_file_path_buf + src_asset_file_path_start_len, cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - src_asset_file_path_start_len);
+        range_codepoint_count += end - begin + 1;
 
-        if (src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE - 1])
+        if (range_codepoint_count > ZFW_FONT_CHAR_LIMIT)
         {
-            zfw_log_error("The font relative file path of \"%s\" exceeds the size limit of %d characters!", cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - 1 - src_asset_file_path_start_len);
-            zfw_clean_mem_arena(&main_mem_arena);
-            return ZFW_FALSE;
+            zfw_log_error("The codepoint ranges of a font cover more than the limit of %d characters!", ZFW_FONT_CHAR_LIMIT);
+            return NULL;
         }
+    }
 
-        if (cj_pt_size->valueint < FONT_PT_SIZE_MIN || cj_pt_size->valueint > FONT_PT_SIZE_MAX)
-        {
-            zfw_log_error("Font point sizes must be between %d and %d inclusive!", FONT_PT_SIZE_MIN, FONT_PT_SIZE_MAX);
+    unsigned int *const codepoints = malloc(sizeof(*codepoints) * range_codepoint_count);
 
-            FT_Done_FreeType(ft_lib);
-            zfw_clean_mem_arena(&main_mem_arena);
+    if (!codepoints)
+    {
+        zfw_log_error("Failed to allocate %d bytes for font codepoints!", sizeof(*codepoints) * range_codepoint_count);
+        return NULL;
+    }
 
-            return ZFW_FALSE;
-        }
+    int codepoint_index = 0;
 
-        // Set up the font face.
-        FT_Face ft_face;
+    for (int i = 0; i < range_count; i++)
+    {
+        int begin, end;
+        get_font_codepoint_range(cj_ranges, i, &begin, &end);
 
-        if (FT_New_Face(ft_lib, src_asset_file_path_buf, 0, &ft_face))
+        for (int j = begin; j <= end; j++)
         {
-            zfw_log_error("Failed to set up the FreeType face object for font with relative path \"%s\".", cj_rfp->valuestring);
+            codepoints[codepoint_index] = j;
+            codepoint_index++;
+        }
+    }
 
-            FT_Done_FreeType(ft_lib);
-            zfw_clean_mem_arena(&main_mem_arena);
+    qsort(codepoints, range_codepoint_count, sizeof(*codepoints), compare_codepoints);
 
-            return ZFW_FALSE;
+    // Remove the duplicates, which are now adjacent.
+    *codepoint_count = 0;
+
+    for (int i = 0; i < range_codepoint_count; i++)
+    {
+        if (i == 0 || codepoints[i] != codepoints[i - 1])
+        {
+            codepoints[*codepoint_count] = codepoints[i];
+            (*codepoint_count)++;
         }
+    }
 
-        FT_Set_Char_Size(ft_face, cj_pt_size->valueint << 6, 0, 96, 0);
+    return codepoints;
+}
 
-        line_heights[i] = ft_face->size->metrics.height >> 6;
+// Adds the characters and kerning pairs of a loaded font face to the font packing, and writes its texture as an entry.
+static zfw_bool_t pack_font_face(const FT_Face ft_face, const unsigned int *const codepoints, const int codepoint_count, const int font_index, font_packing_t *const packing, assets_file_writer_t *const assets_file_writer)
+{
+    const FT_Render_Mode ft_render_mode = packing->sdfs[font_index] ? FT_RENDER_MODE_SDF : FT_RENDER_MODE_NORMAL;
 
-        // Get the largest bitmap width of a glyph.
-        int largest_glyph_bitmap_width = 0;
+    packing->line_heights[font_index] = ft_face->size->metrics.height >> 6;
 
-        for (int j = 0; j < ZFW_FONT_CHAR_RANGE_SIZE; j++)
-        {
-            FT_Load_Glyph(ft_face, FT_Get_Char_Index(ft_face, ZFW_FONT_CHAR_RANGE_BEGIN + j), FT_LOAD_DEFAULT);
-            FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+    // Make room for every codepoint, though those that the font has no glyph for get left out.
+    if (!ensure_font_packing_char_cap(packing, packing->char_count + codepoint_count))
+    {
+        return ZFW_FALSE;
+    }
 
-            largest_glyph_bitmap_width = ZFW_MAX(ft_face->glyph->bitmap.width, largest_glyph_bitmap_width);
-        }
+    FT_UInt *const ft_char_indexes = malloc(sizeof(*ft_char_indexes) * codepoint_count);
 
-        // Set the ideal width of the font texture based on the largest glyph
-        // bitmap width.
-        const int ideal_tex_width = largest_glyph_bitmap_width * ZFW_FONT_CHAR_RANGE_SIZE;
+    if (!ft_char_indexes)
+    {
+        zfw_log_error("Failed to allocate %d bytes for font glyph indexes!", sizeof(*ft_char_indexes) * codepoint_count);
+        return ZFW_FALSE;
+    }
 
-        // Determine the actual font texture size based on the ideal width and a
-        // maximum width.
-        const int max_tex_width = 1024;
+    // Get and store the metrics of each character, along with the largest glyph bitmap size.
+    const int chars_begin_index = packing->char_count;
+    int char_count = 0;
 
-        tex_sizes[i].x = ZFW_MIN(ideal_tex_width, max_tex_width);
-        tex_sizes[i].y = line_heights[i] * ((ideal_tex_width / max_tex_width) + 1);
+    int largest_glyph_bitmap_width = 0;
+    int largest_glyph_bitmap_height = 0;
+    long long glyph_bitmap_width_sum = 0;
 
-        // Initialise the pixel data of the font texture by setting all the
-        // pixels to be transparent white.
-        const int tex_px_data_size = tex_sizes[i].x * tex_sizes[i].y * ZFW_FONT_TEX_CHANNEL_COUNT;
-        tex_px_datas[i] = zfw_mem_arena_alloc(&main_mem_arena, tex_px_data_size);
+    for (int i = 0; i < codepoint_count; i++)
+    {
+        const FT_UInt ft_char_index = FT_Get_Char_Index(ft_face, codepoints[i]);
 
-        if (!tex_px_datas[i])
+        if (!ft_char_index)
         {
-            FT_Done_Face(ft_face);
-            FT_Done_FreeType(ft_lib);
-
-            return ZFW_FALSE;
+            continue;
         }
 
-        for (int j = (tex_sizes[i].x * tex_sizes[i].y) - 1; j >= 0; j--)
-        {
-            const int px_data_index = j * 4;
+        FT_Load_Glyph(ft_face, ft_char_index, FT_LOAD_DEFAULT);
+        FT_Render_Glyph(ft_face->glyph, ft_render_mode);
 
-            tex_px_datas[i][px_data_index + 0] = 255;
-            tex_px_datas[i][px_data_index + 1] = 255;
-            tex_px_datas[i][px_data_index + 2] = 255;
-            tex_px_datas[i][px_data_index + 3] = 0;
+        const int char_index = chars_begin_index + char_count;
+
+        packing->chars_codepoints[char_index] = codepoints[i];
+
+        if (packing->sdfs[font_index])
+        {
+            // The bitmap extends past the glyph outline by the spread, which its bitmap offsets account for.
+            packing->chars_hor_offsets[char_index] = ft_face->glyph->bitmap_left;
+            packing->chars_vert_offsets[char_index] = (ft_face->size->metrics.ascender >> 6) - ft_face->glyph->bitmap_top;
+        }
+        else
+        {
+            packing->chars_hor_offsets[char_index] = ft_face->glyph->metrics.horiBearingX >> 6;
+            packing->chars_vert_offsets[char_index] = (ft_face->size->metrics.ascender - ft_face->glyph->metrics.horiBearingY) >> 6;
         }
 
-        // Get and store information for all font characters.
-        int char_draw_x = 0;
-        int char_draw_y = 0;
+        packing->chars_hor_advances[char_index] = ft_face->glyph->metrics.horiAdvance >> 6;
+
+        packing->chars_src_rects[char_index].width = ft_face->glyph->bitmap.width;
+        packing->chars_src_rects[char_index].height = ft_face->glyph->bitmap.rows;
+
+        largest_glyph_bitmap_width = ZFW_MAX(ft_face->glyph->bitmap.width, largest_glyph_bitmap_width);
+        largest_glyph_bitmap_height = ZFW_MAX(ft_face->glyph->bitmap.rows, largest_glyph_bitmap_height);
+        glyph_bitmap_width_sum += ft_face->glyph->bitmap.width;
+
+        ft_char_indexes[char_count] = ft_char_index;
+        char_count++;
+    }
+
+    if (!char_count)
+    {
+        zfw_log_error("A font has no glyphs for any of its codepoints!");
+        free(ft_char_indexes);
+        return ZFW_FALSE;
+    }
+
+    packing->chars_begin_indexes[font_index] = chars_begin_index;
+    packing->char_counts[font_index] = char_count;
+    packing->char_count += char_count;
+
+    // Lay the characters out in rows across the font texture, each of which must fit the tallest glyph bitmap. For signed
+    // distance fields this includes padding around the glyph for the distances to spread into.
+    const int tex_row_height = ZFW_MAX(packing->line_heights[font_index], largest_glyph_bitmap_height);
+
+    // The texture width is doubled until its square would hold every row, so that the texture stays roughly square.
+    const long long tex_row_area = glyph_bitmap_width_sum * tex_row_height;
+
+    zfw_vec_2d_i_t *const tex_size = &packing->tex_sizes[font_index];
+    tex_size->x = FONT_TEX_WIDTH_MIN;
+
+    while (tex_size->x < FONT_TEX_SIZE_MAX && (tex_size->x < largest_glyph_bitmap_width || (long long)tex_size->x * tex_size->x < tex_row_area))
+    {
+        tex_size->x *= 2;
+    }
+
+    if (largest_glyph_bitmap_width > tex_size->x || tex_row_height > FONT_TEX_SIZE_MAX)
+    {
+        zfw_log_error("A font has a glyph of size %dx%d, which exceeds the font texture size limit of %d!", largest_glyph_bitmap_width, tex_row_height, FONT_TEX_SIZE_MAX);
+        free(ft_char_indexes);
+        return ZFW_FALSE;
+    }
+
+    int char_draw_x = 0;
+    int char_draw_y = 0;
+
+    for (int i = 0; i < char_count; i++)
+    {
+        font_char_src_rect_t *const src_rect = &packing->chars_src_rects[chars_begin_index + i];
 
-        for (int j = 0; j < ZFW_FONT_CHAR_RANGE_SIZE; j++)
+        if (char_draw_x + src_rect->width > tex_size->x)
         {
-            const FT_UInt ft_char_index = FT_Get_Char_Index(ft_face, ZFW_FONT_CHAR_RANGE_BEGIN + j);
+            char_draw_x = 0;
+            char_draw_y += tex_row_height;
+        }
 
-            FT_Load_Glyph(ft_face, ft_char_index, FT_LOAD_DEFAULT);
-            FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+        src_rect->x = char_draw_x;
+        src_rect->y = char_draw_y;
 
-            if (char_draw_x + ft_face->glyph->bitmap.width > max_tex_width)
-            {
-                char_draw_x = 0;
-                char_draw_y += line_heights[i];
-            }
+        char_draw_x += src_rect->width;
+    }
+
+    tex_size->y = char_draw_y + tex_row_height;
+
+    if (tex_size->y > FONT_TEX_SIZE_MAX)
+    {
+        zfw_log_error("The %d glyphs of a font need a texture of size %dx%d, which exceeds the font texture size limit of %d! Try a smaller point size or fewer codepoints.", char_count, tex_size->x, tex_size->y, FONT_TEX_SIZE_MAX);
+        free(ft_char_indexes);
+        return ZFW_FALSE;
+    }
 
-            const int font_char_index = (i * ZFW_FONT_CHAR_RANGE_SIZE) + j;
+    // Initialise the pixel data of the font texture by setting all the pixels to be transparent white.
+    const int tex_px_data_size = tex_size->x * tex_size->y * ZFW_FONT_TEX_CHANNEL_COUNT;
+    unsigned char *const tex_px_data = malloc(tex_px_data_size);
 
-            char_hor_offsets[font_char_index] = ft_face->glyph->metrics.horiBearingX >> 6;
-            char_vert_offsets[font_char_index] = (ft_face->size->metrics.ascender - ft_face->glyph->metrics.horiBearingY) >> 6;
+    if (!tex_px_data)
+    {
+        zfw_log_error("Failed to allocate %d bytes for font texture pixel data!", tex_px_data_size);
+        free(ft_char_indexes);
+        return ZFW_FALSE;
+    }
+
+    for (int i = (tex_size->x * tex_size->y) - 1; i >= 0; i--)
+    {
+        const int px_data_index = i * ZFW_FONT_TEX_CHANNEL_COUNT;
+
+        tex_px_data[px_data_index + 0] = 255;
+        tex_px_data[px_data_index + 1] = 255;
+        tex_px_data[px_data_index + 2] = 255;
+        tex_px_data[px_data_index + 3] = 0;
+    }
 
-            chars_hor_advances[font_char_index] = ft_face->glyph->metrics.horiAdvance >> 6;
+    // Update the font texture's pixel data with each character. For signed distance field fonts, the alpha holds the
+    // distance rather than the coverage.
+    for (int i = 0; i < char_count; i++)
+    {
+        FT_Load_Glyph(ft_face, ft_char_indexes[i], FT_LOAD_DEFAULT);
+        FT_Render_Glyph(ft_face->glyph, ft_render_mode);
 
-            char_src_rects[font_char_index].x = char_draw_x;
-            char_src_rects[font_char_index].y = char_draw_y;
-            char_src_rects[font_char_index].width = ft_face->glyph->bitmap.width;
-            char_src_rects[font_char_index].height = ft_face->glyph->bitmap.rows;
+        const font_char_src_rect_t *const src_rect = &packing->chars_src_rects[chars_begin_index + i];
 
-            for (int k = 0; k < ZFW_FONT_CHAR_RANGE_SIZE; k++)
+        for (int y = 0; y < src_rect->height; y++)
+        {
+            for (int x = 0; x < src_rect->width; x++)
             {
-                FT_Vector ft_kerning;
-                FT_Get_Kerning(ft_face, FT_Get_Char_Index(ft_face, ZFW_FONT_CHAR_RANGE_BEGIN + k), ft_char_index, FT_KERNING_DEFAULT, &ft_kerning);
+                const unsigned char px_alpha = ft_face->glyph->bitmap.buffer[(y * ft_face->glyph->bitmap.width) + x];
 
-                char_kernings[(ZFW_FONT_CHAR_RANGE_SIZE * font_char_index) + k] = ft_kerning.x >> 6;
+                if (px_alpha > 0)
+                {
+                    const int px_data_index = ((src_rect->y + y) * tex_size->x * ZFW_FONT_TEX_CHANNEL_COUNT) + ((src_rect->x + x) * ZFW_FONT_TEX_CHANNEL_COUNT);
+                    tex_px_data[px_data_index + 3] = px_alpha;
+                }
             }
+        }
+    }
+
+    // Store the kerning of each pair of characters that has any. Pairs are visited in key order, so they stay sorted.
+    // Every pair has to be queried, so the search is limited to the characters with the lowest codepoints to keep large
+    // ranges from taking quadratic time.
+    packing->kerning_pairs_begin_indexes[font_index] = packing->kerning_pair_count;
+
+    if (FT_HAS_KERNING(ft_face))
+    {
+        const int kerning_char_count = ZFW_MIN(char_count, FONT_KERNING_CHAR_COUNT_MAX);
+
+        if (char_count > FONT_KERNING_CHAR_COUNT_MAX)
+        {
+            zfw_log_warning("A font has %d characters, so kerning is only packed between the first %d, up to codepoint %u.", char_count, FONT_KERNING_CHAR_COUNT_MAX, packing->chars_codepoints[chars_begin_index + kerning_char_count - 1]);
+        }
 
-            // Update the font texture's pixel data with the character.
-            for (int y = 0; y < char_src_rects[font_char_index].height; y++)
+        for (int i = 0; i < kerning_char_count; i++)
+        {
+            for (int j = 0; j < kerning_char_count; j++)
             {
-                for (int x = 0; x < char_src_rects[font_char_index].width; x++)
-                {
-                    const unsigned char px_alpha = ft_face->glyph->bitmap.buffer[(y * ft_face->glyph->bitmap.width) + x];
+                FT_Vector ft_kerning;
+                FT_Get_Kerning(ft_face, ft_char_indexes[i], ft_char_indexes[j], FT_KERNING_DEFAULT, &ft_kerning);
+
+                const font_char_kerning_t kerning = ft_kerning.x >> 6;
 
-                    if (px_alpha > 0)
-                    {
-                        const int px_data_index = ((char_src_rects[font_char_index].y + y) * tex_sizes[i].x * ZFW_FONT_TEX_CHANNEL_COUNT) + ((char_src_rects[font_char_index].x + x) * ZFW_FONT_TEX_CHANNEL_COUNT);
-                        tex_px_datas[i][px_data_index + 3] = px_alpha;
-                    }
+                if (kerning && !add_font_kerning_pair(packing, ((unsigned int)i << 16) | j, kerning))
+                {
+                    free(tex_px_data);
+                    free(ft_char_indexes);
+                    return ZFW_FALSE;
                 }
             }
-
-            char_draw_x += char_src_rects[font_char_index].width;
         }
+    }
 
-        FT_Done_Face(ft_face);
+    packing->kerning_pair_counts[font_index] = packing->kerning_pair_count - packing->kerning_pairs_begin_indexes[font_index];
 
-        i++;
+    free(ft_char_indexes);
+
+    // Write the font texture straight away, so that only one is ever held at once.
+    if (!begin_assets_file_entry(assets_file_writer, ZFW_ASSET_TYPE__FONT_TEX, packing->name_hashes[font_index]))
+    {
+        free(tex_px_data);
+        return ZFW_FALSE;
     }
 
-    FT_Done_FreeType(ft_lib);
+    write_assets_file_entry_data(assets_file_writer, tex_px_data, sizeof(*tex_px_data), tex_px_data_size);
+
+    end_assets_file_entry(assets_file_writer);
+
+    free(tex_px_data);
+
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t pack_font(const cJSON *const cj_font, const int font_index, font_packing_t *const packing, const FT_Library ft_lib, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, assets_file_writer_t *const assets_file_writer)
+{
+    const cJSON *const cj_rfp = cJSON_GetObjectItemCaseSensitive(cj_font, "rfp");
+    const cJSON *const cj_pt_size = cJSON_GetObjectItemCaseSensitive(cj_font, "pt_size");
+    const cJSON *const cj_sdf = cJSON_GetObjectItemCaseSensitive(cj_font, "sdf");
+    const cJSON *const cj_ranges = cJSON_GetObjectItemCaseSensitive(cj_font, "ranges");
+
+    if (!cJSON_IsString(cj_rfp) || !cJSON_IsNumber(cj_pt_size))
+    {
+        return ZFW_FALSE;
+    }
+
+    strncpy(src_asset_file_path_buf + src_asset_file_path_start_len, cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - src_asset_file_path_start_len);
+
+    if (src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE - 1])
+    {
+        zfw_log_error("The font relative file path of \"%s\" exceeds the size limit of %d characters!", cj_rfp->valuestring, SRC_ASSET_FILE_PATH_BUF_SIZE - 1 - src_asset_file_path_start_len);
+        return ZFW_FALSE;
+    }
+
+    if (cj_pt_size->valueint < FONT_PT_SIZE_MIN || cj_pt_size->valueint > FONT_PT_SIZE_MAX)
+    {
+        zfw_log_error("Font point sizes must be between %d and %d inclusive!", FONT_PT_SIZE_MIN, FONT_PT_SIZE_MAX);
+        return ZFW_FALSE;
+    }
+
+    int codepoint_count;
+    unsigned int *const codepoints = load_font_codepoints(cj_ranges, &codepoint_count);
+
+    if (!codepoints)
+    {
+        return ZFW_FALSE;
+    }
+
+    // Set up the font face.
+    FT_Face ft_face;
+
+    if (FT_New_Face(ft_lib, src_asset_file_path_buf, 0, &ft_face))
+    {
+        zfw_log_error("Failed to set up the FreeType face object for font with relative path \"%s\".", cj_rfp->valuestring);
+        free(codepoints);
+        return ZFW_FALSE;
+    }
+
+    FT_Set_Char_Size(ft_face, cj_pt_size->valueint << 6, 0, 96, 0);
+
+    // Signed distance field fonts store the distance to the nearest glyph edge rather than coverage, so that they can be
+    // scaled to any size without blurring. The point size then only sets the resolution of the distance fields.
+    packing->sdfs[font_index] = cJSON_IsTrue(cj_sdf);
+
+    // A font is named by its file path and point size, as the same file can be packed at several sizes. Signed distance
+    // field fonts are named apart, so that the same file and size can be packed both ways.
+    packing->name_hashes[font_index] = zfw_update_fnv_1a_hash(zfw_get_asset_name_hash(cj_rfp->valuestring), &cj_pt_size->valueint, sizeof(cj_pt_size->valueint));
+
+    if (packing->sdfs[font_index])
+    {
+        packing->name_hashes[font_index] = zfw_update_fnv_1a_hash(packing->name_hashes[font_index], &packing->sdfs[font_index], sizeof(packing->sdfs[font_index]));
+    }
+
+    const zfw_bool_t packed = pack_font_face(ft_face, codepoints, codepoint_count, font_index, packing, assets_file_writer);
+
+    FT_Done_Face(ft_face);
+    free(codepoints);
+
+    return packed;
+}
+
+static zfw_bool_t pack_fonts(cJSON *const c_json, char src_asset_file_path_buf[SRC_ASSET_FILE_PATH_BUF_SIZE], const int src_asset_file_path_start_len, assets_file_writer_t *const assets_file_writer)
+{
+    const cJSON *const cj_fonts = get_cj_assets_array(c_json, "fonts");
+
+    if (!cj_fonts)
+    {
+        return ZFW_TRUE;
+    }
+
+    const int cj_fonts_len = cJSON_GetArraySize(cj_fonts);
+
+    font_packing_t packing;
+
+    if (!init_font_packing(&packing, cj_fonts_len))
+    {
+        return ZFW_FALSE;
+    }
+
+    // Initialise FreeType.
+    FT_Library ft_lib;
 
-    // Write the font data to the file.
-    fwrite(line_heights, sizeof(*line_heights), cj_fonts_len, assets_file_fs);
+    if (FT_Init_FreeType(&ft_lib))
+    {
+        zfw_log_error("Failed to initialise FreeType!");
+        clean_font_packing(&packing);
+        return ZFW_FALSE;
+    }
 
-    fwrite(char_hor_offsets, sizeof(*char_hor_offsets), ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len, assets_file_fs);
-    fwrite(char_vert_offsets, sizeof(*char_vert_offsets), ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len, assets_file_fs);
+    // Pack each font, whose texture entry is written as soon as it has been generated.
+    const cJSON *cj_font = NULL;
 
-    fwrite(chars_hor_advances, sizeof(*chars_hor_advances), ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len, assets_file_fs);
+    int i = 0;
 
-    fwrite(char_src_rects, sizeof(*char_src_rects), ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len, assets_file_fs);
+    cJSON_ArrayForEach(cj_font, cj_fonts)
+    {
+        if (!pack_font(cj_font, i, &packing, ft_lib, src_asset_file_path_buf, src_asset_file_path_start_len, assets_file_writer))
+        {
+            FT_Done_FreeType(ft_lib);
+            clean_font_packing(&packing);
+            return ZFW_FALSE;
+        }
 
-    fwrite(char_kernings, sizeof(*char_kernings), ZFW_FONT_CHAR_RANGE_SIZE * ZFW_FONT_CHAR_RANGE_SIZE * cj_fonts_len, assets_file_fs);
+        i++;
+    }
 
-    fwrite(tex_sizes, sizeof(*tex_sizes), cj_fonts_len, assets_file_fs);
+    FT_Done_FreeType(ft_lib);
 
-    for (int i = 0; i < cj_fonts_len; i++)
+    // Write the metrics of all fonts as a single entry.
+    if (!begin_assets_file_entry(assets_file_writer, ZFW_ASSET_TYPE__FONT_METRICS, zfw_get_asset_name_hash("font_metrics")))
     {
-        fwrite(tex_px_datas[i], sizeof(*tex_px_datas[i]), tex_sizes[i].x * tex_sizes[i].y * ZFW_FONT_TEX_CHANNEL_COUNT, assets_file_fs);
+        clean_font_packing(&packing);
+        return ZFW_FALSE;
     }
 
-    zfw_clean_mem_arena(&main_mem_arena);
+    write_assets_file_entry_data(assets_file_writer, &cj_fonts_len, sizeof(cj_fonts_len), 1);
+    write_assets_file_entry_data(assets_file_writer, &packing.char_count, sizeof(packing.char_count), 1);
+    write_assets_file_entry_data(assets_file_writer, &packing.kerning_pair_count, sizeof(packing.kerning_pair_count), 1);
+
+    write_assets_file_entry_data(assets_file_writer, packing.line_heights, sizeof(*packing.line_heights), cj_fonts_len);
+
+    write_assets_file_entry_data(assets_file_writer, packing.chars_begin_indexes, sizeof(*packing.chars_begin_indexes), cj_fonts_len);
+    write_assets_file_entry_data(assets_file_writer, packing.char_counts, sizeof(*packing.char_counts), cj_fonts_len);
+
+    write_assets_file_entry_data(assets_file_writer, packing.chars_codepoints, sizeof(*packing.chars_codepoints), packing.char_count);
+
+    write_assets_file_entry_data(assets_file_writer, packing.chars_hor_offsets, sizeof(*packing.chars_hor_offsets), packing.char_count);
+    write_assets_file_entry_data(assets_file_writer, packing.chars_vert_offsets, sizeof(*packing.chars_vert_offsets), packing.char_count);
+
+    write_assets_file_entry_data(assets_file_writer, packing.chars_hor_advances, sizeof(*packing.chars_hor_advances), packing.char_count);
+
+    write_assets_file_entry_data(assets_file_writer, packing.chars_src_rects, sizeof(*packing.chars_src_rects), packing.char_count);
+
+    write_assets_file_entry_data(assets_file_writer, packing.kerning_pairs_begin_indexes, sizeof(*packing.kerning_pairs_begin_indexes), cj_fonts_len);
+    write_assets_file_entry_data(assets_file_writer, packing.kerning_pair_counts, sizeof(*packing.kerning_pair_counts), cj_fonts_len);
+    write_assets_file_entry_data(assets_file_writer, packing.kerning_pairs, sizeof(*packing.kerning_pairs), packing.kerning_pair_count);
+
+    write_assets_file_entry_data(assets_file_writer, packing.tex_sizes, sizeof(*packing.tex_sizes), cj_fonts_len);
+
+    write_assets_file_entry_data(assets_file_writer, packing.sdfs, sizeof(*packing.sdfs), cj_fonts_len);
+
+    end_assets_file_entry(assets_file_writer);
+
+    clean_font_packing(&packing);
 
     return ZFW_TRUE;
 }
@@ -523,46 +1540,52 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    // Create or open the assets file.
-    FILE *const assets_file_fs = fopen(assets_file_path, "wb");
+    // Create or open the assets file, and reserve space for the header, which is written once the table of contents is.
+    assets_file_writer_t assets_file_writer = {0};
+    assets_file_writer.fs = fopen(assets_file_path, "wb");
 
-    if (!assets_file_fs)
+    if (!assets_file_writer.fs)
     {
         zfw_log_error("Failed to create or open assets file \"%s\".", assets_file_path);
-        clean_up(ZFW_FALSE, packing_instrs_file_chars, NULL, NULL, assets_file_path);
+        clean_up(ZFW_FALSE, packing_instrs_file_chars, &assets_file_writer, NULL, assets_file_path);
         return EXIT_FAILURE;
     }
 
+    const zfw_assets_file_header_t header_placeholder = {0};
+    fwrite(&header_placeholder, sizeof(header_placeholder), 1, assets_file_writer.fs);
+
     // Parse the packing instructions file contents.
     cJSON *const c_json = cJSON_Parse(packing_instrs_file_chars);
 
     if (!c_json)
     {
         zfw_log_error("cJSON failed to parse packing instructions file contents!");
-        clean_up(ZFW_FALSE, packing_instrs_file_chars, assets_file_fs, NULL, assets_file_path);
+        clean_up(ZFW_FALSE, packing_instrs_file_chars, &assets_file_writer, NULL, assets_file_path);
         return EXIT_FAILURE;
     }
 
     // Pack assets using the packing instructions file.
-    if (!pack_textures(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, assets_file_fs))
+    if (!pack_textures(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, &assets_file_writer))
     {
-        clean_up(ZFW_FALSE, packing_instrs_file_chars, assets_file_fs, c_json, assets_file_path);
+        clean_up(ZFW_FALSE, packing_instrs_file_chars, &assets_file_writer, c_json, assets_file_path);
         return EXIT_FAILURE;
     }
 
-    if (!pack_shader_progs(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, assets_file_fs))
+    if (!pack_shader_progs(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, &assets_file_writer))
     {
-        clean_up(ZFW_FALSE, packing_instrs_file_chars, assets_file_fs, c_json, assets_file_path);
+        clean_up(ZFW_FALSE, packing_instrs_file_chars, &assets_file_writer, c_json, assets_file_path);
         return EXIT_FAILURE;
     }
 
-    if (!pack_fonts(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, assets_file_fs))
+    if (!pack_fonts(c_json, src_asset_file_path_buf, src_asset_file_path_start_len, &assets_file_writer))
     {
-        clean_up(ZFW_FALSE, packing_instrs_file_chars, assets_file_fs, c_json, assets_file_path);
+        clean_up(ZFW_FALSE, packing_instrs_file_chars, &assets_file_writer, c_json, assets_file_path);
         return EXIT_FAILURE;
     }
 
-    clean_up(ZFW_TRUE, packing_instrs_file_chars, assets_file_fs, c_json, assets_file_path);
+    finish_assets_file(&assets_file_writer);
+
+    clean_up(ZFW_TRUE, packing_instrs_file_chars, &assets_file_writer, c_json, assets_file_path);
 
     return EXIT_SUCCESS;
 }
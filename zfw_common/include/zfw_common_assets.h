@@ -1,19 +1,84 @@
 #ifndef __ZFW_COMMON_ASSETS_H__
 #define __ZFW_COMMON_ASSETS_H__
 
+#include "zfw_common_math.h"
+#include "zfw_common_misc.h"
+
 #define ZFW_ASSETS_FILE_NAME "assets.zfwdat"
+#define ZFW_ASSETS_FILE_MAGIC 0x4457465A // "ZFWD" when read as bytes.
+#define ZFW_ASSETS_FILE_VERSION 3 // Must be bumped whenever the layout of any entry changes.
+#define ZFW_ASSETS_FILE_ENTRY_ALIGNMENT 16 // The alignment of the offset of each entry and of the table of contents.
+
+#define ZFW_FNV_1A_HASH_INIT 2166136261u
 
 #define ZFW_TEX_CHANNEL_COUNT 4
 
+#define ZFW_BC7_BLOCK_LEN 4 // The width and height of a BC7 block in texels.
+#define ZFW_BC7_BLOCK_TEXEL_COUNT (ZFW_BC7_BLOCK_LEN * ZFW_BC7_BLOCK_LEN)
+#define ZFW_BC7_BLOCK_BYTE_COUNT 16
+
 #define ZFW_SHADER_SRC_BUF_SIZE 2048
 
-#define ZFW_FONT_CHAR_RANGE_BEGIN 32
-#define ZFW_FONT_CHAR_RANGE_SIZE 95
+#define ZFW_FONT_CHAR_LIMIT (1 << 16) // The number of characters a font can have, such that two character indexes fit in a kerning pair key.
+#define ZFW_FONT_CODEPOINT_MAX 0x10FFFF
 #define ZFW_FONT_TEX_CHANNEL_COUNT 4
 
+typedef enum
+{
+    ZFW_TEX_FORMAT__RGBA8,
+    ZFW_TEX_FORMAT__BC7,
+
+    ZFW_TEX_FORMAT_COUNT
+} zfw_tex_format_t;
+
+typedef enum
+{
+    ZFW_ASSET_TYPE__TEX, // The size, format and data of a single texture. Texture indexes follow the order of these entries.
+    ZFW_ASSET_TYPE__ATLAS_TEX_LOOKUP, // The texture index and source rectangle of every atlas texture.
+    ZFW_ASSET_TYPE__SHADER_PROG, // The vertex and fragment shader sources of a single shader program.
+    ZFW_ASSET_TYPE__FONT_METRICS, // The character metrics of every font, stored together so they can be indexed by font.
+    ZFW_ASSET_TYPE__FONT_TEX, // The pixel data of a single font texture.
+
+    ZFW_ASSET_TYPE_COUNT
+} zfw_asset_type_t;
+
+// The assets file begins with this header. The table of contents it points to has an entry for each asset, giving the
+// location of its data in the file.
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    int entry_count;
+    int toc_offs;
+} zfw_assets_file_header_t;
+
+typedef struct
+{
+    int type; // A zfw_asset_type_t value.
+    unsigned int name_hash; // The FNV-1a hash of the name of the asset, used to find it without parsing anything else.
+    int offs; // The offset of the data of the entry from the start of the file.
+    int size;
+    unsigned int checksum; // The FNV-1a hash of the data of the entry.
+} zfw_assets_file_entry_t;
+
 typedef char font_char_hor_offs_t;
 typedef short font_char_vert_offs_t;
 typedef short font_char_hor_advance_t;
 typedef short font_char_kerning_t;
 
+// The kerning between two characters of a font. The key holds the index of the left character within the font in its
+// high 16 bits and that of the right character in its low 16 bits, and pairs are sorted by key so that they can be
+// binary searched. Only pairs with non-zero kerning are stored.
+typedef struct
+{
+    unsigned int char_indexes_key;
+    font_char_kerning_t kerning;
+} font_char_kerning_pair_t;
+
+unsigned int zfw_update_fnv_1a_hash(const unsigned int hash, const void *const data, const int size);
+unsigned int zfw_get_asset_name_hash(const char *const name);
+int zfw_get_tex_data_size(const zfw_vec_2d_i_t tex_size, const zfw_tex_format_t tex_format);
+void zfw_encode_bc7(unsigned char *const blocks, const unsigned char *const px_data, const zfw_vec_2d_i_t tex_size, const int px_data_row_len);
+void zfw_decode_bc7(unsigned char *const px_data, const unsigned char *const blocks, const zfw_vec_2d_i_t tex_size);
+
 #endif
@@ -5,6 +5,10 @@
 #include "zfw_common_misc.h"
 #include "zfw_common_mem.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 typedef unsigned char zfw_bits_t;
 
 typedef struct
@@ -57,4 +61,64 @@ inline zfw_bool_t zfw_is_bitset_bit_active(const zfw_bitset_t *const bitset, con
     return (bitset->bytes[bit_index / 8] & ((unsigned char)1 << (bit_index % 8))) != 0;
 }
 
+// Returns the index of the lowest active bit. The bits must not be 0.
+inline int zfw_get_index_of_lowest_active_bit_64(const unsigned long long bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    int index = 0;
+
+    while (!(bits & (1ULL << index)))
+    {
+        index++;
+    }
+
+    return index;
+#endif
+}
+
+// Returns the index of the highest active bit. The bits must not be 0.
+inline int zfw_get_index_of_highest_active_bit_64(const unsigned long long bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(bits);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, bits);
+    return index;
+#else
+    int index = 63;
+
+    while (!(bits & (1ULL << index)))
+    {
+        index--;
+    }
+
+    return index;
+#endif
+}
+
+inline int zfw_get_active_bit_count_64(const unsigned long long bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#elif defined(_MSC_VER)
+    return (int)__popcnt64(bits);
+#else
+    int count = 0;
+
+    for (unsigned long long bits_left = bits; bits_left; bits_left &= bits_left - 1)
+    {
+        count++;
+    }
+
+    return count;
+#endif
+}
+
 #endif
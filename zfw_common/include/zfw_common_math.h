@@ -77,6 +77,7 @@ zfw_rect_f_t zfw_get_rect_fs_merged(const zfw_rect_f_t *const rects, const int r
 
 void zfw_init_identity_matrix_4x4(zfw_matrix_4x4_t *const mat);
 void zfw_init_ortho_matrix_4x4(zfw_matrix_4x4_t *const mat, const float left, const float right, const float bottom, const float top, const float near, const float far);
+void zfw_init_matrix_4x4_product(zfw_matrix_4x4_t *const mat, const zfw_matrix_4x4_t *const a, const zfw_matrix_4x4_t *const b);
 
 float zfw_get_angle_diff(const float a, const float b);
 
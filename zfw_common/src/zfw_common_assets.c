@@ -0,0 +1,337 @@
+#include "zfw_common_assets.h"
+
+#include <string.h>
+
+#define BC7_MODE_6_INDEX_BIT_COUNT 4
+#define BC7_MODE_6_ENDPOINT_BIT_COUNT 7
+#define BC7_MODE_6_FLIP_COMBO_COUNT 8 // Every combination of the green, blue and alpha axes running with or against red.
+
+static const int k_bc7_weights_4[1 << BC7_MODE_6_INDEX_BIT_COUNT] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static int interpolate_bc7_endpoints(const int endpoint_a, const int endpoint_b, const int weight)
+{
+    return (((64 - weight) * endpoint_a) + (weight * endpoint_b) + 32) >> 6;
+}
+
+static void write_bc7_block_bits(unsigned char block[ZFW_BC7_BLOCK_BYTE_COUNT], int *const bit_index, const int val, const int bit_count)
+{
+    for (int i = 0; i < bit_count; i++, (*bit_index)++)
+    {
+        if (val & (1 << i))
+        {
+            block[*bit_index / 8] |= 1 << (*bit_index % 8);
+        }
+    }
+}
+
+static int read_bc7_block_bits(const unsigned char block[ZFW_BC7_BLOCK_BYTE_COUNT], int *const bit_index, const int bit_count)
+{
+    int val = 0;
+
+    for (int i = 0; i < bit_count; i++, (*bit_index)++)
+    {
+        if (block[*bit_index / 8] & (1 << (*bit_index % 8)))
+        {
+            val |= 1 << i;
+        }
+    }
+
+    return val;
+}
+
+// Quantises an RGBA endpoint to 7 bits per channel plus a shared low bit, choosing whichever low bit gets closest. The
+// resulting endpoint is written out as 8-bit values, and the low bit is returned.
+static int quantize_bc7_mode_6_endpoint(unsigned char endpoint[ZFW_TEX_CHANNEL_COUNT], const int color[ZFW_TEX_CHANNEL_COUNT])
+{
+    int best_p_bit = 0;
+    int best_err = -1;
+
+    for (int p_bit = 0; p_bit <= 1; p_bit++)
+    {
+        int err = 0;
+        unsigned char quantized[ZFW_TEX_CHANNEL_COUNT];
+
+        for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+        {
+            int val = (color[i] - p_bit + 1) / 2;
+            val = val < 0 ? 0 : (val > 127 ? 127 : val);
+
+            quantized[i] = (val << 1) | p_bit;
+
+            const int diff = quantized[i] - color[i];
+            err += diff * diff;
+        }
+
+        if (best_err == -1 || err < best_err)
+        {
+            best_err = err;
+            best_p_bit = p_bit;
+            memcpy(endpoint, quantized, sizeof(quantized));
+        }
+    }
+
+    return best_p_bit;
+}
+
+// Picks the palette index for each texel by projecting it onto the endpoint line, and returns the total squared error.
+static int calc_bc7_mode_6_indexes(int indexes[ZFW_BC7_BLOCK_TEXEL_COUNT], const unsigned char texels[ZFW_BC7_BLOCK_TEXEL_COUNT][ZFW_TEX_CHANNEL_COUNT], const unsigned char endpoints[2][ZFW_TEX_CHANNEL_COUNT])
+{
+    int dir[ZFW_TEX_CHANNEL_COUNT];
+    int dir_len_sq = 0;
+
+    for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+    {
+        dir[i] = endpoints[1][i] - endpoints[0][i];
+        dir_len_sq += dir[i] * dir[i];
+    }
+
+    int err = 0;
+
+    for (int i = 0; i < ZFW_BC7_BLOCK_TEXEL_COUNT; i++)
+    {
+        int index = 0;
+
+        if (dir_len_sq > 0)
+        {
+            int dot = 0;
+
+            for (int j = 0; j < ZFW_TEX_CHANNEL_COUNT; j++)
+            {
+                dot += (texels[i][j] - endpoints[0][j]) * dir[j];
+            }
+
+            // Find the weight nearest to the projection, scaled to the 0 to 64 weight range.
+            const float weight = (64.0f * dot) / dir_len_sq;
+
+            while (index < (1 << BC7_MODE_6_INDEX_BIT_COUNT) - 1 && weight > (k_bc7_weights_4[index] + k_bc7_weights_4[index + 1]) * 0.5f)
+            {
+                index++;
+            }
+        }
+
+        indexes[i] = index;
+
+        for (int j = 0; j < ZFW_TEX_CHANNEL_COUNT; j++)
+        {
+            const int diff = interpolate_bc7_endpoints(endpoints[0][j], endpoints[1][j], k_bc7_weights_4[index]) - texels[i][j];
+            err += diff * diff;
+        }
+    }
+
+    return err;
+}
+
+// Encodes a block as BC7 mode 6 (a single subset with 7-bit RGBA endpoints, per-endpoint low bits and 4-bit indexes),
+// with endpoints taken from whichever diagonal of the block's colour bounding box fits its texels best.
+static void encode_bc7_block(unsigned char block[ZFW_BC7_BLOCK_BYTE_COUNT], const unsigned char texels[ZFW_BC7_BLOCK_TEXEL_COUNT][ZFW_TEX_CHANNEL_COUNT])
+{
+    int color_min[ZFW_TEX_CHANNEL_COUNT] = {255, 255, 255, 255};
+    int color_max[ZFW_TEX_CHANNEL_COUNT] = {0};
+
+    for (int i = 0; i < ZFW_BC7_BLOCK_TEXEL_COUNT; i++)
+    {
+        for (int j = 0; j < ZFW_TEX_CHANNEL_COUNT; j++)
+        {
+            color_min[j] = texels[i][j] < color_min[j] ? texels[i][j] : color_min[j];
+            color_max[j] = texels[i][j] > color_max[j] ? texels[i][j] : color_max[j];
+        }
+    }
+
+    unsigned char best_endpoints[2][ZFW_TEX_CHANNEL_COUNT];
+    int best_p_bits[2];
+    int best_indexes[ZFW_BC7_BLOCK_TEXEL_COUNT];
+    int best_err = -1;
+
+    for (int i = 0; i < BC7_MODE_6_FLIP_COMBO_COUNT; i++)
+    {
+        int colors[2][ZFW_TEX_CHANNEL_COUNT];
+
+        for (int j = 0; j < ZFW_TEX_CHANNEL_COUNT; j++)
+        {
+            const zfw_bool_t flipped = j > 0 && (i & (1 << (j - 1)));
+
+            colors[0][j] = flipped ? color_max[j] : color_min[j];
+            colors[1][j] = flipped ? color_min[j] : color_max[j];
+        }
+
+        unsigned char endpoints[2][ZFW_TEX_CHANNEL_COUNT];
+        int p_bits[2];
+
+        p_bits[0] = quantize_bc7_mode_6_endpoint(endpoints[0], colors[0]);
+        p_bits[1] = quantize_bc7_mode_6_endpoint(endpoints[1], colors[1]);
+
+        int indexes[ZFW_BC7_BLOCK_TEXEL_COUNT];
+        const int err = calc_bc7_mode_6_indexes(indexes, texels, endpoints);
+
+        if (best_err == -1 || err < best_err)
+        {
+            best_err = err;
+            memcpy(best_endpoints, endpoints, sizeof(endpoints));
+            memcpy(best_p_bits, p_bits, sizeof(p_bits));
+            memcpy(best_indexes, indexes, sizeof(indexes));
+        }
+    }
+
+    // The most significant bit of the first index is implied to be 0, so swap the endpoints if it isn't.
+    if (best_indexes[0] & (1 << (BC7_MODE_6_INDEX_BIT_COUNT - 1)))
+    {
+        for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+        {
+            const unsigned char endpoint_elem = best_endpoints[0][i];
+            best_endpoints[0][i] = best_endpoints[1][i];
+            best_endpoints[1][i] = endpoint_elem;
+        }
+
+        const int p_bit = best_p_bits[0];
+        best_p_bits[0] = best_p_bits[1];
+        best_p_bits[1] = p_bit;
+
+        for (int i = 0; i < ZFW_BC7_BLOCK_TEXEL_COUNT; i++)
+        {
+            best_indexes[i] = ((1 << BC7_MODE_6_INDEX_BIT_COUNT) - 1) - best_indexes[i];
+        }
+    }
+
+    // Write the block.
+    memset(block, 0, ZFW_BC7_BLOCK_BYTE_COUNT);
+
+    int bit_index = 0;
+
+    write_bc7_block_bits(block, &bit_index, 1 << 6, 7); // Mode 6 is represented by 6 zero bits followed by a 1.
+
+    for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+    {
+        write_bc7_block_bits(block, &bit_index, best_endpoints[0][i] >> 1, BC7_MODE_6_ENDPOINT_BIT_COUNT);
+        write_bc7_block_bits(block, &bit_index, best_endpoints[1][i] >> 1, BC7_MODE_6_ENDPOINT_BIT_COUNT);
+    }
+
+    write_bc7_block_bits(block, &bit_index, best_p_bits[0], 1);
+    write_bc7_block_bits(block, &bit_index, best_p_bits[1], 1);
+
+    for (int i = 0; i < ZFW_BC7_BLOCK_TEXEL_COUNT; i++)
+    {
+        write_bc7_block_bits(block, &bit_index, best_indexes[i], i == 0 ? BC7_MODE_6_INDEX_BIT_COUNT - 1 : BC7_MODE_6_INDEX_BIT_COUNT);
+    }
+}
+
+static void decode_bc7_block(unsigned char texels[ZFW_BC7_BLOCK_TEXEL_COUNT][ZFW_TEX_CHANNEL_COUNT], const unsigned char block[ZFW_BC7_BLOCK_BYTE_COUNT])
+{
+    if ((block[0] & 0x7F) != (1 << 6))
+    {
+        // Only mode 6 blocks, as written by the encoder, are supported.
+        memset(texels, 0, ZFW_BC7_BLOCK_TEXEL_COUNT * ZFW_TEX_CHANNEL_COUNT);
+        return;
+    }
+
+    int bit_index = 7;
+
+    unsigned char endpoints[2][ZFW_TEX_CHANNEL_COUNT];
+
+    for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+    {
+        endpoints[0][i] = read_bc7_block_bits(block, &bit_index, BC7_MODE_6_ENDPOINT_BIT_COUNT) << 1;
+        endpoints[1][i] = read_bc7_block_bits(block, &bit_index, BC7_MODE_6_ENDPOINT_BIT_COUNT) << 1;
+    }
+
+    const int p_bits[2] = {read_bc7_block_bits(block, &bit_index, 1), read_bc7_block_bits(block, &bit_index, 1)};
+
+    for (int i = 0; i < ZFW_TEX_CHANNEL_COUNT; i++)
+    {
+        endpoints[0][i] |= p_bits[0];
+        endpoints[1][i] |= p_bits[1];
+    }
+
+    for (int i = 0; i < ZFW_BC7_BLOCK_TEXEL_COUNT; i++)
+    {
+        const int index = read_bc7_block_bits(block, &bit_index, i == 0 ? BC7_MODE_6_INDEX_BIT_COUNT - 1 : BC7_MODE_6_INDEX_BIT_COUNT);
+
+        for (int j = 0; j < ZFW_TEX_CHANNEL_COUNT; j++)
+        {
+            texels[i][j] = interpolate_bc7_endpoints(endpoints[0][j], endpoints[1][j], k_bc7_weights_4[index]);
+        }
+    }
+}
+
+unsigned int zfw_update_fnv_1a_hash(const unsigned int hash, const void *const data, const int size)
+{
+    const unsigned char *const bytes = data;
+    unsigned int hash_new = hash;
+
+    for (int i = 0; i < size; i++)
+    {
+        hash_new ^= bytes[i];
+        hash_new *= 16777619u;
+    }
+
+    return hash_new;
+}
+
+unsigned int zfw_get_asset_name_hash(const char *const name)
+{
+    return zfw_update_fnv_1a_hash(ZFW_FNV_1A_HASH_INIT, name, strlen(name));
+}
+
+int zfw_get_tex_data_size(const zfw_vec_2d_i_t tex_size, const zfw_tex_format_t tex_format)
+{
+    switch (tex_format)
+    {
+        case ZFW_TEX_FORMAT__BC7:
+            return ((tex_size.x + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN) * ((tex_size.y + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN) * ZFW_BC7_BLOCK_BYTE_COUNT;
+
+        default:
+            return tex_size.x * tex_size.y * ZFW_TEX_CHANNEL_COUNT;
+    }
+}
+
+void zfw_encode_bc7(unsigned char *const blocks, const unsigned char *const px_data, const zfw_vec_2d_i_t tex_size, const int px_data_row_len)
+{
+    const int block_cols = (tex_size.x + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN;
+    const int block_rows = (tex_size.y + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN;
+
+    for (int by = 0; by < block_rows; by++)
+    {
+        for (int bx = 0; bx < block_cols; bx++)
+        {
+            // Gather the texels of the block, repeating edge texels where the block overhangs the texture.
+            unsigned char texels[ZFW_BC7_BLOCK_TEXEL_COUNT][ZFW_TEX_CHANNEL_COUNT];
+
+            for (int y = 0; y < ZFW_BC7_BLOCK_LEN; y++)
+            {
+                const int px_y = ZFW_MIN((by * ZFW_BC7_BLOCK_LEN) + y, tex_size.y - 1);
+
+                for (int x = 0; x < ZFW_BC7_BLOCK_LEN; x++)
+                {
+                    const int px_x = ZFW_MIN((bx * ZFW_BC7_BLOCK_LEN) + x, tex_size.x - 1);
+                    memcpy(texels[(y * ZFW_BC7_BLOCK_LEN) + x], px_data + (((px_y * px_data_row_len) + px_x) * ZFW_TEX_CHANNEL_COUNT), ZFW_TEX_CHANNEL_COUNT);
+                }
+            }
+
+            encode_bc7_block(blocks + (((by * block_cols) + bx) * ZFW_BC7_BLOCK_BYTE_COUNT), texels);
+        }
+    }
+}
+
+void zfw_decode_bc7(unsigned char *const px_data, const unsigned char *const blocks, const zfw_vec_2d_i_t tex_size)
+{
+    const int block_cols = (tex_size.x + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN;
+    const int block_rows = (tex_size.y + ZFW_BC7_BLOCK_LEN - 1) / ZFW_BC7_BLOCK_LEN;
+
+    for (int by = 0; by < block_rows; by++)
+    {
+        for (int bx = 0; bx < block_cols; bx++)
+        {
+            unsigned char texels[ZFW_BC7_BLOCK_TEXEL_COUNT][ZFW_TEX_CHANNEL_COUNT];
+            decode_bc7_block(texels, blocks + (((by * block_cols) + bx) * ZFW_BC7_BLOCK_BYTE_COUNT));
+
+            // Write back only the texels that lie within the texture.
+            for (int y = 0; y < ZFW_BC7_BLOCK_LEN && (by * ZFW_BC7_BLOCK_LEN) + y < tex_size.y; y++)
+            {
+                for (int x = 0; x < ZFW_BC7_BLOCK_LEN && (bx * ZFW_BC7_BLOCK_LEN) + x < tex_size.x; x++)
+                {
+                    const int px_data_index = ((((by * ZFW_BC7_BLOCK_LEN) + y) * tex_size.x) + (bx * ZFW_BC7_BLOCK_LEN) + x) * ZFW_TEX_CHANNEL_COUNT;
+                    memcpy(px_data + px_data_index, texels[(y * ZFW_BC7_BLOCK_LEN) + x], ZFW_TEX_CHANNEL_COUNT);
+                }
+            }
+        }
+    }
+}
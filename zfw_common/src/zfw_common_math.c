@@ -226,3 +226,20 @@ void zfw_init_ortho_matrix_4x4(zfw_matrix_4x4_t *const mat, const float left, co
     mat->elems[3][2] = -(far + near) / (far - near);
     mat->elems[3][3] = 1.0f;
 }
+
+void zfw_init_matrix_4x4_product(zfw_matrix_4x4_t *const mat, const zfw_matrix_4x4_t *const a, const zfw_matrix_4x4_t *const b)
+{
+    // Matrices are column-major, so each element is indexed by column then row.
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            mat->elems[i][j] = 0.0f;
+
+            for (int k = 0; k < 4; k++)
+            {
+                mat->elems[i][j] += a->elems[k][j] * b->elems[i][k];
+            }
+        }
+    }
+}
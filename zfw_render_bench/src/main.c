@@ -0,0 +1,645 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GLFW/glfw3.h>
+#include <zfw_game.h>
+#include <zfw_common_misc.h>
+#include <zfw_common_mem.h>
+#include <zfw_common_debug.h>
+
+#define WINDOW_TITLE "zfw_render_bench"
+#define WINDOW_SIZE_DEFAULT 256 // The window is never shown, since frames are drawn to an offscreen framebuffer.
+
+typedef struct
+{
+    zfw_mem_arena_t main_mem_arena;
+
+    GLFWwindow *glfw_window;
+
+    zfw_assets_file_mapping_t assets_file_mapping;
+    zfw_user_tex_data_t user_tex_data;
+    zfw_user_shader_prog_data_t user_shader_prog_data;
+    zfw_user_font_data_t user_font_data;
+    zfw_builtin_shader_prog_data_t builtin_shader_prog_data;
+
+    zfw_render_context_t render_context;
+
+    zfw_sprite_batch_group_t sprite_batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT];
+    zfw_char_batch_group_t char_batch_group;
+    zfw_sprite_queue_t sprite_queue;
+    zfw_view_state_t view_state;
+
+    zfw_profiler_t profiler;
+
+    zfw_offscreen_target_t offscreen_target; // This is regenerated whenever the captured window size changes.
+} bench_t;
+
+// Flags for which parts of the bench have been initialised and so need cleaning.
+typedef struct
+{
+    zfw_bool_t main_mem_arena;
+    zfw_bool_t glfw;
+    zfw_bool_t assets_file_mapping;
+    zfw_bool_t user_asset_data;
+    zfw_bool_t builtin_shader_progs;
+    int sprite_batch_group_count;
+    zfw_bool_t char_batch_group;
+    zfw_bool_t sprite_queue;
+    zfw_bool_t profiler;
+} bench_init_state_t;
+
+typedef struct
+{
+    double total;
+    double min;
+    double max;
+    double median;
+    double p95;
+} frame_time_stats_t;
+
+static void clean_bench(bench_t *const bench, const bench_init_state_t *const init_state)
+{
+    zfw_clean_offscreen_target(&bench->offscreen_target);
+
+    if (init_state->profiler)
+    {
+        zfw_clean_profiler(&bench->profiler);
+    }
+
+    if (init_state->sprite_queue)
+    {
+        zfw_clean_sprite_queue(&bench->sprite_queue);
+    }
+
+    if (init_state->char_batch_group)
+    {
+        zfw_clean_char_batch_group(&bench->char_batch_group);
+    }
+
+    for (int i = 0; i < init_state->sprite_batch_group_count; i++)
+    {
+        zfw_clean_sprite_batch_group(&bench->sprite_batch_groups[i]);
+    }
+
+    if (init_state->builtin_shader_progs)
+    {
+        glDeleteProgram(bench->builtin_shader_prog_data.char_quad_sdf_prog_gl_id);
+        glDeleteProgram(bench->builtin_shader_prog_data.char_quad_prog_gl_id);
+        glDeleteProgram(bench->builtin_shader_prog_data.sprite_quad_prog_gl_id);
+    }
+
+    if (init_state->user_asset_data)
+    {
+        if (bench->user_font_data.font_count)
+        {
+            glDeleteTextures(bench->user_font_data.font_count, bench->user_font_data.tex_gl_ids);
+        }
+
+        for (int i = 0; i < bench->user_shader_prog_data.prog_count; i++)
+        {
+            glDeleteProgram(bench->user_shader_prog_data.gl_ids[i]);
+        }
+
+        if (bench->user_tex_data.tex_count && bench->user_tex_data.gl_ids)
+        {
+            glDeleteTextures(bench->user_tex_data.tex_count, bench->user_tex_data.gl_ids);
+        }
+
+        if (bench->user_tex_data.array_gl_id)
+        {
+            glDeleteTextures(1, &bench->user_tex_data.array_gl_id);
+        }
+    }
+
+    if (init_state->assets_file_mapping)
+    {
+        zfw_unmap_assets_file(&bench->assets_file_mapping);
+    }
+
+    if (init_state->glfw)
+    {
+        if (bench->glfw_window)
+        {
+            glfwDestroyWindow(bench->glfw_window);
+        }
+
+        glfwTerminate();
+    }
+
+    if (init_state->main_mem_arena)
+    {
+        zfw_clean_mem_arena(&bench->main_mem_arena);
+    }
+}
+
+// Sets everything up in the same way as zfw_run_game(), except that the window is never shown.
+static zfw_bool_t init_bench(bench_t *const bench, bench_init_state_t *const init_state, const char *const assets_file_name, const zfw_bool_t tex_array)
+{
+    if (!zfw_init_mem_arena(&bench->main_mem_arena, ZFW_MAIN_MEM_ARENA_SIZE))
+    {
+        zfw_log_error("Failed to initialize the main memory arena! (Size: %d bytes)", ZFW_MAIN_MEM_ARENA_SIZE);
+        return ZFW_FALSE;
+    }
+
+    init_state->main_mem_arena = ZFW_TRUE;
+
+    if (!glfwInit())
+    {
+        zfw_log_error("Failed to initialize GLFW!");
+        return ZFW_FALSE;
+    }
+
+    init_state->glfw = ZFW_TRUE;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    bench->glfw_window = glfwCreateWindow(WINDOW_SIZE_DEFAULT, WINDOW_SIZE_DEFAULT, WINDOW_TITLE, NULL, NULL);
+
+    if (!bench->glfw_window)
+    {
+        zfw_log_error("Failed to create a GLFW window!");
+        return ZFW_FALSE;
+    }
+
+    glfwMakeContextCurrent(bench->glfw_window);
+
+    // Don't let the swap interval throttle anything.
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        zfw_log_error("Failed to initialize OpenGL function pointers!");
+        return ZFW_FALSE;
+    }
+
+    zfw_log("Renderer: %s", glGetString(GL_RENDERER));
+
+    if (!zfw_map_assets_file(&bench->assets_file_mapping, assets_file_name))
+    {
+        zfw_log_error("Failed to map assets file \"%s\"!", assets_file_name);
+        return ZFW_FALSE;
+    }
+
+    init_state->assets_file_mapping = ZFW_TRUE;
+
+    if (!zfw_retrieve_user_asset_data_from_assets_file(&bench->user_tex_data, &bench->user_shader_prog_data, &bench->user_font_data, &bench->assets_file_mapping, tex_array, &bench->main_mem_arena))
+    {
+        return ZFW_FALSE;
+    }
+
+    init_state->user_asset_data = ZFW_TRUE;
+
+    zfw_gen_shader_prog(&bench->builtin_shader_prog_data.sprite_quad_prog_gl_id, ZFW_BUILTIN_SPRITE_QUAD_VERT_SHADER_SRC, bench->user_tex_data.array_gl_id ? ZFW_BUILTIN_SPRITE_QUAD_TEX_ARRAY_FRAG_SHADER_SRC : ZFW_BUILTIN_SPRITE_QUAD_FRAG_SHADER_SRC);
+    zfw_gen_shader_prog(&bench->builtin_shader_prog_data.char_quad_prog_gl_id, ZFW_BUILTIN_CHAR_QUAD_VERT_SHADER_SRC, ZFW_BUILTIN_CHAR_QUAD_FRAG_SHADER_SRC);
+    zfw_gen_shader_prog(&bench->builtin_shader_prog_data.char_quad_sdf_prog_gl_id, ZFW_BUILTIN_CHAR_QUAD_VERT_SHADER_SRC, ZFW_BUILTIN_CHAR_QUAD_SDF_FRAG_SHADER_SRC);
+
+    init_state->builtin_shader_progs = ZFW_TRUE;
+
+    if (!zfw_init_render_context(&bench->render_context, &bench->builtin_shader_prog_data, &bench->user_shader_prog_data, &bench->main_mem_arena))
+    {
+        zfw_log_error("Failed to initialize the render context!");
+        return ZFW_FALSE;
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
+    {
+        if (!zfw_init_sprite_batch_group(&bench->sprite_batch_groups[i], &bench->render_context, &bench->user_tex_data, &bench->main_mem_arena))
+        {
+            zfw_log_error("Failed to initialize a sprite batch group!");
+            return ZFW_FALSE;
+        }
+
+        init_state->sprite_batch_group_count++;
+
+        zfw_set_sprite_batch_group_defaults(&bench->sprite_batch_groups[i]);
+    }
+
+    if (!zfw_init_char_batch_group(&bench->char_batch_group, &bench->main_mem_arena))
+    {
+        zfw_log_error("Failed to initialize the character batch group!");
+        return ZFW_FALSE;
+    }
+
+    init_state->char_batch_group = ZFW_TRUE;
+
+    zfw_set_char_batch_group_defaults(&bench->char_batch_group);
+
+    if (!zfw_init_sprite_queue(&bench->sprite_queue, &bench->user_tex_data, &bench->user_shader_prog_data))
+    {
+        zfw_log_error("Failed to initialize the sprite queue!");
+        return ZFW_FALSE;
+    }
+
+    init_state->sprite_queue = ZFW_TRUE;
+
+    zfw_set_view_state_defaults(&bench->view_state);
+
+    zfw_init_profiler(&bench->profiler, ZFW_TRUE);
+    init_state->profiler = ZFW_TRUE;
+
+    return ZFW_TRUE;
+}
+
+static zfw_bool_t bind_bench_offscreen_target(bench_t *const bench, const zfw_vec_2d_i_t size)
+{
+    if (!bench->offscreen_target.fb_gl_id || bench->offscreen_target.size.x != size.x || bench->offscreen_target.size.y != size.y)
+    {
+        zfw_clean_offscreen_target(&bench->offscreen_target);
+
+        if (!zfw_init_offscreen_target(&bench->offscreen_target, size))
+        {
+            return ZFW_FALSE;
+        }
+    }
+
+    zfw_bind_offscreen_target(&bench->offscreen_target);
+
+    return ZFW_TRUE;
+}
+
+// Reads the next command of the capture file into the payload buffer, growing it if needed. Returns ZFW_FALSE at the
+// end of the file or on failure.
+static zfw_bool_t read_capture_cmd(FILE *const fs, zfw_render_capture_cmd_header_t *const cmd_header, unsigned char **const payload_buf, int *const payload_buf_size)
+{
+    if (fread(cmd_header, sizeof(*cmd_header), 1, fs) != 1)
+    {
+        return ZFW_FALSE;
+    }
+
+    if (cmd_header->size < 0)
+    {
+        zfw_log_error("Encountered a render capture command with an invalid payload size of %d!", cmd_header->size);
+        return ZFW_FALSE;
+    }
+
+    if (cmd_header->size > *payload_buf_size)
+    {
+        unsigned char *const payload_buf_new = realloc(*payload_buf, cmd_header->size);
+
+        if (!payload_buf_new)
+        {
+            zfw_log_error("Failed to allocate %d bytes for a render capture command payload!", cmd_header->size);
+            return ZFW_FALSE;
+        }
+
+        *payload_buf = payload_buf_new;
+        *payload_buf_size = cmd_header->size;
+    }
+
+    if (cmd_header->size && fread(*payload_buf, cmd_header->size, 1, fs) != 1)
+    {
+        zfw_log_error("The render capture file ended partway through a command!");
+        return ZFW_FALSE;
+    }
+
+    return ZFW_TRUE;
+}
+
+// Replays a non-render command. Returns ZFW_FALSE if the command type is unknown.
+static zfw_bool_t replay_capture_cmd(bench_t *const bench, const zfw_render_capture_cmd_type_t cmd_type, const unsigned char *const payload)
+{
+    switch (cmd_type)
+    {
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_SPRITE_BATCH_SLOT:
+            {
+                const zfw_render_capture_take_sprite_batch_slot_cmd_t *const cmd = (const zfw_render_capture_take_sprite_batch_slot_cmd_t *)payload;
+                zfw_take_render_layer_sprite_batch_slot(cmd->batch_group_id, cmd->layer_index, cmd->user_tex_index, bench->sprite_batch_groups);
+            }
+
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_MULTIPLE_SPRITE_BATCH_SLOTS:
+            {
+                const zfw_render_capture_take_sprite_batch_slot_cmd_t *const cmd = (const zfw_render_capture_take_sprite_batch_slot_cmd_t *)payload;
+
+                // The keys don't need to be kept, since later commands carry them.
+                zfw_sprite_batch_slot_key_t *const slot_keys = malloc(sizeof(*slot_keys) * ZFW_MAX(cmd->slot_key_count, 1));
+
+                if (!slot_keys)
+                {
+                    zfw_log_error("Failed to allocate %d bytes for sprite batch slot keys!", sizeof(*slot_keys) * cmd->slot_key_count);
+                    break;
+                }
+
+                zfw_take_multiple_render_layer_sprite_batch_slots(slot_keys, cmd->slot_key_count, cmd->batch_group_id, cmd->layer_index, cmd->user_tex_index, bench->sprite_batch_groups);
+
+                free(slot_keys);
+            }
+
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOT:
+            {
+                const zfw_render_capture_write_sprite_batch_slot_cmd_t *const cmd = (const zfw_render_capture_write_sprite_batch_slot_cmd_t *)payload;
+                zfw_write_to_render_layer_sprite_batch_slot(cmd->slot_key, cmd->pos, cmd->rot, cmd->scale, cmd->origin, &cmd->src_rect, &cmd->blend, bench->sprite_batch_groups, &bench->user_tex_data);
+            }
+
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_SPRITE_BATCH_SLOTS_BULK:
+            {
+                const zfw_render_capture_write_sprite_batch_slots_bulk_cmd_t *const cmd = (const zfw_render_capture_write_sprite_batch_slots_bulk_cmd_t *)payload;
+                const int count = cmd->slot_key_count;
+
+                // Work out where each array is in the trailing data.
+                const unsigned char *data = payload + sizeof(*cmd);
+
+                const zfw_sprite_batch_slot_key_t *const slot_keys = (const zfw_sprite_batch_slot_key_t *)data;
+                data += sizeof(*slot_keys) * count;
+
+                const zfw_vec_2d_t *const positions = (const zfw_vec_2d_t *)data;
+                data += sizeof(*positions) * count;
+
+                const float *const rots = cmd->rotated ? (const float *)data : NULL;
+                data += cmd->rotated ? sizeof(*rots) * count : 0;
+
+                const zfw_vec_2d_t *const scales = (const zfw_vec_2d_t *)data;
+                data += sizeof(*scales) * count;
+
+                const zfw_rect_t *const src_rects = (const zfw_rect_t *)data;
+                data += sizeof(*src_rects) * count;
+
+                const zfw_color_t *const blends = (const zfw_color_t *)data;
+
+                zfw_write_sprite_batch_slots_bulk(slot_keys, count, positions, rots, scales, cmd->origin, src_rects, blends, bench->sprite_batch_groups, &bench->user_tex_data);
+            }
+
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_SPRITE_BATCH_SLOT:
+            zfw_clear_render_layer_sprite_batch_slot(((const zfw_render_capture_sprite_batch_slot_cmd_t *)payload)->slot_key, bench->sprite_batch_groups);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_SPRITE_BATCH_SLOT:
+            zfw_free_render_layer_sprite_batch_slot(((const zfw_render_capture_sprite_batch_slot_cmd_t *)payload)->slot_key, bench->sprite_batch_groups);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__TAKE_CHAR_BATCH:
+            zfw_take_render_layer_char_batch(((const zfw_render_capture_take_char_batch_cmd_t *)payload)->layer_index, &bench->char_batch_group);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__WRITE_CHAR_BATCH:
+            {
+                const zfw_render_capture_write_char_batch_cmd_t *const cmd = (const zfw_render_capture_write_char_batch_cmd_t *)payload;
+                const char *const text = (const char *)(payload + sizeof(*cmd));
+                zfw_write_to_render_layer_char_batch(cmd->key, text, cmd->hor_align, cmd->vert_align, &bench->char_batch_group, &bench->user_font_data);
+            }
+
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__CLEAR_CHAR_BATCH:
+            zfw_clear_render_layer_char_batch(((const zfw_render_capture_char_batch_cmd_t *)payload)->key, &bench->char_batch_group);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__FREE_CHAR_BATCH:
+            zfw_free_render_layer_char_batch(((const zfw_render_capture_char_batch_cmd_t *)payload)->key, &bench->char_batch_group);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__RESET_SPRITE_QUEUE:
+            zfw_reset_sprite_queue(&bench->sprite_queue);
+            break;
+
+        case ZFW_RENDER_CAPTURE_CMD_TYPE__SUBMIT_SPRITE:
+            {
+                const zfw_render_capture_submit_sprite_cmd_t *const cmd = (const zfw_render_capture_submit_sprite_cmd_t *)payload;
+                zfw_submit_sprite(&bench->sprite_queue, cmd->batch_group_id, cmd->layer_index, cmd->depth, cmd->user_tex_index, cmd->user_shader_prog_index, cmd->pos, cmd->rot, cmd->scale, cmd->origin, &cmd->src_rect, &cmd->blend, &bench->user_tex_data);
+            }
+
+            break;
+
+        default:
+            return ZFW_FALSE;
+    }
+
+    return ZFW_TRUE;
+}
+
+// Replays a render command as zfw_run_game() would render a frame, returning the time taken for the GPU to finish it,
+// or a negative value on failure.
+static double replay_capture_render_cmd(bench_t *const bench, const zfw_render_capture_render_cmd_t *const cmd, const zfw_render_capture_char_batch_props_t *const char_batch_props)
+{
+    for (int i = 0; i < cmd->char_batch_count; i++)
+    {
+        const zfw_render_capture_char_batch_props_t *const props = &char_batch_props[i];
+        zfw_set_render_layer_char_batch_user_font_index(props->key, props->user_font_index, &bench->char_batch_group);
+        zfw_set_render_layer_char_batch_pos(props->key, props->pos, &bench->char_batch_group);
+        zfw_set_render_layer_char_batch_scale(props->key, props->scale, &bench->char_batch_group);
+        zfw_set_render_layer_char_batch_blend(props->key, &props->blend, &bench->char_batch_group);
+    }
+
+    bench->view_state = cmd->view_state;
+
+    if (!bind_bench_offscreen_target(bench, cmd->window_size))
+    {
+        return -1.0;
+    }
+
+    // Make sure nothing from before is still in flight, so that only this frame is timed.
+    glFinish();
+
+    const double time_begin = glfwGetTime();
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    zfw_prepare_sprite_queue(&bench->sprite_queue, &bench->profiler.frame.counters);
+    zfw_prepare_char_batch_group(&bench->char_batch_group, &bench->profiler.frame.counters);
+    zfw_render_sprite_and_character_batches(bench->sprite_batch_groups, &bench->char_batch_group, &bench->sprite_queue, &bench->view_state, cmd->window_size, &bench->user_tex_data, &bench->user_shader_prog_data, &bench->user_font_data, &bench->builtin_shader_prog_data, &bench->render_context, &bench->profiler);
+
+    glFinish();
+
+    const double time = glfwGetTime() - time_begin;
+
+    zfw_end_profiler_frame(&bench->profiler);
+
+    for (int i = 0; i < ZFW_SPRITE_BATCH_GROUP_COUNT; i++)
+    {
+        zfw_release_idle_sprite_batches(&bench->sprite_batch_groups[i]);
+    }
+
+    zfw_release_idle_char_batches(&bench->char_batch_group);
+
+    return time;
+}
+
+static int compare_frame_times(const void *const a, const void *const b)
+{
+    const double time_a = *(const double *)a;
+    const double time_b = *(const double *)b;
+    return (time_a > time_b) - (time_a < time_b);
+}
+
+static frame_time_stats_t calc_frame_time_stats(double *const frame_times, const int frame_count)
+{
+    frame_time_stats_t stats = {0};
+
+    qsort(frame_times, frame_count, sizeof(*frame_times), compare_frame_times);
+
+    for (int i = 0; i < frame_count; i++)
+    {
+        stats.total += frame_times[i];
+    }
+
+    stats.min = frame_times[0];
+    stats.max = frame_times[frame_count - 1];
+    stats.median = frame_times[frame_count / 2];
+    stats.p95 = frame_times[ZFW_MIN((frame_count * 95) / 100, frame_count - 1)];
+
+    return stats;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!zfw_check_data_type_sizes())
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (argc != 2 && argc != 3)
+    {
+        zfw_log_error("Invalid number of command-line arguments! Expected a render capture file and optionally an assets file (\"%s\" by default) to be provided.", ZFW_ASSETS_FILE_NAME);
+        return EXIT_FAILURE;
+    }
+
+    const char *const capture_file_name = argv[1];
+    const char *const assets_file_name = argc == 3 ? argv[2] : ZFW_ASSETS_FILE_NAME;
+
+    // Open the capture file and check its header.
+    FILE *const capture_fs = fopen(capture_file_name, "rb");
+
+    if (!capture_fs)
+    {
+        zfw_log_error("Failed to open render capture file \"%s\"!", capture_file_name);
+        return EXIT_FAILURE;
+    }
+
+    zfw_render_capture_file_header_t capture_header;
+
+    if (fread(&capture_header, sizeof(capture_header), 1, capture_fs) != 1 || capture_header.magic != ZFW_RENDER_CAPTURE_FILE_MAGIC)
+    {
+        zfw_log_error("\"%s\" is not a render capture file!", capture_file_name);
+        fclose(capture_fs);
+        return EXIT_FAILURE;
+    }
+
+    if (capture_header.version != ZFW_RENDER_CAPTURE_FILE_VERSION)
+    {
+        zfw_log_error("Render capture file \"%s\" has version %d, but version %d is expected!", capture_file_name, capture_header.version, ZFW_RENDER_CAPTURE_FILE_VERSION);
+        fclose(capture_fs);
+        return EXIT_FAILURE;
+    }
+
+    if (capture_header.frame_count <= 0)
+    {
+        zfw_log_error("Render capture file \"%s\" has no frames!", capture_file_name);
+        fclose(capture_fs);
+        return EXIT_FAILURE;
+    }
+
+    double *const frame_times = malloc(sizeof(*frame_times) * capture_header.frame_count);
+    double *const gpu_frame_times = malloc(sizeof(*gpu_frame_times) * capture_header.frame_count);
+
+    if (!frame_times || !gpu_frame_times)
+    {
+        zfw_log_error("Failed to allocate %d bytes for frame times!", sizeof(*frame_times) * capture_header.frame_count * 2);
+        free(frame_times);
+        free(gpu_frame_times);
+        fclose(capture_fs);
+        return EXIT_FAILURE;
+    }
+
+    // The bench state is too large for the stack.
+    bench_t *const bench = calloc(1, sizeof(*bench));
+    bench_init_state_t init_state = {0};
+
+    if (!bench || !init_bench(bench, &init_state, assets_file_name, capture_header.tex_array))
+    {
+        if (bench)
+        {
+            clean_bench(bench, &init_state);
+            free(bench);
+        }
+
+        free(frame_times);
+        free(gpu_frame_times);
+        fclose(capture_fs);
+        return EXIT_FAILURE;
+    }
+
+    // Replay the capture.
+    zfw_log("Replaying %d frames from \"%s\"...", capture_header.frame_count, capture_file_name);
+
+    unsigned char *payload_buf = NULL;
+    int payload_buf_size = 0;
+
+    zfw_render_capture_cmd_header_t cmd_header;
+    int frame_index = 0;
+    long long draw_call_total = 0;
+    long long buf_upload_size_total = 0;
+
+    while (frame_index < capture_header.frame_count && read_capture_cmd(capture_fs, &cmd_header, &payload_buf, &payload_buf_size))
+    {
+        if (cmd_header.type == ZFW_RENDER_CAPTURE_CMD_TYPE__RENDER)
+        {
+            const zfw_render_capture_render_cmd_t *const cmd = (const zfw_render_capture_render_cmd_t *)payload_buf;
+            frame_times[frame_index] = replay_capture_render_cmd(bench, cmd, (const zfw_render_capture_char_batch_props_t *)(payload_buf + sizeof(*cmd)));
+
+            if (frame_times[frame_index] < 0.0)
+            {
+                break;
+            }
+
+            // GPU times are read back a few frames late, so this is the total of an earlier frame.
+            gpu_frame_times[frame_index] = 0.0;
+
+            for (int i = 0; i < ZFW_RENDER_GPU_TIMER_COUNT; i++)
+            {
+                gpu_frame_times[frame_index] += bench->profiler.last_frame.gpu_timer_times[i];
+            }
+
+            draw_call_total += bench->profiler.last_frame.counters.draw_call_count;
+            buf_upload_size_total += bench->profiler.last_frame.counters.buf_upload_size;
+
+            frame_index++;
+        }
+        else if (!replay_capture_cmd(bench, cmd_header.type, payload_buf))
+        {
+            zfw_log_warning("Skipping a render capture command of unknown type %d.", cmd_header.type);
+        }
+    }
+
+    free(payload_buf);
+    fclose(capture_fs);
+
+    // Report the results.
+    if (frame_index > 0)
+    {
+        const frame_time_stats_t stats = calc_frame_time_stats(frame_times, frame_index);
+        const frame_time_stats_t gpu_stats = calc_frame_time_stats(gpu_frame_times, frame_index);
+
+        printf("Frames: %d\n", frame_index);
+        printf("Frame time (ms): mean %.3f, median %.3f, p95 %.3f, min %.3f, max %.3f\n", (stats.total / frame_index) * 1000.0, stats.median * 1000.0, stats.p95 * 1000.0, stats.min * 1000.0, stats.max * 1000.0);
+        printf("GPU time (ms): mean %.3f, median %.3f, p95 %.3f\n", (gpu_stats.total / frame_index) * 1000.0, gpu_stats.median * 1000.0, gpu_stats.p95 * 1000.0);
+        printf("Throughput: %.1f frames per second\n", frame_index / stats.total);
+        printf("Draw calls per frame: %.1f\n", (double)draw_call_total / frame_index);
+        printf("Buffer upload bytes per frame: %.1f\n", (double)buf_upload_size_total / frame_index);
+    }
+
+    if (frame_index < capture_header.frame_count)
+    {
+        zfw_log_warning("The render capture file ended after %d of its %d frames.", frame_index, capture_header.frame_count);
+    }
+
+    clean_bench(bench, &init_state);
+    free(bench);
+    free(frame_times);
+    free(gpu_frame_times);
+
+    return frame_index > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
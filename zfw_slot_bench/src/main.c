@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <GLFW/glfw3.h>
+#include <zfw_game.h>
+#include <zfw_common_misc.h>
+#include <zfw_common_mem.h>
+#include <zfw_common_debug.h>
+
+#define ROUND_COUNT 16384
+#define ROUND_OP_COUNT 64 // Must fit in the free slots of a batch at the highest occupancy.
+
+static const int occupancy_percents[] = {0, 50, 99};
+
+_Static_assert(ZFW_SPRITE_BATCH_SLOT_LIMIT - ((ZFW_SPRITE_BATCH_SLOT_LIMIT * 99) / 100) >= ROUND_OP_COUNT, "Each round must fit in the free slots of a batch.");
+
+// A xorshift generator, so that every run frees the same slots.
+static unsigned int gen_rand(unsigned int *const state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Moves the given number of randomly chosen slot keys to the end of the array, ready to be freed.
+static void pick_slot_keys_to_free(zfw_sprite_batch_slot_key_t *const slot_keys, const int slot_key_count, const int pick_count, unsigned int *const rand_state)
+{
+    for (int i = 0; i < pick_count; i++)
+    {
+        const int src_index = gen_rand(rand_state) % (slot_key_count - i);
+        const int dest_index = slot_key_count - 1 - i;
+
+        const zfw_sprite_batch_slot_key_t slot_key = slot_keys[src_index];
+        slot_keys[src_index] = slot_keys[dest_index];
+        slot_keys[dest_index] = slot_key;
+    }
+}
+
+// Times taking and freeing slots of a single sprite batch with it held at different occupancies, to show the cost of
+// finding a free slot and of working out the live slot bound after a free. Free slots are scattered at random.
+static zfw_bool_t run_bench(zfw_sprite_batch_group_t batch_groups[ZFW_SPRITE_BATCH_GROUP_COUNT])
+{
+    zfw_sprite_batch_slot_key_t *const slot_keys = malloc(sizeof(*slot_keys) * ZFW_SPRITE_BATCH_SLOT_LIMIT);
+
+    if (!slot_keys)
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite batch slot keys!", sizeof(*slot_keys) * ZFW_SPRITE_BATCH_SLOT_LIMIT);
+        return ZFW_FALSE;
+    }
+
+    unsigned int rand_state = 1;
+
+    printf("Sprite batch slot times over %d rounds of %d takes and frees:\n", ROUND_COUNT, ROUND_OP_COUNT);
+
+    for (int i = 0; i < (int)ZFW_STATIC_ARRAY_LEN(occupancy_percents); i++)
+    {
+        // Fill the batch, then free random slots until it is down to the occupancy.
+        const int occupied_slot_count = (ZFW_SPRITE_BATCH_SLOT_LIMIT * occupancy_percents[i]) / 100;
+
+        int slot_key_count = 0;
+
+        while (slot_key_count < ZFW_SPRITE_BATCH_SLOT_LIMIT)
+        {
+            slot_keys[slot_key_count] = zfw_take_render_layer_sprite_batch_slot(ZFW_SPRITE_BATCH_GROUP_ID__VIEW, 0, 0, batch_groups);
+
+            if (!zfw_is_sprite_batch_slot_key_active(slot_keys[slot_key_count]))
+            {
+                zfw_log_error("Failed to take a sprite batch slot!");
+                free(slot_keys);
+                return ZFW_FALSE;
+            }
+
+            slot_key_count++;
+        }
+
+        pick_slot_keys_to_free(slot_keys, slot_key_count, slot_key_count - occupied_slot_count, &rand_state);
+
+        while (slot_key_count > occupied_slot_count)
+        {
+            slot_key_count--;
+            zfw_free_render_layer_sprite_batch_slot(slot_keys[slot_key_count], batch_groups);
+        }
+
+        // Each round takes slots then frees as many at random, so the occupancy stays close to that being measured.
+        double take_time = 0.0;
+        double free_time = 0.0;
+
+        for (int j = 0; j < ROUND_COUNT; j++)
+        {
+            double time_begin = glfwGetTime();
+
+            for (int k = 0; k < ROUND_OP_COUNT; k++)
+            {
+                slot_keys[slot_key_count] = zfw_take_render_layer_sprite_batch_slot(ZFW_SPRITE_BATCH_GROUP_ID__VIEW, 0, 0, batch_groups);
+                slot_key_count++;
+            }
+
+            take_time += glfwGetTime() - time_begin;
+
+            pick_slot_keys_to_free(slot_keys, slot_key_count, ROUND_OP_COUNT, &rand_state);
+
+            time_begin = glfwGetTime();
+
+            for (int k = 0; k < ROUND_OP_COUNT; k++)
+            {
+                slot_key_count--;
+                zfw_free_render_layer_sprite_batch_slot(slot_keys[slot_key_count], batch_groups);
+            }
+
+            free_time += glfwGetTime() - time_begin;
+        }
+
+        // Free the rest, so that the next occupancy starts from an empty batch.
+        while (slot_key_count > 0)
+        {
+            slot_key_count--;
+            zfw_free_render_layer_sprite_batch_slot(slot_keys[slot_key_count], batch_groups);
+        }
+
+        const int op_count = ROUND_COUNT * ROUND_OP_COUNT;
+        printf("%d%% occupancy (ns): take %.1f, free %.1f\n", occupancy_percents[i], (take_time / op_count) * 1e9, (free_time / op_count) * 1e9);
+    }
+
+    free(slot_keys);
+
+    return ZFW_TRUE;
+}
+
+int main(void)
+{
+    zfw_mem_arena_t main_mem_arena;
+
+    if (!zfw_init_mem_arena(&main_mem_arena, ZFW_MAIN_MEM_ARENA_SIZE))
+    {
+        zfw_log_error("Failed to initialize the main memory arena! (Size: %d bytes)", ZFW_MAIN_MEM_ARENA_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    // Sprite batches generate OpenGL objects, so a context is needed even though nothing is drawn.
+    if (!glfwInit())
+    {
+        zfw_log_error("Failed to initialize GLFW!");
+        zfw_clean_mem_arena(&main_mem_arena);
+        return EXIT_FAILURE;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *const glfw_window = glfwCreateWindow(1, 1, "zfw_slot_bench", NULL, NULL);
+
+    if (!glfw_window)
+    {
+        zfw_log_error("Failed to create a GLFW window!");
+        glfwTerminate();
+        zfw_clean_mem_arena(&main_mem_arena);
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(glfw_window);
+
+    zfw_bool_t success = ZFW_FALSE;
+
+    // The batch group state is too large for the stack.
+    zfw_sprite_batch_group_t *const batch_groups = calloc(ZFW_SPRITE_BATCH_GROUP_COUNT, sizeof(*batch_groups));
+    int batch_group_count = 0;
+
+    // Nothing is drawn, so there are no shader programs for the render context to look up uniforms in. Slots are taken
+    // for user texture index 0 without any texture being loaded, since textures are only bound when drawing.
+    const zfw_builtin_shader_prog_data_t builtin_shader_prog_data = {0};
+    const zfw_user_shader_prog_data_t user_shader_prog_data = {0};
+    const zfw_user_tex_data_t user_tex_data = {0};
+    zfw_render_context_t render_context;
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        zfw_log_error("Failed to initialize OpenGL function pointers!");
+    }
+    else if (!batch_groups)
+    {
+        zfw_log_error("Failed to allocate %d bytes for sprite batch groups!", sizeof(*batch_groups) * ZFW_SPRITE_BATCH_GROUP_COUNT);
+    }
+    else if (!zfw_init_render_context(&render_context, &builtin_shader_prog_data, &user_shader_prog_data, &main_mem_arena))
+    {
+        zfw_log_error("Failed to initialize the render context!");
+    }
+    else
+    {
+        while (batch_group_count < ZFW_SPRITE_BATCH_GROUP_COUNT && zfw_init_sprite_batch_group(&batch_groups[batch_group_count], &render_context, &user_tex_data, &main_mem_arena))
+        {
+            zfw_set_sprite_batch_group_defaults(&batch_groups[batch_group_count]);
+            batch_group_count++;
+        }
+
+        if (batch_group_count < ZFW_SPRITE_BATCH_GROUP_COUNT)
+        {
+            zfw_log_error("Failed to initialize a sprite batch group!");
+        }
+        else
+        {
+            success = run_bench(batch_groups);
+        }
+    }
+
+    for (int i = 0; i < batch_group_count; i++)
+    {
+        zfw_clean_sprite_batch_group(&batch_groups[i]);
+    }
+
+    free(batch_groups);
+
+    glfwDestroyWindow(glfw_window);
+    glfwTerminate();
+
+    zfw_clean_mem_arena(&main_mem_arena);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}